@@ -0,0 +1,75 @@
+#include "BackgroundSaver.h"
+
+#include <utility>
+
+#include "FileHandler.h"
+
+BackgroundSaver::BackgroundSaver()
+    : writing(false), stopping(false), worker([this]() { workerLoop(); }) {}
+
+BackgroundSaver::~BackgroundSaver() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  worker.join();
+}
+
+BackgroundSaver& BackgroundSaver::shared() {
+  static BackgroundSaver saver;
+  return saver;
+}
+
+void BackgroundSaver::submit(const std::string& path, std::string data) {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    for (Pending& pending : queue) {
+      if (pending.path == path) {
+        pending.data = std::move(data);
+        pending.coalesced++;
+        return;
+      }
+    }
+    queue.push_back({path, std::move(data), 0});
+  }
+  wake.notify_one();
+}
+
+void BackgroundSaver::flush() {
+  std::unique_lock<std::mutex> guard(lock);
+  idle.wait(guard, [this]() { return queue.empty() && !writing; });
+}
+
+std::vector<SaveCompletion> BackgroundSaver::takeFinished() {
+  std::lock_guard<std::mutex> guard(lock);
+  std::vector<SaveCompletion> taken;
+  taken.swap(finished);
+  return taken;
+}
+
+void BackgroundSaver::workerLoop() {
+  std::unique_lock<std::mutex> guard(lock);
+  while (true) {
+    wake.wait(guard, [this]() { return stopping || !queue.empty(); });
+    if (queue.empty()) {
+      // Only reached when stopping, after the queue has drained
+      return;
+    }
+    Pending pending = std::move(queue.front());
+    queue.erase(queue.begin());
+    writing = true;
+    guard.unlock();
+
+    SaveCompletion completion = {pending.path, false, "", pending.coalesced};
+    completion.ok =
+        FileHandler::writeFile(pending.path, pending.data, completion.error);
+
+    guard.lock();
+    writing = false;
+    finished.push_back(completion);
+    if (queue.empty()) {
+      idle.notify_all();
+    }
+  }
+}
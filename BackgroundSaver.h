@@ -0,0 +1,64 @@
+#ifndef ASSIGN2_BACKGROUNDSAVER_H
+#define ASSIGN2_BACKGROUNDSAVER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SaveCompletion {
+  std::string path;
+  bool ok;
+  // Why the write failed, empty when it succeeded
+  std::string error;
+  // Earlier saves of the same path replaced by this one before writing
+  int coalesced;
+};
+
+/*
+ * Writes saves on one background I/O thread so the game thread only
+ * pays for serialising. Each write goes through FileHandler::writeFile
+ * (temporary file, fsync, rename). A save of a path that is still queued
+ * replaces the queued data instead of adding a second write, so a slow
+ * disk never builds up a backlog of stale saves. Finished saves are
+ * collected with takeFinished(); destruction writes everything still
+ * queued.
+ */
+class BackgroundSaver {
+ public:
+  BackgroundSaver();
+  ~BackgroundSaver();
+
+  BackgroundSaver(const BackgroundSaver& other) = delete;
+  BackgroundSaver& operator=(const BackgroundSaver& other) = delete;
+
+  // Engine-wide saver, created on first use
+  static BackgroundSaver& shared();
+
+  void submit(const std::string& path, std::string data);
+  // Block until every save submitted so far has been written
+  void flush();
+  // Saves finished since the last call, oldest first
+  std::vector<SaveCompletion> takeFinished();
+
+ private:
+  struct Pending {
+    std::string path;
+    std::string data;
+    int coalesced;
+  };
+
+  std::mutex lock;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::vector<Pending> queue;
+  std::vector<SaveCompletion> finished;
+  bool writing;
+  bool stopping;
+  std::thread worker;
+
+  void workerLoop();
+};
+
+#endif  // ASSIGN2_BACKGROUNDSAVER_H
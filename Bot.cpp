@@ -0,0 +1,66 @@
+#include "Bot.h"
+
+#include <cstdlib>
+#include <sstream>
+
+#include "MctsBot.h"
+
+Bot::~Bot() {}
+
+RandomBot::RandomBot(uint64_t seed) : random(seed) {}
+
+Move RandomBot::chooseMove(const GameState& state) {
+  state.generateMoves(moves);
+  return moves[random.below(static_cast<unsigned int>(moves.size()))];
+}
+
+GreedyBot::GreedyBot(uint64_t seed) : random(seed) {}
+
+Move GreedyBot::chooseMove(const GameState& state) {
+  return MctsBot::greedyMove(state, moves, random);
+}
+
+Bot* createBot(const std::string& spec, uint64_t seed) {
+  size_t colon = spec.find(':');
+  std::string kind = spec.substr(0, colon);
+
+  if (kind == "random" && colon == std::string::npos) {
+    return new RandomBot(seed);
+  }
+  if (kind == "greedy" && colon == std::string::npos) {
+    return new GreedyBot(seed);
+  }
+  if (kind != "mcts") {
+    return nullptr;
+  }
+
+  MctsConfig config;
+  config.seed = seed;
+  if (colon != std::string::npos) {
+    std::stringstream options(spec.substr(colon + 1));
+    std::string option;
+    while (std::getline(options, option, ',')) {
+      size_t equals = option.find('=');
+      if (equals == std::string::npos) {
+        return nullptr;
+      }
+      std::string key = option.substr(0, equals);
+      const char* value = option.c_str() + equals + 1;
+      if (key == "iterations") {
+        config.iterations = std::atoi(value);
+      } else if (key == "time") {
+        config.timeBudgetMs = std::atoi(value);
+      } else if (key == "c") {
+        config.exploration = std::atof(value);
+      } else if (key == "widening") {
+        config.widening = std::atof(value);
+      } else {
+        return nullptr;
+      }
+    }
+  }
+  if (config.iterations == 0 && config.timeBudgetMs == 0) {
+    return nullptr;
+  }
+  return new MctsBot(config);
+}
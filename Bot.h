@@ -0,0 +1,50 @@
+#ifndef ASSIGN2_BOT_H
+#define ASSIGN2_BOT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameState.h"
+
+// Common interface for automated players
+class Bot {
+ public:
+  virtual ~Bot();
+
+  // Pick a move for the player to move in 'state'
+  virtual Move chooseMove(const GameState& state) = 0;
+};
+
+// Uniformly random legal move
+class RandomBot : public Bot {
+ public:
+  explicit RandomBot(uint64_t seed);
+  Move chooseMove(const GameState& state) override;
+
+ private:
+  FastRandom random;
+  std::vector<Move> moves;
+};
+
+// Highest scoring placement this turn
+class GreedyBot : public Bot {
+ public:
+  explicit GreedyBot(uint64_t seed);
+  Move chooseMove(const GameState& state) override;
+
+ private:
+  FastRandom random;
+  std::vector<Move> moves;
+};
+
+/*
+ * Build a bot from a configuration string:
+ *   random
+ *   greedy
+ *   mcts[:iterations=N][,time=MS][,c=X][,widening=W]
+ * Returns nullptr if the string is not understood.
+ */
+Bot* createBot(const std::string& spec, uint64_t seed);
+
+#endif  // ASSIGN2_BOT_H
@@ -0,0 +1,180 @@
+#include "BulkLoader.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "GameState.h"
+#include "ThreadPool.h"
+
+#define TEXT_SAVE_EXTENSION ".txt"
+
+namespace {
+bool endsWith(const std::string& text, const std::string& suffix) {
+  return text.size() > suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) ==
+             0;
+}
+
+bool isSaveName(const std::string& name) {
+  return endsWith(name, TEXT_SAVE_EXTENSION) ||
+         endsWith(name, BINARY_SAVE_EXTENSION);
+}
+
+void collectDirectory(const std::string& directory,
+                      std::vector<std::string>& files) {
+  DIR* dir = opendir(directory.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  while (dirent* item = readdir(dir)) {
+    std::string name = item->d_name;
+    if (name == "." || name == "..") {
+      continue;
+    }
+    std::string path = directory + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+      continue;
+    }
+    if (S_ISDIR(info.st_mode)) {
+      collectDirectory(path, files);
+    } else if (isSaveName(name)) {
+      files.push_back(path);
+    }
+  }
+  closedir(dir);
+}
+
+void countTiles(LinkedList* tiles, int* counts) {
+  for (Node* node = tiles->getHead(); node != nullptr;
+       node = node->getNext()) {
+    Tile* tile = node->getTile();
+    TileCode code = GameState::encodeTile(tile->getColour(), tile->getShape());
+    if (code != EMPTY_CELL) {
+      counts[code - 1]++;
+    }
+  }
+}
+
+// Empty if the loaded game could have been reached in play
+std::string checkGame(Player* player1, Player* player2, TileBag* tileBag,
+                      GameBoard* board, Player* currentPlayer) {
+  if (currentPlayer->getName() != player1->getName() &&
+      currentPlayer->getName() != player2->getName()) {
+    return "player to move " + currentPlayer->getName() + " is not playing";
+  }
+  int counts[NUM_TILE_KINDS] = {0};
+  for (Player* player : {player1, player2}) {
+    if (player->getHand()->getLength() > DEFAULT_HAND_SIZE) {
+      return player->getName() + " holds " +
+             std::to_string(player->getHand()->getLength()) + " tiles";
+    }
+    countTiles(player->getHand(), counts);
+  }
+  countTiles(tileBag->getTiles(), counts);
+  for (int row = 0; row < board->getRows(); ++row) {
+    for (int col = 0; col < board->getCols(); ++col) {
+      Tile* tile = board->getTile(row, col);
+      if (tile != nullptr) {
+        counts[GameState::encodeTile(tile->getColour(), tile->getShape()) -
+               1]++;
+      }
+    }
+  }
+  for (int kind = 0; kind < NUM_TILE_KINDS; ++kind) {
+    if (counts[kind] > QUANTITY_OF_EACH_TILE) {
+      return std::to_string(counts[kind]) + " copies of " +
+             GameState::tileToString(static_cast<TileCode>(kind + 1));
+    }
+  }
+  return "";
+}
+
+void processFile(BulkResult& result, bool convert, SaveFormat format) {
+  struct stat info;
+  result.bytes =
+      stat(result.path.c_str(), &info) == 0 ? static_cast<size_t>(info.st_size)
+                                            : 0;
+  Player player1("Temp1");
+  Player player2("Temp2");
+  TileBag tileBag;
+  Player currentPlayer("Current");
+  GameBoard* board = new GameBoard();
+  FileHandler fileHandler;
+  result.ok = fileHandler.loadGame(result.path, &player1, &player2, &tileBag,
+                                   board, &currentPlayer);
+  if (!result.ok) {
+    result.error = fileHandler.getLastError();
+  } else {
+    result.warning =
+        checkGame(&player1, &player2, &tileBag, board, &currentPlayer);
+    if (convert) {
+      result.output = BulkLoader::outputPath(result.path, format);
+      result.ok = fileHandler.saveGame(result.output, &player1, &player2,
+                                       &tileBag, board, &currentPlayer,
+                                       format);
+      if (!result.ok) {
+        result.error = fileHandler.getLastError();
+      }
+    }
+  }
+  delete board;
+}
+}  // namespace
+
+std::vector<std::string> BulkLoader::collect(
+    const std::vector<std::string>& paths) {
+  std::vector<std::string> files;
+  for (const std::string& path : paths) {
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+      collectDirectory(path, files);
+    } else {
+      files.push_back(path);
+    }
+  }
+  std::sort(files.begin(), files.end());
+  files.erase(std::unique(files.begin(), files.end()), files.end());
+  return files;
+}
+
+std::vector<BulkResult> BulkLoader::run(const std::vector<std::string>& files,
+                                        bool convert, SaveFormat format,
+                                        BulkStats& stats) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<BulkResult> results(files.size());
+  ThreadPool& pool = ThreadPool::shared();
+  TaskGroup group;
+  for (size_t i = 0; i < files.size(); ++i) {
+    results[i].path = files[i];
+    BulkResult* result = &results[i];
+    pool.submit(group, [result, convert, format]() {
+      processFile(*result, convert, format);
+    });
+  }
+  pool.wait(group);
+
+  stats = {static_cast<int>(files.size()), 0, 0, 0, 0.0};
+  for (const BulkResult& result : results) {
+    stats.failed += result.ok ? 0 : 1;
+    stats.warned += result.ok && !result.warning.empty() ? 1 : 0;
+    stats.bytes += result.bytes;
+  }
+  stats.elapsedMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return results;
+}
+
+std::string BulkLoader::outputPath(const std::string& path,
+                                   SaveFormat format) {
+  std::string stem = path;
+  if (isSaveName(stem)) {
+    stem.erase(stem.find_last_of('.'));
+  }
+  return stem + (format == SAVE_BINARY ? BINARY_SAVE_EXTENSION
+                                       : TEXT_SAVE_EXTENSION);
+}
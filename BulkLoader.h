@@ -0,0 +1,55 @@
+#ifndef ASSIGN2_BULKLOADER_H
+#define ASSIGN2_BULKLOADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "FileHandler.h"
+
+struct BulkResult {
+  std::string path;
+  // The save loaded (and was rewritten, when converting)
+  bool ok;
+  // Why it failed to load or convert
+  std::string error;
+  // A save that loads but is not a reachable game: too many tiles of a
+  // kind, an oversized hand, or a player to move who is not playing
+  std::string warning;
+  size_t bytes;
+  // Where the converted save went, empty when only validating
+  std::string output;
+};
+
+struct BulkStats {
+  int files;
+  int failed;
+  int warned;
+  size_t bytes;
+  double elapsedMs;
+};
+
+/*
+ * Loads many saves at once on the shared thread pool, one file per task,
+ * to validate a save corpus or migrate it to another format. Each task
+ * uses its own FileHandler and game objects, so tasks share nothing but
+ * their slot in the results.
+ */
+class BulkLoader {
+ public:
+  // Files are taken as given; directories are searched recursively for
+  // .txt and BINARY_SAVE_EXTENSION files. Sorted, so runs are repeatable.
+  static std::vector<std::string> collect(
+      const std::vector<std::string>& paths);
+
+  // Load and check every file; with 'convert', also write each one next
+  // to the original in 'format', named with that format's extension
+  static std::vector<BulkResult> run(const std::vector<std::string>& files,
+                                     bool convert, SaveFormat format,
+                                     BulkStats& stats);
+
+  // The converted name of 'path': its stem with the extension of 'format'
+  static std::string outputPath(const std::string& path, SaveFormat format);
+};
+
+#endif  // ASSIGN2_BULKLOADER_H
@@ -0,0 +1,364 @@
+#include "CanonicalForm.h"
+
+#include <algorithm>
+
+// Marks a colour or shape that has no canonical number yet
+#define UNLABELLED 0xFF
+
+CanonicalForm::CanonicalForm()
+    : key(0),
+      dihedral(0),
+      originRow(0),
+      originCol(0),
+      height(0),
+      width(0) {
+  for (int i = 0; i < NUM_COLOURS; ++i) {
+    colourLabel[i] = colourSource[i] = static_cast<uint8_t>(i);
+  }
+  for (int i = 0; i < NUM_SHAPES; ++i) {
+    shapeLabel[i] = shapeSource[i] = static_cast<uint8_t>(i);
+  }
+}
+
+void CanonicalForm::transform(int dihedral, int height, int width, int& row,
+                              int& col) {
+  int r = row;
+  int c = col;
+  switch (dihedral) {
+    case 0:  // identity
+      break;
+    case 1:  // quarter turn clockwise
+      row = c;
+      col = height - 1 - r;
+      break;
+    case 2:  // half turn
+      row = height - 1 - r;
+      col = width - 1 - c;
+      break;
+    case 3:  // quarter turn anticlockwise
+      row = width - 1 - c;
+      col = r;
+      break;
+    case 4:  // mirror left-right
+      col = width - 1 - c;
+      break;
+    case 5:  // transpose
+      row = c;
+      col = r;
+      break;
+    case 6:  // mirror top-bottom
+      row = height - 1 - r;
+      break;
+    default:  // anti-transpose
+      row = width - 1 - c;
+      col = height - 1 - r;
+      break;
+  }
+}
+
+int CanonicalForm::inverse(int dihedral) {
+  // Only the two quarter turns are not their own inverse
+  if (dihedral == 1) {
+    return 3;
+  }
+  if (dihedral == 3) {
+    return 1;
+  }
+  return dihedral;
+}
+
+uint64_t CanonicalForm::digest(const std::vector<uint8_t>& code) {
+  // FNV-1a, then a final mix so nearby codes spread over all bits
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  for (uint8_t byte : code) {
+    hash = (hash ^ byte) * 0x100000001B3ULL;
+  }
+  hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+  return hash ^ (hash >> 31);
+}
+
+CanonicalForm CanonicalForm::of(const GameState& state, CanonicalScope scope) {
+  // One small number per tile kind for the tiles off the board
+  uint8_t offBoard[NUM_TILE_KINDS + 1] = {0};
+  for (TileCode tile : state.hands[state.toMove]) {
+    offBoard[tile] += scope == CANON_FULL ? 16 : 1;
+  }
+  if (scope == CANON_FULL) {
+    for (TileCode tile : state.hands[1 - state.toMove]) {
+      offBoard[tile] += 4;
+    }
+    for (size_t i = state.bagHead; i < state.bag.size(); ++i) {
+      offBoard[state.bag[i]] += 1;
+    }
+  }
+
+  CanonicalForm form;
+  int top = state.getRows() / 2;
+  int bottom = top;
+  int left = state.getCols() / 2;
+  int right = left;
+  if (!state.isBoardEmpty()) {
+    state.boundingBox(top, bottom, left, right);
+  }
+  form.originRow = top;
+  form.originCol = left;
+  form.height = bottom - top + 1;
+  form.width = right - left + 1;
+
+  // Every rotation and reflection of an empty board looks the same
+  int transforms = state.isBoardEmpty() ? 1 : DIHEDRAL_TRANSFORMS;
+  bool found = false;
+  for (int d = 0; d < transforms; ++d) {
+    int rows = d % 2 == 1 ? form.width : form.height;
+    int cols = d % 2 == 1 ? form.height : form.width;
+    std::vector<TileCode> grid(rows * cols, EMPTY_CELL);
+    if (!state.isBoardEmpty()) {
+      for (int r = 0; r < form.height; ++r) {
+        for (int c = 0; c < form.width; ++c) {
+          int row = r;
+          int col = c;
+          transform(d, form.height, form.width, row, col);
+          grid[row * cols + col] = state.at(top + r, left + c);
+        }
+      }
+    }
+
+    CanonicalForm candidate = form;
+    candidate.dihedral = d;
+    std::fill(candidate.colourLabel, candidate.colourLabel + NUM_COLOURS,
+              UNLABELLED);
+    std::fill(candidate.shapeLabel, candidate.shapeLabel + NUM_SHAPES,
+              UNLABELLED);
+    int colours = 0;
+    int shapes = 0;
+    candidate.code.clear();
+    candidate.code.push_back(static_cast<uint8_t>(rows));
+    candidate.code.push_back(static_cast<uint8_t>(cols));
+    for (TileCode tile : grid) {
+      if (tile == EMPTY_CELL) {
+        candidate.code.push_back(EMPTY_CELL);
+        continue;
+      }
+      int colour = GameState::colourIndex(tile);
+      int shape = GameState::shapeIndex(tile);
+      if (candidate.colourLabel[colour] == UNLABELLED) {
+        candidate.colourSource[colours] = static_cast<uint8_t>(colour);
+        candidate.colourLabel[colour] = static_cast<uint8_t>(colours++);
+      }
+      if (candidate.shapeLabel[shape] == UNLABELLED) {
+        candidate.shapeSource[shapes] = static_cast<uint8_t>(shape);
+        candidate.shapeLabel[shape] = static_cast<uint8_t>(shapes++);
+      }
+      candidate.code.push_back(static_cast<uint8_t>(
+          1 + candidate.colourLabel[colour] * NUM_SHAPES +
+          candidate.shapeLabel[shape]));
+    }
+
+    CanonicalForm bestLabels = candidate;
+    bestLabels.labelOffBoard(offBoard, colours, shapes);
+    if (!found || bestLabels.code < form.code) {
+      form = bestLabels;
+      found = true;
+    }
+  }
+  form.key = digest(form.code);
+  return form;
+}
+
+CanonicalForm CanonicalForm::ofHand(const std::vector<TileCode>& hand) {
+  uint8_t offBoard[NUM_TILE_KINDS + 1] = {0};
+  for (TileCode tile : hand) {
+    offBoard[tile]++;
+  }
+  CanonicalForm form;
+  std::fill(form.colourLabel, form.colourLabel + NUM_COLOURS, UNLABELLED);
+  std::fill(form.shapeLabel, form.shapeLabel + NUM_SHAPES, UNLABELLED);
+  form.labelOffBoard(offBoard, 0, 0);
+  form.key = digest(form.code);
+  return form;
+}
+
+void CanonicalForm::labelOffBoard(const uint8_t offBoard[], int colours,
+                                  int shapes) {
+  // Count rows of the colours missing from the board. Sorted, a row is
+  // the same under any renaming of shapes, so colours are ordered by it
+  // and only colours with equal sorted rows are tried in every order.
+  uint8_t rows[NUM_COLOURS][NUM_SHAPES];
+  uint8_t sortedRows[NUM_COLOURS][NUM_SHAPES];
+  for (int c = 0; c < NUM_COLOURS; ++c) {
+    for (int s = 0; s < NUM_SHAPES; ++s) {
+      rows[c][s] = offBoard[1 + c * NUM_SHAPES + s];
+    }
+    std::copy(rows[c], rows[c] + NUM_SHAPES, sortedRows[c]);
+    std::sort(sortedRows[c], sortedRows[c] + NUM_SHAPES);
+  }
+  uint8_t unseenColours[NUM_COLOURS];
+  uint8_t unseenShapes[NUM_SHAPES];
+  int unseenColourCount = 0;
+  int unseenShapeCount = 0;
+  for (int i = 0; i < NUM_COLOURS; ++i) {
+    if (colourLabel[i] == UNLABELLED) {
+      unseenColours[unseenColourCount++] = static_cast<uint8_t>(i);
+    }
+  }
+  for (int i = 0; i < NUM_SHAPES; ++i) {
+    if (shapeLabel[i] == UNLABELLED) {
+      unseenShapes[unseenShapeCount++] = static_cast<uint8_t>(i);
+    }
+  }
+  auto sortedLess = [&sortedRows](uint8_t a, uint8_t b) {
+    return std::lexicographical_compare(sortedRows[a],
+                                        sortedRows[a] + NUM_SHAPES,
+                                        sortedRows[b],
+                                        sortedRows[b] + NUM_SHAPES);
+  };
+  std::stable_sort(unseenColours, unseenColours + unseenColourCount,
+                   sortedLess);
+
+  // Groups of colours whose order is still open; a group of identical
+  // rows gives the same table in any order, so it is left alone
+  int groupStart[NUM_COLOURS];
+  int groupEnd[NUM_COLOURS];
+  int groups = 0;
+  for (int i = 0; i < unseenColourCount;) {
+    int j = i + 1;
+    bool identical = true;
+    while (j < unseenColourCount &&
+           !sortedLess(unseenColours[i], unseenColours[j])) {
+      identical = identical &&
+                  std::equal(rows[unseenColours[i]],
+                             rows[unseenColours[i]] + NUM_SHAPES,
+                             rows[unseenColours[j]]);
+      ++j;
+    }
+    if (!identical) {
+      groupStart[groups] = i;
+      groupEnd[groups] = j;
+      groups++;
+    }
+    i = j;
+  }
+
+  uint8_t bestCounts[NUM_TILE_KINDS];
+  uint8_t bestColours[NUM_COLOURS];
+  uint8_t bestShapes[NUM_SHAPES];
+  bool haveCounts = false;
+  bool more = true;
+  while (more) {
+    uint8_t colourOrder[NUM_COLOURS];
+    std::copy(colourSource, colourSource + colours, colourOrder);
+    std::copy(unseenColours, unseenColours + unseenColourCount,
+              colourOrder + colours);
+
+    // Column of counts for one shape, top to bottom in colour order
+    uint8_t columns[NUM_SHAPES][NUM_COLOURS];
+    for (int shape = 0; shape < NUM_SHAPES; ++shape) {
+      for (int c = 0; c < NUM_COLOURS; ++c) {
+        columns[shape][c] = rows[colourOrder[c]][shape];
+      }
+    }
+    uint8_t shapeOrder[NUM_SHAPES];
+    std::copy(shapeSource, shapeSource + shapes, shapeOrder);
+    std::copy(unseenShapes, unseenShapes + unseenShapeCount,
+              shapeOrder + shapes);
+    std::stable_sort(shapeOrder + shapes, shapeOrder + NUM_SHAPES,
+                     [&columns](uint8_t a, uint8_t b) {
+                       return std::lexicographical_compare(
+                           columns[a], columns[a] + NUM_COLOURS, columns[b],
+                           columns[b] + NUM_COLOURS);
+                     });
+
+    uint8_t counts[NUM_TILE_KINDS];
+    for (int c = 0; c < NUM_COLOURS; ++c) {
+      for (int s = 0; s < NUM_SHAPES; ++s) {
+        counts[c * NUM_SHAPES + s] = columns[shapeOrder[s]][c];
+      }
+    }
+    if (!haveCounts ||
+        std::lexicographical_compare(counts, counts + NUM_TILE_KINDS,
+                                     bestCounts,
+                                     bestCounts + NUM_TILE_KINDS)) {
+      std::copy(counts, counts + NUM_TILE_KINDS, bestCounts);
+      std::copy(colourOrder, colourOrder + NUM_COLOURS, bestColours);
+      std::copy(shapeOrder, shapeOrder + NUM_SHAPES, bestShapes);
+      haveCounts = true;
+    }
+
+    // Next order: step the last group, carrying into earlier ones
+    more = false;
+    for (int g = groups - 1; g >= 0 && !more; --g) {
+      more = std::next_permutation(unseenColours + groupStart[g],
+                                   unseenColours + groupEnd[g]);
+    }
+  }
+
+  for (int i = 0; i < NUM_COLOURS; ++i) {
+    colourSource[i] = bestColours[i];
+    colourLabel[bestColours[i]] = static_cast<uint8_t>(i);
+  }
+  for (int i = 0; i < NUM_SHAPES; ++i) {
+    shapeSource[i] = bestShapes[i];
+    shapeLabel[bestShapes[i]] = static_cast<uint8_t>(i);
+  }
+  code.insert(code.end(), bestCounts, bestCounts + NUM_TILE_KINDS);
+}
+
+uint64_t CanonicalForm::getKey() const { return key; }
+
+const std::vector<uint8_t>& CanonicalForm::getCode() const { return code; }
+
+bool CanonicalForm::operator==(const CanonicalForm& other) const {
+  return code == other.code;
+}
+
+bool CanonicalForm::operator!=(const CanonicalForm& other) const {
+  return !(*this == other);
+}
+
+TileCode CanonicalForm::toCanonical(TileCode tile) const {
+  if (tile == EMPTY_CELL) {
+    return EMPTY_CELL;
+  }
+  return static_cast<TileCode>(
+      1 + colourLabel[GameState::colourIndex(tile)] * NUM_SHAPES +
+      shapeLabel[GameState::shapeIndex(tile)]);
+}
+
+TileCode CanonicalForm::fromCanonical(TileCode tile) const {
+  if (tile == EMPTY_CELL) {
+    return EMPTY_CELL;
+  }
+  return static_cast<TileCode>(
+      1 + colourSource[GameState::colourIndex(tile)] * NUM_SHAPES +
+      shapeSource[GameState::shapeIndex(tile)]);
+}
+
+Move CanonicalForm::toCanonical(const Move& move) const {
+  Move mapped = move;
+  mapped.tile = toCanonical(move.tile);
+  if (move.type == MOVE_PLACE) {
+    int row = move.row - originRow;
+    int col = move.col - originCol;
+    transform(dihedral, height, width, row, col);
+    mapped.row = static_cast<int16_t>(row);
+    mapped.col = static_cast<int16_t>(col);
+  }
+  return mapped;
+}
+
+Move CanonicalForm::fromCanonical(const Move& move) const {
+  Move mapped = move;
+  mapped.tile = fromCanonical(move.tile);
+  if (move.type == MOVE_PLACE) {
+    int row = move.row;
+    int col = move.col;
+    // The canonical grid has the sides swapped by the odd transforms
+    int rows = dihedral % 2 == 1 ? width : height;
+    int cols = dihedral % 2 == 1 ? height : width;
+    transform(inverse(dihedral), rows, cols, row, col);
+    mapped.row = static_cast<int16_t>(row + originRow);
+    mapped.col = static_cast<int16_t>(col + originCol);
+  }
+  return mapped;
+}
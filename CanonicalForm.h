@@ -0,0 +1,90 @@
+#ifndef ASSIGN2_CANONICALFORM_H
+#define ASSIGN2_CANONICALFORM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "GameState.h"
+
+// Number of rotations and reflections of the board
+#define DIHEDRAL_TRANSFORMS 8
+
+// Which tiles off the board take part in the canonical form
+enum CanonicalScope {
+  // Both hands and the unseen tiles: the whole game position
+  CANON_FULL,
+  // Only the hand of the player to move: what that player can see
+  CANON_OWN_HAND
+};
+
+/*
+ * Canonical representative of a position under the symmetries of the
+ * game: translation (the board is cropped to its placed tiles), the 8
+ * rotations and reflections, and renaming of colours and of shapes.
+ *
+ * For each rotation/reflection the cropped board is scanned row by row
+ * and colours and shapes are numbered in order of first appearance.
+ * Colours and shapes not on the board are then numbered by the tiles
+ * off the board: the unseen colours are sorted by their sorted counts,
+ * colours that tie are tried in every order, the unseen shapes are
+ * sorted for each order, and the smallest result is kept. The
+ * smallest code over all 8 transforms is the canonical form, and the
+ * transform that produced it is kept so moves can be mapped both ways.
+ *
+ * The board is finite, so translation is only a true symmetry away from
+ * its edges; positions are treated as if the board were unbounded.
+ */
+class CanonicalForm {
+ public:
+  CanonicalForm();
+
+  static CanonicalForm of(const GameState& state,
+                          CanonicalScope scope = CANON_FULL);
+
+  // A hand on its own, renaming colours and shapes only; the code is
+  // the table of tile counts
+  static CanonicalForm ofHand(const std::vector<TileCode>& hand);
+
+  // 64-bit digest of the code, equal for all equivalent positions
+  uint64_t getKey() const;
+
+  // Full canonical code: cropped size, relabelled cells, then the counts
+  // of each tile kind off the board
+  const std::vector<uint8_t>& getCode() const;
+
+  bool operator==(const CanonicalForm& other) const;
+  bool operator!=(const CanonicalForm& other) const;
+
+  // Map a move or tile between the original and the canonical position
+  Move toCanonical(const Move& move) const;
+  Move fromCanonical(const Move& move) const;
+  TileCode toCanonical(TileCode tile) const;
+  TileCode fromCanonical(TileCode tile) const;
+
+ private:
+  std::vector<uint8_t> code;
+  uint64_t key;
+
+  // Transform from the original board to the canonical one
+  int dihedral;
+  int originRow;
+  int originCol;
+  int height;
+  int width;
+  // Original colour/shape index -> canonical index, and back
+  uint8_t colourLabel[NUM_COLOURS];
+  uint8_t shapeLabel[NUM_SHAPES];
+  uint8_t colourSource[NUM_COLOURS];
+  uint8_t shapeSource[NUM_SHAPES];
+
+  // Where row/col of a height x width grid lands under a transform
+  static void transform(int dihedral, int height, int width, int& row,
+                        int& col);
+  static int inverse(int dihedral);
+  // Number the colours and shapes still unlabelled by the counts of the
+  // tiles off the board and append the counts to the code
+  void labelOffBoard(const uint8_t offBoard[], int colours, int shapes);
+  static uint64_t digest(const std::vector<uint8_t>& code);
+};
+
+#endif  // ASSIGN2_CANONICALFORM_H
@@ -0,0 +1,182 @@
+#include "CommandParser.h"
+
+#include <cstring>
+
+#include "InputValidator.h"
+
+namespace {
+enum ArgumentKind : uint8_t {
+  ARG_END,
+  // A colour letter and a shape digit, such as "R1"
+  ARG_TILE,
+  // The word "at"
+  ARG_AT,
+  // A row letter and a column number, such as "C12"; completes a
+  // placement of the tile before it
+  ARG_CELL,
+  // A positive number; the only optional argument
+  ARG_MILLISECONDS
+};
+
+const char* const kMoveUsage =
+    "Invalid move format. Use 'place <tile> at <position>'.";
+const char* const kEnhancedMoveUsage =
+    "Invalid move format. Use 'place <tile> at <position>', "
+    "'replace <tile>', or 'pass'.";
+const char* const kTileUsage = "Invalid tile format. Use <colour><shape>.";
+const char* const kHintUsage =
+    "Invalid hint format. Use 'hint' or 'hint <milliseconds>'.";
+
+struct CommandSpec {
+  const char* name;
+  CommandVerb verb;
+  bool enhancedOnly;
+  ArgumentKind arguments[4];
+  // Enhanced game: the arguments may be given again, up to
+  // COMMAND_MAX_PLACEMENTS times in all, each time after a ","
+  bool repeats;
+  // Shown when the arguments do not match; null for the move usage
+  const char* usage;
+};
+
+const CommandSpec kCommands[] = {
+    {"quit", VERB_QUIT, false, {ARG_END}, false, nullptr},
+    {"save", VERB_SAVE, false, {ARG_END}, false, nullptr},
+    {"hint", VERB_HINT, false, {ARG_MILLISECONDS, ARG_END}, false,
+     kHintUsage},
+    {"pass", VERB_PASS, true, {ARG_END}, false, nullptr},
+    {"replace", VERB_REPLACE, false, {ARG_TILE, ARG_END}, false, kTileUsage},
+    {"place", VERB_PLACE, false, {ARG_TILE, ARG_AT, ARG_CELL, ARG_END}, true,
+     nullptr},
+};
+
+struct Token {
+  const char* text;
+  size_t length;
+
+  bool is(const char* word) const {
+    return std::strlen(word) == length && std::memcmp(text, word, length) == 0;
+  }
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+
+// Digits only, at most COMMAND_MAX_DIGITS of them
+bool toInt(const char* text, size_t length, int& out) {
+  out = 0;
+  if (length == 0 || length > COMMAND_MAX_DIGITS) {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    if (text[i] < '0' || text[i] > '9') {
+      return false;
+    }
+    out = out * 10 + (text[i] - '0');
+  }
+  return true;
+}
+
+bool parseArgument(ArgumentKind kind, const Token& token, Command& command) {
+  switch (kind) {
+    case ARG_TILE:
+      if (token.length != 2 || !isUpper(token.text[0]) ||
+          token.text[1] < '0' || token.text[1] > '9') {
+        return false;
+      }
+      command.colour = token.text[0];
+      command.shape = token.text[1] - '0';
+      return true;
+    case ARG_AT:
+      return token.is("at");
+    case ARG_CELL: {
+      int col = 0;
+      // No board is wider than a save can hold, and a wider column would
+      // not fit the move
+      if (!isUpper(token.text[0]) ||
+          !toInt(token.text + 1, token.length - 1, col) ||
+          col >= SAVE_MAX_BOARD_COLS) {
+        return false;
+      }
+      command.placements[command.placementCount++] = {
+          MOVE_PLACE, GameState::encodeTile(command.colour, command.shape),
+          static_cast<int16_t>(token.text[0] - 'A'),
+          static_cast<int16_t>(col)};
+      return true;
+    }
+    case ARG_MILLISECONDS:
+      return toInt(token.text, token.length, command.hintMs) &&
+             command.hintMs > 0;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+bool CommandParser::parse(const char* line, size_t length, bool enhanced,
+                          Command& command) {
+  command = Command();
+  command.error = enhanced ? kEnhancedMoveUsage : kMoveUsage;
+
+  // Split on whitespace, with each comma a token of its own, keeping one
+  // token more than any command takes
+  Token tokens[COMMAND_MAX_TOKENS + 1];
+  int count = 0;
+  size_t pos = 0;
+  while (count <= COMMAND_MAX_TOKENS) {
+    while (pos < length && isSpace(line[pos])) {
+      ++pos;
+    }
+    if (pos == length) {
+      break;
+    }
+    tokens[count].text = line + pos;
+    if (line[pos] == ',') {
+      ++pos;
+    } else {
+      while (pos < length && !isSpace(line[pos]) && line[pos] != ',') {
+        ++pos;
+      }
+    }
+    tokens[count].length = static_cast<size_t>(line + pos - tokens[count].text);
+    ++count;
+  }
+  if (count == 0) {
+    return false;
+  }
+
+  for (const CommandSpec& spec : kCommands) {
+    if (!tokens[0].is(spec.name) || (spec.enhancedOnly && !enhanced)) {
+      continue;
+    }
+    bool ok = true;
+    int given = 1;
+    for (int group = 0; ok && (group == 0 || given < count); ++group) {
+      if (group > 0) {
+        ok = spec.repeats && enhanced && group < COMMAND_MAX_PLACEMENTS &&
+             tokens[given++].is(",");
+      }
+      for (int i = 0; ok && spec.arguments[i] != ARG_END; ++i) {
+        if (given < count) {
+          ok = parseArgument(spec.arguments[i], tokens[given++], command);
+        } else {
+          ok = spec.arguments[i] == ARG_MILLISECONDS;
+        }
+      }
+    }
+    if (!ok || given != count) {
+      command.error = spec.usage != nullptr ? spec.usage : command.error;
+      return false;
+    }
+    command.verb = spec.verb;
+    command.error = nullptr;
+    return true;
+  }
+  return false;
+}
+
+bool CommandParser::parse(const std::string& line, bool enhanced,
+                          Command& command) {
+  return parse(line.data(), line.size(), enhanced, command);
+}
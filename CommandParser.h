@@ -0,0 +1,62 @@
+#ifndef ASSIGN2_COMMANDPARSER_H
+#define ASSIGN2_COMMANDPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "GameState.h"
+
+// Tiles one place command may name: a whole hand
+#define COMMAND_MAX_PLACEMENTS DEFAULT_HAND_SIZE
+
+// Words in the longest command: "place", then "<tile> at <cell>" for each
+// placement with a "," between them. A longer line is rejected.
+#define COMMAND_MAX_TOKENS (4 * COMMAND_MAX_PLACEMENTS)
+
+// Digits accepted in a column or a hint deadline, so neither overflows
+#define COMMAND_MAX_DIGITS 9
+
+enum CommandVerb : uint8_t {
+  VERB_NONE,
+  VERB_QUIT,
+  VERB_SAVE,
+  VERB_HINT,
+  // Enhanced mode only
+  VERB_PASS,
+  VERB_REPLACE,
+  VERB_PLACE
+};
+
+// One parsed line of the game loop
+struct Command {
+  CommandVerb verb = VERB_NONE;
+  // The tile of a replace, not yet checked against the hand
+  char colour = 0;
+  int shape = 0;
+  // The tiles of a place in the order given, with row A as 0; a tile that
+  // does not exist is EMPTY_CELL
+  Move placements[COMMAND_MAX_PLACEMENTS];
+  int placementCount = 0;
+  // Deadline of a hint, 0 if none was given
+  int hintMs = 0;
+  // Why the line was rejected, when verb is VERB_NONE; a static string
+  const char* error = nullptr;
+};
+
+/*
+ * Turns a line typed in the game loop into a Command. Each verb is a row
+ * of a table naming the arguments it takes, so adding a command is one
+ * row and one case in the caller. Parsing works on the caller's
+ * characters and never allocates or throws.
+ */
+class CommandParser {
+ public:
+  // False with command.error set if the line is not a command in this mode
+  static bool parse(const char* line, size_t length, bool enhanced,
+                    Command& command);
+  static bool parse(const std::string& line, bool enhanced,
+                    Command& command);
+};
+
+#endif  // ASSIGN2_COMMANDPARSER_H
@@ -0,0 +1,285 @@
+#include "EndgameSolver.h"
+
+#include <algorithm>
+
+#define ENDGAME_INFINITY 1000000
+
+// Longest possible endgame: every tile in both hands placed with a pass
+// after each one, then the two closing passes
+#define ENDGAME_MAX_PLY (4 * DEFAULT_HAND_SIZE + 2)
+
+// Table depth of a position whose value is final
+#define ENDGAME_SOLVED_DEPTH TABLE_MAX_DEPTH
+
+EndgameConfig::EndgameConfig()
+    : finishingBonus(ENDGAME_FINISHING_BONUS),
+      timeLimitMs(ENDGAME_DEFAULT_MS) {}
+
+EndgameSolver::EndgameSolver(const EndgameConfig& config)
+    : config(config),
+      table(TranspositionTable::shared()),
+      nodes(0),
+      tableHits(0),
+      aborted(false),
+      cutoff(false),
+      moveStack(ENDGAME_MAX_PLY + 1) {}
+
+bool EndgameSolver::applies(const GameState& state) {
+  return state.bagSize() == 0;
+}
+
+bool EndgameSolver::isOver(const GameState& state) const {
+  return (state.hands[0].empty() && state.hands[1].empty()) ||
+         state.idleTurns >= 2;
+}
+
+int EndgameSolver::gain(const GameState& state, const Move& move) const {
+  if (move.type != MOVE_PLACE) {
+    return 0;
+  }
+  int points = state.scorePlacement(move.row, move.col);
+  // Only the first player to go out collects the bonus
+  if (state.hands[state.toMove].size() == 1 &&
+      !state.hands[1 - state.toMove].empty()) {
+    points += config.finishingBonus;
+  }
+  return points;
+}
+
+uint64_t EndgameSolver::keyOf(const GameState& state) const {
+  return state.hash() ^
+         (static_cast<uint64_t>(config.finishingBonus) * 0xD6E8FEB86659FD93ULL);
+}
+
+void EndgameSolver::orderedMoves(const GameState& state, uint64_t key,
+                                 std::vector<ScoredMove>& moves) {
+  scratch.clear();
+  state.generatePlacements(scratch);
+  moves.clear();
+  for (const Move& move : scratch) {
+    moves.push_back({move, gain(state, move)});
+  }
+  std::stable_sort(moves.begin(), moves.end(),
+                   [](const ScoredMove& a, const ScoredMove& b) {
+                     return a.gain > b.gain;
+                   });
+  moves.push_back({{MOVE_PASS, EMPTY_CELL, 0, 0}, 0});
+
+  TableEntry entry;
+  if (table.probe(key, entry)) {
+    for (size_t i = 0; i < moves.size(); ++i) {
+      if (moves[i].move == entry.best) {
+        std::rotate(moves.begin(), moves.begin() + i, moves.begin() + i + 1);
+        break;
+      }
+    }
+  }
+}
+
+EndgameResult EndgameSolver::solve(const GameState& state) {
+  auto start = std::chrono::steady_clock::now();
+  deadline = start + std::chrono::milliseconds(config.timeLimitMs);
+  table.newSearch();
+  nodes = 0;
+  tableHits = 0;
+  aborted = false;
+
+  EndgameResult result;
+  result.solved = false;
+  result.depth = 0;
+  result.margin = state.scoreMargin(state.toMove);
+
+  std::vector<ScoredMove> rootMoves;
+  orderedMoves(state, keyOf(state), rootMoves);
+  result.move = rootMoves[0].move;
+
+  int value = 0;
+  for (int depth = 1; depth <= ENDGAME_MAX_PLY; ++depth) {
+    cutoff = false;
+    int searched = negamax(state, depth, 0, -ENDGAME_INFINITY,
+                           ENDGAME_INFINITY);
+    if (aborted) {
+      break;
+    }
+    value = searched;
+    result.depth = depth;
+    TableEntry root;
+    if (table.probe(keyOf(state), root)) {
+      result.move = root.best;
+    }
+    if (!cutoff) {
+      result.solved = true;
+      break;
+    }
+  }
+  result.margin += value;
+
+  // Walk down the best line. Once solved, children are re-searched
+  // against the (now warm) table so the line is exact even where entries
+  // only hold bounds, until the time limit runs out; otherwise the table
+  // moves are followed.
+  GameState position = state;
+  int bonus[2] = {0, 0};
+  int remaining = value;
+  aborted = false;
+  while (!isOver(position) &&
+         static_cast<int>(result.line.size()) < result.depth) {
+    Move next = result.move;
+    if (result.solved) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        break;
+      }
+      std::vector<ScoredMove> moves;
+      orderedMoves(position, keyOf(position), moves);
+      bool found = false;
+      for (const ScoredMove& candidate : moves) {
+        GameState child = position;
+        child.applyMove(candidate.move);
+        int childValue = negamax(child, ENDGAME_MAX_PLY, 0, -ENDGAME_INFINITY,
+                                 ENDGAME_INFINITY);
+        if (aborted) {
+          break;
+        }
+        if (candidate.gain - childValue == remaining) {
+          next = candidate.move;
+          remaining = childValue;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        break;
+      }
+    } else if (!result.line.empty()) {
+      TableEntry entry;
+      if (!table.probe(keyOf(position), entry)) {
+        break;
+      }
+      next = entry.best;
+    }
+    int points = gain(position, next);
+    int before = position.scores[position.toMove];
+    int mover = position.toMove;
+    position.applyMove(next);
+    bonus[mover] += points - (position.scores[mover] - before);
+    result.line.push_back(next);
+  }
+  result.finalScores[0] = position.scores[0] + bonus[0];
+  result.finalScores[1] = position.scores[1] + bonus[1];
+  result.lineComplete = isOver(position);
+
+  result.nodes = nodes;
+  result.tableHits = tableHits;
+  result.elapsedMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  return result;
+}
+
+int EndgameSolver::negamax(const GameState& state, int depth, int ply,
+                           int alpha, int beta) {
+  nodes++;
+  if (nodes % ENDGAME_CLOCK_INTERVAL == 0 &&
+      std::chrono::steady_clock::now() >= deadline) {
+    aborted = true;
+  }
+  if (aborted || isOver(state)) {
+    return 0;
+  }
+  if (depth == 0) {
+    cutoff = true;
+    return 0;
+  }
+
+  uint64_t key = keyOf(state);
+  int originalAlpha = alpha;
+  TableEntry entry;
+  if (table.probe(key, entry) && entry.depth >= depth) {
+    tableHits++;
+    if (entry.depth < ENDGAME_SOLVED_DEPTH) {
+      cutoff = true;
+    }
+    if (entry.bound == BOUND_EXACT) {
+      return entry.value;
+    } else if (entry.bound == BOUND_LOWER) {
+      alpha = std::max(alpha, entry.value);
+    } else {
+      beta = std::min(beta, entry.value);
+    }
+    if (alpha >= beta) {
+      return entry.value;
+    }
+  }
+
+  // Track cut-offs below this node only, to tell if its value is final
+  bool outerCutoff = cutoff;
+  cutoff = false;
+
+  std::vector<ScoredMove>& moves = moveStack[ply];
+  orderedMoves(state, key, moves);
+
+  if (depth == 1) {
+    // Every child scores 0 from here, so skip making them: the value is
+    // the best gain, and the line only ends if no child can move on
+    const ScoredMove* best = &moves[0];
+    for (const ScoredMove& move : moves) {
+      if (move.gain > best->gain) {
+        best = &move;
+      }
+    }
+    bool placementsEnd = moves.size() == 1 ||
+                         (state.hands[state.toMove].size() == 1 &&
+                          state.hands[1 - state.toMove].empty());
+    bool passEnds = state.idleTurns >= 1;
+    bool ends = placementsEnd && passEnds;
+    table.store(key, {best->gain, ends ? ENDGAME_SOLVED_DEPTH : 1, BOUND_EXACT,
+                      best->move});
+    cutoff = outerCutoff || !ends;
+    return best->gain;
+  }
+
+  int best = -ENDGAME_INFINITY;
+  Move bestMove = moves[0].move;
+  for (size_t i = 0; i < moves.size(); ++i) {
+    int points = moves[i].gain;
+    GameState child = state;
+    child.applyMove(moves[i].move);
+    // value = points - childValue, so the child window shifts by points.
+    // Later moves are first tried with a null window (principal variation
+    // search) and only re-searched if they might be better.
+    int value;
+    if (i == 0) {
+      value = points - negamax(child, depth - 1, ply + 1, points - beta,
+                               points - alpha);
+    } else {
+      value = points - negamax(child, depth - 1, ply + 1, points - alpha - 1,
+                               points - alpha);
+      if (value > alpha && value < beta) {
+        value = points - negamax(child, depth - 1, ply + 1, points - beta,
+                                 points - value);
+      }
+    }
+    if (aborted) {
+      return 0;
+    }
+    if (value > best) {
+      best = value;
+      bestMove = moves[i].move;
+    }
+    alpha = std::max(alpha, value);
+    if (alpha >= beta) {
+      break;
+    }
+  }
+
+  TableBound bound = BOUND_EXACT;
+  if (best <= originalAlpha) {
+    bound = BOUND_UPPER;
+  } else if (best >= beta) {
+    bound = BOUND_LOWER;
+  }
+  table.store(key,
+              {best, cutoff ? depth : ENDGAME_SOLVED_DEPTH, bound, bestMove});
+  cutoff = outerCutoff || cutoff;
+  return best;
+}
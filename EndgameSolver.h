@@ -0,0 +1,101 @@
+#ifndef ASSIGN2_ENDGAMESOLVER_H
+#define ASSIGN2_ENDGAMESOLVER_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "GameState.h"
+#include "TranspositionTable.h"
+
+// Standard Qwirkle bonus for the first player to play out their hand
+#define ENDGAME_FINISHING_BONUS 6
+
+// Give up on an exact answer after this long
+#define ENDGAME_DEFAULT_MS 1000
+
+// Nodes searched between clock checks
+#define ENDGAME_CLOCK_INTERVAL 1024
+
+struct EndgameConfig {
+  // Points for going out first; 0 matches the scoring of the game loop
+  int finishingBonus;
+  int timeLimitMs;
+
+  EndgameConfig();
+};
+
+struct EndgameResult {
+  // False if the time limit ran out before the search reached the end of
+  // the game; the move and scores then come from the deepest search done
+  bool solved;
+  // Plies searched by the last completed iteration
+  int depth;
+  Move move;
+  // Score margin the player to move ends the game with, best play
+  int margin;
+  // Scores at the end of 'line', indexed like GameState::scores; the
+  // final scores with best play when the line reaches the end of the game
+  int finalScores[2];
+  // Principal variation, starting with 'move'; cut short if the time
+  // limit runs out while it is walked
+  std::vector<Move> line;
+  // True if 'line' reaches the end of the game
+  bool lineComplete;
+  long nodes;
+  long tableHits;
+  double elapsedMs;
+};
+
+/*
+ * Exact solver for the end of the game. Once the bag is empty both hands
+ * are known, so the rest is a perfect-information game and a negamax
+ * alpha-beta search can play it out to the end. Values are the points
+ * still to be scored, as a margin for the player to move, so positions
+ * reached by different move orders share one entry in the shared
+ * transposition table.
+ * Two passes in a row end the search, since nothing can change after.
+ *
+ * The search deepens one ply at a time, so a large endgame still gets a
+ * good move when the time limit runs out; it is solved once an iteration
+ * reaches the end of every line.
+ */
+class EndgameSolver {
+ public:
+  explicit EndgameSolver(const EndgameConfig& config);
+
+  // True if the bag is empty, so the position can be solved
+  static bool applies(const GameState& state);
+
+  EndgameResult solve(const GameState& state);
+
+ private:
+  struct ScoredMove {
+    Move move;
+    int gain;
+  };
+
+  EndgameConfig config;
+  TranspositionTable& table;
+  std::chrono::steady_clock::time_point deadline;
+  long nodes;
+  long tableHits;
+  bool aborted;
+  // Set when a line was cut short by the depth limit
+  bool cutoff;
+  std::vector<std::vector<ScoredMove>> moveStack;
+  std::vector<Move> scratch;
+
+  int negamax(const GameState& state, int depth, int ply, int alpha,
+              int beta);
+  bool isOver(const GameState& state) const;
+  // Points the player to move gains by making 'move', bonus included
+  int gain(const GameState& state, const Move& move) const;
+  // Table key; entries depend on the bonus, so it is mixed in
+  uint64_t keyOf(const GameState& state) const;
+  // Table move first, then placements by gain, then the pass
+  void orderedMoves(const GameState& state, uint64_t key,
+                    std::vector<ScoredMove>& moves);
+};
+
+#endif  // ASSIGN2_ENDGAMESOLVER_H
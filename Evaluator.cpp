@@ -0,0 +1,279 @@
+#include "Evaluator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "HandTable.h"
+
+static_assert(EVAL_FEATURES % EVAL_VECTOR_WIDTH == 0,
+              "features must fill whole vectors");
+
+#define EVAL_FILE_HEADER "qwirkle-eval 1"
+
+// Line length that a matching tile turns into a Qwirkle
+#define EVAL_THREAT_LENGTH (NUM_SHAPES - 1)
+
+namespace {
+// Fitted by 'qwirkle train' on 2000 greedy self-play games (seeds 1-2000)
+const float kDefaultWeights[EVAL_FEATURES] = {
+    -6.923f,  1.210f,   0.05146f, 0.08339f, 0.01169f, 0.007085f,
+    0.000848f, 0.002281f, 0.2450f,  -0.5604f, -1.992f,  4.165f};
+
+const char* const kFeatureNames[EVAL_FEATURES] = {
+    "bias",         "best_placement", "mobility",
+    "hand_value",   "open_length",    "line_room",
+    "colour_lines", "shape_lines",    "qwirkle_threats",
+    "own_qwirkles", "opponent_qwirkle_odds", "bag_fraction"};
+
+// Chance that 'drawn' tiles taken from 'pool' include at least one of
+// 'wanted'
+float chanceOfAny(int wanted, int drawn, int pool) {
+  if (wanted <= 0 || drawn <= 0 || pool <= 0) {
+    return 0.0f;
+  }
+  double none = 1.0;
+  for (int i = 0; i < drawn && i < pool; ++i) {
+    none *= static_cast<double>(pool - wanted - i) / (pool - i);
+    if (none <= 0.0) {
+      return 1.0f;
+    }
+  }
+  return static_cast<float>(1.0 - none);
+}
+}  // namespace
+
+Evaluator::Evaluator() { setWeights(kDefaultWeights); }
+
+Evaluator& Evaluator::shared() {
+  static Evaluator evaluator;
+  return evaluator;
+}
+
+const char* Evaluator::featureName(int feature) {
+  return kFeatureNames[feature];
+}
+
+void Evaluator::extractFeatures(const GameState& state, float* features) {
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    features[f] = 0.0f;
+  }
+  features[FEATURE_BIAS] = 1.0f;
+  features[FEATURE_BAG_FRACTION] =
+      static_cast<float>(state.bagSize()) /
+      (NUM_TILE_KINDS * QUANTITY_OF_EACH_TILE);
+
+  const std::vector<TileCode>& hand = state.hands[state.toMove];
+  uint8_t handCounts[NUM_TILE_KINDS] = {0};
+  for (TileCode tile : hand) {
+    handCounts[tile - 1]++;
+  }
+  features[FEATURE_HAND_VALUE] =
+      static_cast<float>(HandTable::handValue(handCounts));
+
+  thread_local std::vector<Move> placements;
+  placements.clear();
+  state.generatePlacements(placements);
+  features[FEATURE_MOBILITY] = static_cast<float>(placements.size());
+  for (const Move& move : placements) {
+    features[FEATURE_BEST_PLACEMENT] =
+        std::max(features[FEATURE_BEST_PLACEMENT],
+                 static_cast<float>(state.scorePlacement(move.row, move.col)));
+  }
+  if (state.isBoardEmpty()) {
+    return;
+  }
+
+  // Tiles the player to move cannot see: the bag and the other hand
+  uint8_t unseen[NUM_TILE_KINDS];
+  for (int kind = 0; kind < NUM_TILE_KINDS; ++kind) {
+    unseen[kind] =
+        static_cast<uint8_t>(QUANTITY_OF_EACH_TILE - handCounts[kind]);
+  }
+  int top, bottom, left, right;
+  state.boundingBox(top, bottom, left, right);
+  for (int row = top; row <= bottom; ++row) {
+    for (int col = left; col <= right; ++col) {
+      TileCode tile = state.at(row, col);
+      if (tile != EMPTY_CELL && unseen[tile - 1] > 0) {
+        unseen[tile - 1]--;
+      }
+    }
+  }
+  int opponentHand = static_cast<int>(state.hands[1 - state.toMove].size());
+  int unseenTotal = state.bagSize() + opponentHand;
+
+  // Every run of two or more tiles, across then down
+  const int directions[2][2] = {{0, 1}, {1, 0}};
+  for (const auto& direction : directions) {
+    int dr = direction[0];
+    int dc = direction[1];
+    for (int row = top; row <= bottom; ++row) {
+      for (int col = left; col <= right; ++col) {
+        int pr = row - dr;
+        int pc = col - dc;
+        bool startsRun = state.at(row, col) != EMPTY_CELL &&
+                         (pr < top || pc < left ||
+                          state.at(pr, pc) == EMPTY_CELL);
+        if (!startsRun) {
+          continue;
+        }
+        int length = 0;
+        int r = row;
+        int c = col;
+        bool shapeSeen[NUM_SHAPES] = {false};
+        bool colourSeen[NUM_COLOURS] = {false};
+        while (r <= bottom && c <= right && state.at(r, c) != EMPTY_CELL) {
+          shapeSeen[GameState::shapeIndex(state.at(r, c))] = true;
+          colourSeen[GameState::colourIndex(state.at(r, c))] = true;
+          length++;
+          r += dr;
+          c += dc;
+        }
+        if (length < 2) {
+          continue;
+        }
+        bool openBefore = pr >= 0 && pc >= 0 && state.at(pr, pc) == EMPTY_CELL;
+        bool openAfter = r < state.getRows() && c < state.getCols() &&
+                         state.at(r, c) == EMPTY_CELL;
+        if (!openBefore && !openAfter) {
+          continue;
+        }
+
+        TileCode first = state.at(row, col);
+        TileCode second = state.at(row + dr, col + dc);
+        bool colourLine =
+            GameState::colourIndex(first) == GameState::colourIndex(second);
+        features[FEATURE_OPEN_LENGTH] += length;
+        features[FEATURE_LINE_ROOM] += NUM_SHAPES - length;
+        features[colourLine ? FEATURE_COLOUR_LINES : FEATURE_SHAPE_LINES] +=
+            1.0f;
+        if (length != EVAL_THREAT_LENGTH) {
+          continue;
+        }
+
+        // The one tile kind that completes this line
+        int missing = 0;
+        if (colourLine) {
+          while (shapeSeen[missing]) {
+            missing++;
+          }
+          missing += GameState::colourIndex(first) * NUM_SHAPES;
+        } else {
+          while (colourSeen[missing]) {
+            missing++;
+          }
+          missing = missing * NUM_SHAPES + GameState::shapeIndex(first);
+        }
+        features[FEATURE_QWIRKLE_THREATS] += 1.0f;
+        if (handCounts[missing] > 0) {
+          features[FEATURE_OWN_QWIRKLES] += 1.0f;
+        }
+        features[FEATURE_OPPONENT_QWIRKLE_ODDS] +=
+            chanceOfAny(unseen[missing], opponentHand, unseenTotal);
+      }
+    }
+  }
+}
+
+float Evaluator::predict(const float* features) const {
+#ifdef __SSE2__
+  __m128 sum = _mm_setzero_ps();
+  for (int f = 0; f < EVAL_FEATURES; f += EVAL_VECTOR_WIDTH) {
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(weights + f),
+                                     _mm_loadu_ps(features + f)));
+  }
+  float lanes[EVAL_VECTOR_WIDTH];
+  _mm_storeu_ps(lanes, sum);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+  float sum = 0.0f;
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    sum += weights[f] * features[f];
+  }
+  return sum;
+#endif
+}
+
+float Evaluator::evaluate(const GameState& state) const {
+  alignas(16) float features[EVAL_FEATURES];
+  extractFeatures(state, features);
+  return state.scoreMargin(state.toMove) + predict(features);
+}
+
+void Evaluator::evaluateBatch(const float* features, size_t count,
+                              size_t stride, float* out) const {
+  size_t i = 0;
+#ifdef __SSE2__
+  for (; i + EVAL_VECTOR_WIDTH <= count; i += EVAL_VECTOR_WIDTH) {
+    __m128 sum = _mm_setzero_ps();
+    for (int f = 0; f < EVAL_FEATURES; ++f) {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[f]),
+                                       _mm_loadu_ps(features + f * stride + i)));
+    }
+    _mm_storeu_ps(out + i, sum);
+  }
+#endif
+  for (; i < count; ++i) {
+    float sum = 0.0f;
+    for (int f = 0; f < EVAL_FEATURES; ++f) {
+      sum += weights[f] * features[f * stride + i];
+    }
+    out[i] = sum;
+  }
+}
+
+const float* Evaluator::getWeights() const { return weights; }
+
+void Evaluator::setWeights(const float* newWeights) {
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    weights[f] = newWeights[f];
+  }
+}
+
+bool Evaluator::load(const std::string& path) {
+  std::ifstream in(path);
+  std::string header;
+  if (!std::getline(in, header) || header != EVAL_FILE_HEADER) {
+    return false;
+  }
+  float loaded[EVAL_FEATURES];
+  bool seen[EVAL_FEATURES] = {false};
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string name;
+    float value;
+    if (!(fields >> name >> value)) {
+      continue;
+    }
+    for (int f = 0; f < EVAL_FEATURES; ++f) {
+      if (name == kFeatureNames[f]) {
+        loaded[f] = value;
+        seen[f] = true;
+      }
+    }
+  }
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    if (!seen[f]) {
+      return false;
+    }
+  }
+  setWeights(loaded);
+  return true;
+}
+
+bool Evaluator::save(const std::string& path) const {
+  std::ofstream out(path);
+  out << EVAL_FILE_HEADER << "\n";
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    out << kFeatureNames[f] << " " << weights[f] << "\n";
+  }
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,83 @@
+#ifndef ASSIGN2_EVALUATOR_H
+#define ASSIGN2_EVALUATOR_H
+
+#include <cstddef>
+#include <string>
+
+#include "GameState.h"
+
+// Features per position, padded to a whole number of 4-float vectors
+#define EVAL_FEATURES 12
+#define EVAL_VECTOR_WIDTH 4
+
+enum EvalFeature {
+  // Always 1
+  FEATURE_BIAS,
+  // Best score the player to move can make now
+  FEATURE_BEST_PLACEMENT,
+  // Distinct legal placements for the player to move
+  FEATURE_MOBILITY,
+  // HandTable::handValue of the hand of the player to move
+  FEATURE_HAND_VALUE,
+  // Total length of the lines with an empty cell at an end
+  FEATURE_OPEN_LENGTH,
+  // Sum over those lines of the tile kinds that could still join them
+  FEATURE_LINE_ROOM,
+  // Open lines sharing a colour, and sharing a shape
+  FEATURE_COLOUR_LINES,
+  FEATURE_SHAPE_LINES,
+  // Open lines of five, which the next matching tile turns into a Qwirkle
+  FEATURE_QWIRKLE_THREATS,
+  // Of those, how many the player to move can complete now
+  FEATURE_OWN_QWIRKLES,
+  // Chance the opponent holds a tile completing one, summed over them
+  FEATURE_OPPONENT_QWIRKLE_ODDS,
+  // Tiles left in the bag over the full tile set
+  FEATURE_BAG_FRACTION
+};
+
+/*
+ * Linear position evaluation. Features are read from the point of view
+ * of the player to move, using only what that player can see, and the
+ * model predicts how the score margin will change by the end of the
+ * game. evaluate() returns the current margin plus that prediction, in
+ * points, so it can stand in for the margin at a search cut-off.
+ *
+ * Dot products use SSE2 when the compiler targets it, with a scalar
+ * loop otherwise. evaluateBatch() takes features laid out one row per
+ * feature, so each vector instruction works on four positions at once.
+ */
+class Evaluator {
+ public:
+  // Built-in weights, trained from greedy self-play
+  Evaluator();
+
+  // Engine-wide evaluator used by the search bots
+  static Evaluator& shared();
+
+  static void extractFeatures(const GameState& state, float* features);
+
+  float evaluate(const GameState& state) const;
+
+  // Predicted change in margin for one feature vector
+  float predict(const float* features) const;
+
+  // 'features' holds feature f of position i at f * stride + i; the
+  // predictions for the 'count' positions go to 'out'
+  void evaluateBatch(const float* features, size_t count, size_t stride,
+                     float* out) const;
+
+  const float* getWeights() const;
+  void setWeights(const float* weights);
+
+  // Text file: a header line, then one "name value" line per feature
+  bool load(const std::string& path);
+  bool save(const std::string& path) const;
+
+  static const char* featureName(int feature);
+
+ private:
+  alignas(16) float weights[EVAL_FEATURES];
+};
+
+#endif  // ASSIGN2_EVALUATOR_H
@@ -1,9 +1,169 @@
 #include "FileHandler.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <vector>
 
+#include "GameState.h"
+#include "InputValidator.h"
+
+namespace {
+uint32_t checksum(const std::string& data, size_t length) {
+  uint32_t hash = 0x811C9DC5u;
+  for (size_t i = 0; i < length; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x01000193u;
+  }
+  return hash;
+}
+
+void putInt(std::string& out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+// Length-prefixed list of one-byte tiles
+void putTiles(std::string& out, LinkedList* tiles) {
+  putInt(out, static_cast<uint32_t>(tiles->getLength()), 2);
+  for (Node* node = tiles->getHead(); node != nullptr;
+       node = node->getNext()) {
+    Tile* tile = node->getTile();
+    out += static_cast<char>(
+        GameState::encodeTile(tile->getColour(), tile->getShape()));
+  }
+}
+
+/*
+ * Bounds-checked reads over a binary save; once a read runs past the end
+ * every later read fails too
+ */
+class BinaryReader {
+ public:
+  BinaryReader(const std::string& data, size_t end)
+      : data(data), pos(0), end(end), ok(true) {}
+
+  void skip(size_t bytes) { take(bytes); }
+
+  uint32_t readInt(int bytes) {
+    uint32_t value = 0;
+    if (take(bytes)) {
+      for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<uint32_t>(static_cast<uint8_t>(
+                     data[pos - bytes + i]))
+                 << (8 * i);
+      }
+    }
+    return value;
+  }
+
+  std::string readString(size_t length) {
+    return take(length) ? data.substr(pos - length, length) : "";
+  }
+
+  // Null for a byte that is not a tile code
+  Tile* readTile() {
+    uint32_t code = readInt(1);
+    if (code < 1 || code > NUM_TILE_KINDS) {
+      ok = false;
+      return nullptr;
+    }
+    TileCode tile = static_cast<TileCode>(code);
+    return new Tile(GameState::colourOf(tile), GameState::shapeOf(tile));
+  }
+
+  bool readTiles(std::vector<Tile*>& tiles) {
+    uint32_t count = readInt(2);
+    for (uint32_t i = 0; i < count && ok; ++i) {
+      Tile* tile = readTile();
+      if (tile) {
+        tiles.push_back(tile);
+      }
+    }
+    return ok;
+  }
+
+  bool good() const { return ok; }
+  bool atEnd() const { return ok && pos == end; }
+
+ private:
+  const std::string& data;
+  size_t pos;
+  size_t end;
+  bool ok;
+
+  bool take(size_t bytes) {
+    if (!ok || end - pos < bytes) {
+      ok = false;
+      return false;
+    }
+    pos += bytes;
+    return true;
+  }
+};
+
+void deleteTiles(std::vector<Tile*>& tiles) {
+  for (Tile* tile : tiles) {
+    delete tile;
+  }
+  tiles.clear();
+}
+
+/*
+ * Collects the items of a text save as InputValidator scans it. Nothing
+ * reaches the game until the whole save has been read, and whatever was
+ * built is freed if the scan fails.
+ */
+class TextSaveBuilder : public SaveTextHandler {
+ public:
+  ~TextSaveBuilder() override {
+    deleteTiles(hands[0]);
+    deleteTiles(hands[1]);
+    deleteTiles(bag);
+  }
+
+  void player(int index, const char* name, size_t length,
+              int score) override {
+    names[index].assign(name, length);
+    scores[index] = score;
+  }
+
+  void handTile(int index, char colour, int shape) override {
+    hands[index].push_back(new Tile(colour, shape));
+  }
+
+  void boardSize(int rows, int cols) override {
+    board.reset(new GameBoard(rows, cols));
+  }
+
+  // A cell may hold only one tile
+  bool boardTile(int row, int col, char colour, int shape) override {
+    return board->placeTile(row, col, new Tile(colour, shape));
+  }
+
+  void bagTile(char colour, int shape) override {
+    bag.push_back(new Tile(colour, shape));
+  }
+
+  void currentPlayer(const char* name, size_t length) override {
+    current.assign(name, length);
+  }
+
+  std::string names[2];
+  int scores[2] = {0, 0};
+  std::vector<Tile*> hands[2];
+  std::vector<Tile*> bag;
+  std::unique_ptr<GameBoard> board;
+  std::string current;
+};
+}  // namespace
+
 /*
  * Helper function to convert LinkedList to std::vector
  * This function iterates through the linked list, extracts each tile,
@@ -37,122 +197,123 @@ void FileHandler::vectorToLinkedList(const std::vector<Tile*>& vec,
  * This function serializes the players, board, tile bag,
  * and current player, then writes them to a file.
  */
-void FileHandler::saveGame(const std::string& filename, Player* player1,
+bool FileHandler::saveGame(const std::string& filename, Player* player1,
                            Player* player2, TileBag* tileBag, GameBoard* board,
-                           Player* currentPlayer) {
-  std::ofstream outFile(filename);
-  if (outFile.is_open()) {
-    outFile << serialisePlayer(player1) << std::endl;
-    outFile << serialisePlayer(player2) << std::endl;
-    outFile << serialiseBoard(board) << std::endl;
-    outFile << serialiseTileBag(tileBag) << std::endl;
-    outFile << serialiseCurrentPlayer(currentPlayer);
-    outFile.close();
-    std::cout << "Game successfully saved" << std::endl;
-  } else {
-    std::cerr << "Error: Unable to open file for writing" << std::endl;
+                           Player* currentPlayer, SaveFormat format) {
+  return writeFile(filename,
+                   serialise(player1, player2, tileBag, board, currentPlayer,
+                             format),
+                   lastError);
+}
+
+/*
+ * Serialize the whole game in either format
+ */
+std::string FileHandler::serialise(Player* player1, Player* player2,
+                                   TileBag* tileBag, GameBoard* board,
+                                   Player* currentPlayer, SaveFormat format) {
+  if (format == SAVE_BINARY) {
+    return serialiseBinary(player1, player2, tileBag, board, currentPlayer);
+  }
+  return serialisePlayer(player1) + "\n" + serialisePlayer(player2) + "\n" +
+         serialiseBoard(board) + "\n" + serialiseTileBag(tileBag) + "\n" +
+         serialiseCurrentPlayer(currentPlayer);
+}
+
+/*
+ * Write a file so that a crash leaves either the old or the new contents
+ * The data goes to a temporary file beside the target, is synced to
+ * disk, and then renamed over the target; the directory is synced last
+ * so the rename itself survives a crash.
+ */
+bool FileHandler::writeFile(const std::string& filename,
+                            const std::string& data, std::string& error) {
+  std::string temp = filename + SAVE_TEMP_SUFFIX;
+  int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    error = "Error: Unable to open file for writing";
+    return false;
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t step = ::write(fd, data.data() + written, data.size() - written);
+    if (step < 0 && errno == EINTR) {
+      continue;
+    }
+    if (step <= 0) {
+      break;
+    }
+    written += static_cast<size_t>(step);
   }
+  bool synced = written == data.size() && ::fsync(fd) == 0;
+  bool closed = ::close(fd) == 0;
+  if (!synced || !closed || std::rename(temp.c_str(), filename.c_str()) != 0) {
+    std::remove(temp.c_str());
+    error = "Error: Unable to write file " + filename;
+    return false;
+  }
+
+  size_t slash = filename.find_last_of('/');
+  std::string directory =
+      slash == std::string::npos ? "." : filename.substr(0, slash + 1);
+  int dirFd = ::open(directory.c_str(), O_RDONLY);
+  if (dirFd >= 0) {
+    ::fsync(dirFd);
+    ::close(dirFd);
+  }
+  return true;
 }
 
 /*
  * Load the game state from a file
- * This function reads the serialized players, board, tile bag,
- * and current player from a file and deserializes them.
- * THE BELOW INCLUDES PRINT OUTS TO CHECK FILE IS READING
- * CORRECTLY AND MAY BE DELETED AND THE ABOVE FUNCTION USED
- * INSTEAD.
+ * The file is read once into memory; the binary magic picks the binary
+ * parser, anything else goes to the single-pass text parser. Nothing is
+ * changed unless the whole file parses.
  */
 bool FileHandler::loadGame(const std::string& filename, Player* player1,
                            Player* player2, TileBag* tileBag, GameBoard*& board,
                            Player* currentPlayer) {
-  std::ifstream inFile(filename);
-  if (inFile.is_open()) {
-    std::string player1Data, player2Data, boardData, tileBagData,
-        currentPlayerData;
-
-    // Read and deserialize Player 1
-    std::getline(inFile, player1Data);
-    std::string player1Score;
-    std::getline(inFile, player1Score);
-    player1Data += "\n" + player1Score;
-
-    std::string player1Hand;
-    std::getline(inFile, player1Hand);
-    player1Data += "\n" + player1Hand;
-
-    // std::cout << "Player 1 Data: " << player1Data << std::endl;
-    deserialisePlayer(player1, player1Data);
-
-    // Read and deserialize Player 2
-    std::getline(inFile, player2Data);
-    std::string player2Score;
-    std::getline(inFile, player2Score);
-    player2Data += "\n" + player2Score;
-
-    std::string player2Hand;
-    std::getline(inFile, player2Hand);
-    player2Data += "\n" + player2Hand;
-
-    // std::cout << "Player 2 Data: " << player2Data << std::endl;
-    deserialisePlayer(player2, player2Data);
-
-    // Read and deserialize Board
-    std::getline(inFile, boardData);
-    std::string boardTiles;
-    std::getline(inFile, boardTiles);
-    boardData += "\n" + boardTiles;
-
-    // Create a new GameBoard with the deserialized data
-    GameBoard* newBoard = deserialiseBoard(boardData);
-    if (newBoard) {
-      if (board) {
-        // Clean up the old board if it exists
-        delete board;
-        // Set to nullptr after deletion to avoid dangling pointer
-        board = nullptr;
-      }
-      board = newBoard;
-    } else {
-      std::cerr << "Error: Invalid board data" << std::endl;
-      inFile.close();
-      return false;
-    }
-
-    // Read and deserialize Tile Bag
-    std::getline(inFile, tileBagData);
-    // std::cout << "Tile Bag Data: " << tileBagData << std::endl;
-    deserialiseTileBag(tileBag, tileBagData);
-
-    // Read and deserialize Current Player
-    std::getline(inFile, currentPlayerData);
-    // std::cout << "Current Player Data: " << currentPlayerData << std::endl;
-    deserialiseCurrentPlayer(currentPlayer, currentPlayerData);
-
-    inFile.close();
-    return true;
-  } else {
-    std::cerr << "Error: Unable to open file for reading" << std::endl;
+  lastError.clear();
+  std::ifstream inFile(filename, std::ios::binary);
+  if (!inFile.is_open()) {
+    lastError = "Error: Unable to open file for reading";
     return false;
   }
+  std::string data((std::istreambuf_iterator<char>(inFile)),
+                   std::istreambuf_iterator<char>());
+  if (data.compare(0, BINARY_SAVE_MAGIC_SIZE, BINARY_SAVE_MAGIC) == 0) {
+    return deserialiseBinary(data, player1, player2, tileBag, board,
+                             currentPlayer);
+  }
+  return deserialiseText(data, player1, player2, tileBag, board,
+                         currentPlayer);
 }
 
 /*
  * Check if a file exists
  * This function tries to open a file and returns true if successful.
  */
+const std::string& FileHandler::getLastError() const { return lastError; }
+
 bool FileHandler::fileExists(const std::string& filename) {
   std::ifstream file(filename);
   return file.good();
 }
 
+SaveFormat FileHandler::formatFor(const std::string& filename) {
+  const std::string extension = BINARY_SAVE_EXTENSION;
+  bool binary = filename.size() > extension.size() &&
+                filename.compare(filename.size() - extension.size(),
+                                 extension.size(), extension) == 0;
+  return binary ? SAVE_BINARY : SAVE_TEXT;
+}
+
 /*
  * Method to read file content into a string.
  */
 std::string FileHandler::readFileContent(const std::string& filename) const {
   std::ifstream inFile(filename);
   if (!inFile.is_open()) {
-    std::cerr << "Error: Unable to open file for reading" << std::endl;
-
     return "";
   }
 
@@ -253,158 +414,168 @@ std::string FileHandler::serialiseCurrentPlayer(Player* currentPlayer) {
 }
 
 /*
- * Deserialize a Player object from a string
- * This function extracts the player's name, score, and hand
- * from a string representation.
+ * Serialize the whole game to the binary format
+ * Sizes are known up front, so the buffer is reserved once and the
+ * checksum is appended after everything else.
  */
-void FileHandler::deserialisePlayer(Player* player, const std::string& data) {
-  size_t pos = 0;
-  size_t nextPos = data.find('\n', pos);
-  std::string name = data.substr(pos, nextPos - pos);
-  player->setName(name);
-
-  pos = nextPos + 1;
-  nextPos = data.find('\n', pos);
-  int score = std::stoi(data.substr(pos, nextPos - pos));
-  player->setScore(score);
-
-  pos = nextPos + 1;
-  std::string handData = data.substr(pos);
-  std::vector<Tile*> hand;
-  size_t start = 0;
-  size_t end = handData.find(',', start);
-  while (end != std::string::npos) {
-    std::string tileData = handData.substr(start, end - start);
-    Colour colour = tileData[0];
-    Shape shape = std::stoi(tileData.substr(1));
-    hand.push_back(new Tile(colour, shape));
-
-    start = end + 1;
-    end = handData.find(',', start);
-  }
-  if (start < handData.length()) {  // Last tile
-    std::string tileData = handData.substr(start);
-    Colour colour = tileData[0];
-    Shape shape = std::stoi(tileData.substr(1));
-    hand.push_back(new Tile(colour, shape));
-  }
-  vectorToLinkedList(hand, player->getHand());
-}
-
-/*
- * Deserialize a TileBag object from a string
- * This function extracts the tiles from a string representation
- * and adds them to the tile bag.
- */
-void FileHandler::deserialiseTileBag(TileBag* tileBag,
-                                     const std::string& data) {
-  std::vector<Tile*> tiles;
-  size_t start = 0;
-  size_t end = data.find(',', start);
-  while (end != std::string::npos) {
-    std::string tileEntry = data.substr(start, end - start);
-    Colour colour = tileEntry[0];
-    Shape shape = std::stoi(tileEntry.substr(1));
-    tiles.push_back(new Tile(colour, shape));
-    start = end + 1;
-    end = data.find(',', start);
-  }
-  if (start < data.length()) {  // Last tile
-    std::string tileEntry = data.substr(start);
-    Colour colour = tileEntry[0];
-    Shape shape = std::stoi(tileEntry.substr(1));
-    tiles.push_back(new Tile(colour, shape));
-  }
-  vectorToLinkedList(tiles, tileBag->getTiles());
-}
-
-/*
- * Deserialize a GameBoard object from a string
- * This function extracts the board size and tiles
- * from a string representation and sets up the board.
- */
-GameBoard* FileHandler::deserialiseBoard(const std::string& data) {
-  size_t pos = 0;
-  size_t nextPos = data.find('\n', pos);
-  std::string sizeData = data.substr(pos, nextPos - pos);
-  size_t commaPos = sizeData.find(',');
-  if (commaPos == std::string::npos) {
-    std::cerr << "Error: Invalid board size format" << std::endl;
-    return nullptr;
-  }
-
-  int rows = std::stoi(sizeData.substr(0, commaPos));
-  int cols = std::stoi(sizeData.substr(commaPos + 1));
-
-  // Create a new GameBoard with the specified size
-  GameBoard* board = new GameBoard(rows, cols);
-
-  pos = nextPos + 1;
-  std::string boardData = data.substr(pos);
-  size_t start = 0;
-  size_t end = boardData.find(',', start);
-  while (end != std::string::npos) {
-    std::string tileData = boardData.substr(start, end - start);
-    Colour colour = tileData[0];
-    size_t atPos = tileData.find('@');
-    if (atPos == std::string::npos) {
-      std::cerr << "Error: Invalid tile data format - " << tileData
-                << std::endl;
-      return nullptr;
+std::string FileHandler::serialiseBinary(Player* player1, Player* player2,
+                                         TileBag* tileBag, GameBoard* board,
+                                         Player* currentPlayer) {
+  int cells = 0;
+  for (int row = 0; row < board->getRows(); ++row) {
+    for (int col = 0; col < board->getCols(); ++col) {
+      if (board->getTile(row, col)) {
+        cells++;
+      }
     }
+  }
+  std::string result;
+  result.reserve(BINARY_SAVE_MAGIC_SIZE + 1 + player1->getName().size() +
+                 player2->getName().size() + 2 * 8 +
+                 player1->getHand()->getLength() +
+                 player2->getHand()->getLength() + 4 + 3 * cells + 2 +
+                 tileBag->getTiles()->getLength() + 1 + 4);
+  result += BINARY_SAVE_MAGIC;
+  putInt(result, BINARY_SAVE_VERSION, 1);
+
+  for (Player* player : {player1, player2}) {
+    putInt(result, static_cast<uint32_t>(player->getName().size()), 2);
+    result += player->getName();
+    putInt(result, static_cast<uint32_t>(player->getScore()), 4);
+    putTiles(result, player->getHand());
+  }
 
-    Shape shape = std::stoi(tileData.substr(1, atPos - 1));
-    std::string position = tileData.substr(atPos + 1);
-
-    if (position.length() < 2) {
-      std::cerr << "Error: Invalid tile position format - " << position
-                << std::endl;
-      return nullptr;
+  putInt(result, static_cast<uint32_t>(board->getRows()), 1);
+  putInt(result, static_cast<uint32_t>(board->getCols()), 1);
+  putInt(result, static_cast<uint32_t>(cells), 2);
+  for (int row = 0; row < board->getRows(); ++row) {
+    for (int col = 0; col < board->getCols(); ++col) {
+      Tile* tile = board->getTile(row, col);
+      if (tile) {
+        putInt(result, static_cast<uint32_t>(row), 1);
+        putInt(result, static_cast<uint32_t>(col), 1);
+        result += static_cast<char>(
+            GameState::encodeTile(tile->getColour(), tile->getShape()));
+      }
     }
+  }
 
-    int row = position[0] - 'A';
-    int col = std::stoi(position.substr(1));
-    board->placeTile(row, col, new Tile(colour, shape));
+  putTiles(result, tileBag->getTiles());
+  putInt(result, currentPlayer->getName() == player1->getName() ? 0 : 1, 1);
+  putInt(result, checksum(result, result.size()), 4);
+  return result;
+}
 
-    start = end + 1;
-    end = boardData.find(',', start);
+/*
+ * Deserialize the whole game from the binary format
+ * Nothing is changed unless the checksum, version and every field are
+ * valid.
+ */
+bool FileHandler::deserialiseBinary(const std::string& data, Player* player1,
+                                    Player* player2, TileBag* tileBag,
+                                    GameBoard*& board,
+                                    Player* currentPlayer) {
+  if (data.size() < BINARY_SAVE_MAGIC_SIZE + 1 + 4) {
+    lastError = "Error: Truncated save file";
+    return false;
+  }
+  size_t body = data.size() - 4;
+  BinaryReader trailer(data, data.size());
+  trailer.skip(body);
+  if (trailer.readInt(4) != checksum(data, body)) {
+    lastError = "Error: Save file checksum mismatch";
+    return false;
   }
 
-  // Process the last tile data
-  if (start < boardData.length()) {
-    std::string tileData = boardData.substr(start);
-
-    Colour colour = tileData[0];
-    size_t atPos = tileData.find('@');
-    if (atPos == std::string::npos) {
-      std::cerr << "Error: Invalid tile data format - " << tileData
-                << std::endl;
-      return nullptr;
-    }
+  BinaryReader in(data, body);
+  in.skip(BINARY_SAVE_MAGIC_SIZE);
+  if (in.readInt(1) != BINARY_SAVE_VERSION) {
+    lastError = "Error: Unsupported save file version";
+    return false;
+  }
 
-    Shape shape = std::stoi(tileData.substr(1, atPos - 1));
-    std::string position = tileData.substr(atPos + 1);
+  std::string names[2];
+  int scores[2] = {0, 0};
+  std::vector<Tile*> hands[2];
+  for (int p = 0; p < 2; ++p) {
+    names[p] = in.readString(in.readInt(2));
+    scores[p] = static_cast<int>(in.readInt(4));
+    in.readTiles(hands[p]);
+  }
 
-    if (position.length() < 2) {
-      std::cerr << "Error: Invalid tile position format - " << position
-                << std::endl;
-      return nullptr;
+  int rows = static_cast<int>(in.readInt(1));
+  int cols = static_cast<int>(in.readInt(1));
+  std::unique_ptr<GameBoard> newBoard(new GameBoard(rows, cols));
+  uint32_t cells = in.readInt(2);
+  for (uint32_t i = 0; i < cells && in.good(); ++i) {
+    int row = static_cast<int>(in.readInt(1));
+    int col = static_cast<int>(in.readInt(1));
+    Tile* tile = in.readTile();
+    // Placing over a tile would drop the first one, so a repeated cell
+    // fails as it does in a text save
+    bool repeated = tile && newBoard->getTile(row, col) != nullptr;
+    if (tile && (repeated || !newBoard->placeTile(row, col, tile))) {
+      lastError = std::string("Error: ") +
+                  (repeated ? "Duplicate" : "Invalid") + " tile position - " +
+                  std::string(1, 'A' + row) + std::to_string(col);
+      delete tile;
+      deleteTiles(hands[0]);
+      deleteTiles(hands[1]);
+      return false;
     }
+  }
 
-    int row = position[0] - 'A';
-    int col = std::stoi(position.substr(1));
-    board->placeTile(row, col, new Tile(colour, shape));
+  std::vector<Tile*> bagTiles;
+  in.readTiles(bagTiles);
+  uint32_t mover = in.readInt(1);
+  if (!in.atEnd() || mover > 1) {
+    lastError = "Error: Invalid save file data";
+    deleteTiles(hands[0]);
+    deleteTiles(hands[1]);
+    deleteTiles(bagTiles);
+    return false;
   }
 
-  return board;
+  Player* players[2] = {player1, player2};
+  for (int p = 0; p < 2; ++p) {
+    players[p]->setName(names[p]);
+    players[p]->setScore(scores[p]);
+    vectorToLinkedList(hands[p], players[p]->getHand());
+  }
+  vectorToLinkedList(bagTiles, tileBag->getTiles());
+  delete board;
+  board = newBoard.release();
+  currentPlayer->setName(names[mover]);
+  return true;
 }
 
 /*
- * Deserialize the current player from a string
- * This function sets the current player's name
- * from a string representation.
+ * Deserialize the whole game from the text format
+ * Lines are read in file order: each player's name, score and hand, the
+ * board size and tiles, the tile bag, and the current player's name.
  */
-void FileHandler::deserialiseCurrentPlayer(Player* currentPlayer,
-                                           const std::string& data) {
-  currentPlayer->setName(data);
-}
\ No newline at end of file
+bool FileHandler::deserialiseText(const std::string& data, Player* player1,
+                                  Player* player2, TileBag* tileBag,
+                                  GameBoard*& board, Player* currentPlayer) {
+  TextSaveBuilder builder;
+  SaveFormatError error;
+  if (!InputValidator::scanSaveText(data.data(), data.size(), &builder,
+                                    error)) {
+    lastError = error.message();
+    return false;
+  }
+
+  Player* players[2] = {player1, player2};
+  for (int p = 0; p < 2; ++p) {
+    players[p]->setName(builder.names[p]);
+    players[p]->setScore(builder.scores[p]);
+    vectorToLinkedList(builder.hands[p], players[p]->getHand());
+    builder.hands[p].clear();
+  }
+  vectorToLinkedList(builder.bag, tileBag->getTiles());
+  builder.bag.clear();
+  delete board;
+  board = builder.board.release();
+  currentPlayer->setName(builder.current);
+  return true;
+}
@@ -1,31 +1,82 @@
 #ifndef ASSIGN2_FILEHANDLER_H
 #define ASSIGN2_FILEHANDLER_H
 
+#include <cstdint>
 #include <string>
 
 #include "GameBoard.h"
 #include "Player.h"
 #include "TileBag.h"
 
+// Binary saves: magic, format version, and the extension that selects
+// them
+#define BINARY_SAVE_MAGIC "QWKB"
+#define BINARY_SAVE_MAGIC_SIZE 4
+#define BINARY_SAVE_VERSION 1
+#define BINARY_SAVE_EXTENSION ".qwb"
+
+// Appended to the target name while a save is being written
+#define SAVE_TEMP_SUFFIX ".tmp"
+
+enum SaveFormat : uint8_t { SAVE_TEXT, SAVE_BINARY };
+
+/*
+ * Saved games in two formats. The text format is comma-separated lines,
+ * checked and read in the same pass by InputValidator::scanSaveText.
+ * The binary format is the magic and a version byte, then each player
+ * (name length, name, 32-bit score, hand), the board size and a sparse
+ * list of (row, col, tile) cells, the bag, the index of the player to
+ * move, and a 32-bit FNV-1a checksum of everything before it. Tiles take
+ * one byte as a GameState TileCode, and integers are little-endian.
+ * loadGame tells the formats apart by the magic.
+ *
+ * Saves go through writeFile, which replaces the target atomically, so
+ * a crash never leaves a half-written save behind.
+ */
 class FileHandler {
  public:
-  void saveGame(const std::string& filename, Player* player1, Player* player2,
-                TileBag* tileBag, GameBoard* board, Player* currentPlayer);
+  // False if the file cannot be written
+  bool saveGame(const std::string& filename, Player* player1, Player* player2,
+                TileBag* tileBag, GameBoard* board, Player* currentPlayer,
+                SaveFormat format = SAVE_TEXT);
   bool loadGame(const std::string& filename, Player* player1, Player* player2,
                 TileBag* tileBag, GameBoard*& board, Player* currentPlayer);
   static bool fileExists(const std::string& filename);
+  // SAVE_BINARY for names ending in BINARY_SAVE_EXTENSION
+  static SaveFormat formatFor(const std::string& filename);
   std::string readFileContent(const std::string& filename) const;
+  // Why the last save or load failed
+  const std::string& getLastError() const;
+
+  // The whole save in memory, so it can be written elsewhere or later
+  static std::string serialise(Player* player1, Player* player2,
+                               TileBag* tileBag, GameBoard* board,
+                               Player* currentPlayer, SaveFormat format);
+  // Replace 'filename' with 'data' through a synced temporary file and a
+  // rename; false with 'error' set if any step fails
+  static bool writeFile(const std::string& filename, const std::string& data,
+                        std::string& error);
+
+  // The binary format in memory, for callers keeping saves in their own
+  // files
+  static std::string serialiseBinary(Player* player1, Player* player2,
+                                     TileBag* tileBag, GameBoard* board,
+                                     Player* currentPlayer);
+  bool deserialiseBinary(const std::string& data, Player* player1,
+                         Player* player2, TileBag* tileBag, GameBoard*& board,
+                         Player* currentPlayer);
 
  private:
   static std::string serialisePlayer(Player* player);
   static std::string serialiseTileBag(TileBag* tileBag);
   static std::string serialiseBoard(GameBoard* board);
-  std::string serialiseCurrentPlayer(Player* currentPlayer);
+  static std::string serialiseCurrentPlayer(Player* currentPlayer);
+
+  bool deserialiseText(const std::string& data, Player* player1,
+                       Player* player2, TileBag* tileBag, GameBoard*& board,
+                       Player* currentPlayer);
 
-  static void deserialisePlayer(Player* player, const std::string& data);
-  static void deserialiseTileBag(TileBag* tileBag, const std::string& data);
-  GameBoard* deserialiseBoard(const std::string& data);
-  void deserialiseCurrentPlayer(Player* currentPlayer, const std::string& data);
+  std::string lastError;
 
   static std::vector<Tile*> linkedListToVector(LinkedList* list);
   static void vectorToLinkedList(const std::vector<Tile*>& vec,
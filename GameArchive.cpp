@@ -0,0 +1,407 @@
+#include "GameArchive.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#define ARCHIVE_HEADER_SIZE (ARCHIVE_MAGIC_SIZE + 1)
+
+namespace {
+void putVarint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out += static_cast<char>((value & 0x7F) | 0x80);
+    value >>= 7;
+  }
+  out += static_cast<char>(value);
+}
+
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void putFixed(std::string& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    out += static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+// Bounds-checked reads over the mapping; a failed read fails the rest
+struct Cursor {
+  const uint8_t* pos;
+  const uint8_t* end;
+  bool ok;
+
+  Cursor(const uint8_t* pos, const uint8_t* end)
+      : pos(pos), end(end), ok(pos <= end) {}
+
+  uint64_t varint() {
+    uint64_t value = 0;
+    for (int shift = 0; ok && shift < 64; shift += 7) {
+      if (pos == end) {
+        break;
+      }
+      uint8_t byte = *pos++;
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    ok = false;
+    return 0;
+  }
+
+  // The next 'length' bytes as a cursor of their own
+  Cursor take(uint64_t length) {
+    if (!ok || static_cast<uint64_t>(end - pos) < length) {
+      ok = false;
+      return Cursor(end, end);
+    }
+    Cursor part(pos, pos + length);
+    pos += length;
+    return part;
+  }
+
+  uint8_t byte() {
+    if (!ok || pos == end) {
+      ok = false;
+      return 0;
+    }
+    return *pos++;
+  }
+};
+
+uint64_t readFixed(const uint8_t* bytes, int count) {
+  uint64_t value = 0;
+  for (int i = 0; i < count; ++i) {
+    value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+}  // namespace
+
+ArchivedGame::ArchivedGame() : id(0), date(0), seed(0), enhanced(false) {}
+
+ArchiveWriter::ArchiveWriter() : offset(0) {}
+
+ArchiveWriter::~ArchiveWriter() { close(); }
+
+bool ArchiveWriter::open(const std::string& path) {
+  out.open(path, std::ios::binary | std::ios::trunc);
+  out << ARCHIVE_MAGIC << static_cast<char>(ARCHIVE_VERSION);
+  offset = ARCHIVE_HEADER_SIZE;
+  block.clear();
+  blockOffsets.clear();
+  entries.clear();
+  return static_cast<bool>(out);
+}
+
+bool ArchiveWriter::add(const ArchivedGame& game) {
+  if (!out.is_open()) {
+    return false;
+  }
+  block.push_back(game);
+  entries.push_back({game.id, game.date, {game.names[0], game.names[1]}});
+  if (block.size() == ARCHIVE_BLOCK_GAMES) {
+    return flushBlock();
+  }
+  return static_cast<bool>(out);
+}
+
+bool ArchiveWriter::flushBlock() {
+  if (block.empty()) {
+    return static_cast<bool>(out);
+  }
+  std::string columns[6];
+  std::string& games = columns[0];
+  std::string& types = columns[1];
+  std::string& tiles = columns[2];
+  std::string& rows = columns[3];
+  std::string& cols = columns[4];
+  std::string& starts = columns[5];
+  for (const ArchivedGame& game : block) {
+    putVarint(games, game.seed);
+    putVarint(games, game.moves.size());
+    putVarint(games, game.start.size());
+    if (!game.start.empty()) {
+      putVarint(games, game.enhanced);
+      starts += game.start;
+    }
+    int previousRow = 0;
+    int previousCol = 0;
+    for (size_t m = 0; m < game.moves.size(); ++m) {
+      const Move& move = game.moves[m];
+      bool joined = m < game.joined.size() && game.joined[m];
+      types += static_cast<char>(move.type |
+                                 (joined ? ARCHIVE_JOINED_MOVE : 0));
+      if (move.type != MOVE_PASS) {
+        tiles += static_cast<char>(move.tile);
+      }
+      if (move.type == MOVE_PLACE) {
+        putVarint(rows, zigzag(move.row - previousRow));
+        putVarint(cols, zigzag(move.col - previousCol));
+        previousRow = move.row;
+        previousCol = move.col;
+      }
+    }
+  }
+
+  std::string data;
+  putVarint(data, block.size());
+  for (const std::string& column : columns) {
+    putVarint(data, column.size());
+    data += column;
+  }
+  blockOffsets.push_back(offset);
+  out.write(data.data(), data.size());
+  offset += data.size();
+  block.clear();
+  return static_cast<bool>(out);
+}
+
+bool ArchiveWriter::close() {
+  if (!out.is_open()) {
+    return false;
+  }
+  flushBlock();
+  std::string index;
+  putVarint(index, blockOffsets.size());
+  uint64_t previousOffset = 0;
+  for (uint64_t blockOffset : blockOffsets) {
+    putVarint(index, blockOffset - previousOffset);
+    previousOffset = blockOffset;
+  }
+  uint64_t previousId = 0;
+  int64_t previousDate = 0;
+  for (const ArchiveEntry& entry : entries) {
+    putVarint(index, zigzag(static_cast<int64_t>(entry.id - previousId)));
+    putVarint(index, zigzag(entry.date - previousDate));
+    previousId = entry.id;
+    previousDate = entry.date;
+    for (const std::string& name : entry.names) {
+      putVarint(index, name.size());
+      index += name;
+    }
+  }
+  putFixed(index, offset, 8);
+  putFixed(index, entries.size(), 4);
+  index += ARCHIVE_MAGIC;
+  out.write(index.data(), index.size());
+  out.close();
+  bool written = !out.fail();
+  entries.clear();
+  blockOffsets.clear();
+  return written;
+}
+
+ArchiveReader::ArchiveReader() : mapping(nullptr), mappingBytes(0) {}
+
+ArchiveReader::~ArchiveReader() { close(); }
+
+bool ArchiveReader::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) <
+          ARCHIVE_HEADER_SIZE + ARCHIVE_TRAILER_SIZE) {
+    ::close(fd);
+    return false;
+  }
+  size_t bytes = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+  // Scans read every block once, front to back
+  madvise(mapped, bytes, MADV_SEQUENTIAL);
+  mapping = mapped;
+  mappingBytes = bytes;
+
+  const uint8_t* base = static_cast<const uint8_t*>(mapped);
+  const uint8_t* trailer = base + bytes - ARCHIVE_TRAILER_SIZE;
+  uint64_t indexOffset = readFixed(trailer, 8);
+  uint64_t count = readFixed(trailer + 8, 4);
+  bool valid =
+      std::memcmp(base, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) == 0 &&
+      base[ARCHIVE_MAGIC_SIZE] == ARCHIVE_VERSION &&
+      std::memcmp(trailer + 12, ARCHIVE_MAGIC, ARCHIVE_MAGIC_SIZE) == 0 &&
+      indexOffset >= ARCHIVE_HEADER_SIZE &&
+      indexOffset <= bytes - ARCHIVE_TRAILER_SIZE;
+
+  Cursor index(base + (valid ? indexOffset : 0), trailer);
+  uint64_t blockCount = valid ? index.varint() : 0;
+  valid = valid &&
+          blockCount == (count + ARCHIVE_BLOCK_GAMES - 1) / ARCHIVE_BLOCK_GAMES;
+  uint64_t blockOffset = 0;
+  for (uint64_t b = 0; valid && b < blockCount; ++b) {
+    blockOffset += index.varint();
+    valid = index.ok && blockOffset >= ARCHIVE_HEADER_SIZE &&
+            blockOffset < indexOffset;
+    blockOffsets.push_back(blockOffset);
+  }
+  blockOffsets.push_back(indexOffset);
+
+  uint64_t id = 0;
+  int64_t date = 0;
+  for (uint64_t g = 0; valid && g < count; ++g) {
+    id += static_cast<uint64_t>(unzigzag(index.varint()));
+    date += unzigzag(index.varint());
+    ArchiveEntry entry = {id, date, {"", ""}};
+    for (std::string& name : entry.names) {
+      Cursor text = index.take(index.varint());
+      name.assign(text.pos, text.end);
+    }
+    valid = index.ok;
+    byId[id] = entries.size();
+    entries.push_back(std::move(entry));
+  }
+  if (!valid) {
+    close();
+  }
+  return valid;
+}
+
+void ArchiveReader::close() {
+  if (mapping != nullptr) {
+    munmap(mapping, mappingBytes);
+  }
+  mapping = nullptr;
+  mappingBytes = 0;
+  blockOffsets.clear();
+  entries.clear();
+  byId.clear();
+}
+
+bool ArchiveReader::isOpen() const { return mapping != nullptr; }
+
+size_t ArchiveReader::size() const { return entries.size(); }
+
+size_t ArchiveReader::blocks() const {
+  return blockOffsets.empty() ? 0 : blockOffsets.size() - 1;
+}
+
+size_t ArchiveReader::bytes() const { return mappingBytes; }
+
+const ArchiveEntry& ArchiveReader::entry(size_t game) const {
+  return entries[game];
+}
+
+bool ArchiveReader::find(uint64_t id, size_t& game) const {
+  auto found = byId.find(id);
+  if (found == byId.end()) {
+    return false;
+  }
+  game = found->second;
+  return true;
+}
+
+bool ArchiveReader::readGame(size_t game, ArchivedGame& out) const {
+  if (game >= entries.size()) {
+    return false;
+  }
+  std::vector<ArchivedGame> games;
+  if (!readBlock(game / ARCHIVE_BLOCK_GAMES, games)) {
+    return false;
+  }
+  out = std::move(games[game % ARCHIVE_BLOCK_GAMES]);
+  return true;
+}
+
+bool ArchiveReader::readBlock(size_t block,
+                              std::vector<ArchivedGame>& out) const {
+  out.clear();
+  if (block >= blocks()) {
+    return false;
+  }
+  const uint8_t* base = static_cast<const uint8_t*>(mapping);
+  Cursor data(base + blockOffsets[block], base + blockOffsets[block + 1]);
+  uint64_t count = data.varint();
+  size_t first = block * ARCHIVE_BLOCK_GAMES;
+  // Every block but the last is full, and the index says how many
+  // games the last one holds
+  if (!data.ok || first >= entries.size() ||
+      count != std::min<uint64_t>(ARCHIVE_BLOCK_GAMES,
+                                  entries.size() - first)) {
+    return false;
+  }
+  Cursor games = data.take(data.varint());
+  Cursor types = data.take(data.varint());
+  Cursor tiles = data.take(data.varint());
+  Cursor rows = data.take(data.varint());
+  Cursor cols = data.take(data.varint());
+  Cursor starts = data.take(data.varint());
+
+  out.resize(count);
+  for (size_t g = 0; g < count; ++g) {
+    ArchivedGame& game = out[g];
+    const ArchiveEntry& entry = entries[first + g];
+    game.id = entry.id;
+    game.date = entry.date;
+    game.names[0] = entry.names[0];
+    game.names[1] = entry.names[1];
+    game.seed = games.varint();
+    uint64_t moves = games.varint();
+    Cursor start = starts.take(games.varint());
+    game.start.assign(start.pos, start.end);
+    game.enhanced = !game.start.empty() && games.varint() != 0;
+    if (!games.ok || !starts.ok ||
+        moves > static_cast<uint64_t>(types.end - types.pos)) {
+      return false;
+    }
+    game.moves.resize(moves);
+    game.joined.clear();
+    int row = 0;
+    int col = 0;
+    for (size_t m = 0; m < moves; ++m) {
+      Move& move = game.moves[m];
+      uint8_t type = types.byte();
+      bool joined = (type & ARCHIVE_JOINED_MOVE) != 0;
+      type &= ~ARCHIVE_JOINED_MOVE;
+      if (type > MOVE_PASS) {
+        return false;
+      }
+      if (joined) {
+        // Only a placement can join, and only the placement before it
+        if (type != MOVE_PLACE || m == 0 ||
+            game.moves[m - 1].type != MOVE_PLACE) {
+          return false;
+        }
+        game.joined.resize(moves);
+        game.joined[m] = true;
+      }
+      move.type = static_cast<MoveType>(type);
+      move.tile = EMPTY_CELL;
+      move.row = 0;
+      move.col = 0;
+      if (move.type != MOVE_PASS) {
+        move.tile = tiles.byte();
+        if (move.tile < 1 || move.tile > NUM_TILE_KINDS) {
+          return false;
+        }
+      }
+      if (move.type == MOVE_PLACE) {
+        row += static_cast<int>(unzigzag(rows.varint()));
+        col += static_cast<int>(unzigzag(cols.varint()));
+        move.row = static_cast<int16_t>(row);
+        move.col = static_cast<int16_t>(col);
+      }
+    }
+  }
+  return games.ok && types.ok && tiles.ok && rows.ok && cols.ok &&
+         starts.ok;
+}
@@ -0,0 +1,129 @@
+#ifndef ASSIGN2_GAMEARCHIVE_H
+#define ASSIGN2_GAMEARCHIVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GameState.h"
+
+#define ARCHIVE_MAGIC "QWKA"
+#define ARCHIVE_MAGIC_SIZE 4
+#define ARCHIVE_VERSION 2
+
+// Games per block; a block is the unit that is decoded at once
+#define ARCHIVE_BLOCK_GAMES 256
+
+// Fixed trailer: u64 index offset, u32 game count, magic
+#define ARCHIVE_TRAILER_SIZE (8 + 4 + ARCHIVE_MAGIC_SIZE)
+
+// Set on a move type byte when the move joins the one before it
+#define ARCHIVE_JOINED_MOVE 0x80
+
+// One finished game: who played, when, the deal and every move
+struct ArchivedGame {
+  uint64_t id;
+  // Seconds since the Unix epoch
+  int64_t date;
+  std::string names[2];
+  // GameState::newGame(seed) is the position before the first move,
+  // unless 'start' is set
+  uint64_t seed;
+  std::vector<Move> moves;
+  // Games played through GameEngine, which have no seed: the binary save
+  // the moves start from, so the hands and bag order are kept, and the
+  // rules they were played under. Empty for a self-play game.
+  std::string start;
+  bool enhanced;
+  // Engine games: joined[i] when moves[i] was placed with moves[i - 1]
+  // as one placeAll move. Empty when no move was.
+  std::vector<bool> joined;
+
+  ArchivedGame();
+};
+
+// What the index holds for each game, available without decoding blocks
+struct ArchiveEntry {
+  uint64_t id;
+  int64_t date;
+  std::string names[2];
+};
+
+/*
+ * Streaming writer for game archives. The file is the magic and a
+ * version byte, then blocks of up to ARCHIVE_BLOCK_GAMES games, then the
+ * index and a fixed trailer pointing at it.
+ *
+ * A block is stored column by column: the seed, move count and start
+ * size of each game, then every move type, every tile, the rows and
+ * columns of the placements, and the start positions of engine games,
+ * each column prefixed by its length in bytes. Numbers are varints and
+ * placement rows and columns are zigzag deltas from the game's previous
+ * placement, so a typical move takes about four bytes.
+ * The index lists each block's offset and each game's id, date and
+ * player names, delta-encoded where it helps.
+ */
+class ArchiveWriter {
+ public:
+  ArchiveWriter();
+  ~ArchiveWriter();
+
+  ArchiveWriter(const ArchiveWriter& other) = delete;
+  ArchiveWriter& operator=(const ArchiveWriter& other) = delete;
+
+  bool open(const std::string& path);
+  bool add(const ArchivedGame& game);
+  // Write the last block, the index and the trailer
+  bool close();
+
+ private:
+  std::ofstream out;
+  uint64_t offset;
+  std::vector<ArchivedGame> block;
+  std::vector<uint64_t> blockOffsets;
+  std::vector<ArchiveEntry> entries;
+
+  bool flushBlock();
+};
+
+/*
+ * Read-only view of an archive, memory-mapped like the opening book.
+ * The index is decoded once on open; games are decoded a block at a
+ * time straight from the mapping, so game N costs one block and a full
+ * scan reads the file front to back.
+ */
+class ArchiveReader {
+ public:
+  ArchiveReader();
+  ~ArchiveReader();
+
+  ArchiveReader(const ArchiveReader& other) = delete;
+  ArchiveReader& operator=(const ArchiveReader& other) = delete;
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const;
+
+  size_t size() const;
+  size_t blocks() const;
+  size_t bytes() const;
+  const ArchiveEntry& entry(size_t game) const;
+  // Position of the game with this id; false if there is none
+  bool find(uint64_t id, size_t& game) const;
+
+  bool readGame(size_t game, ArchivedGame& out) const;
+  // Every game of a block, in archive order
+  bool readBlock(size_t block, std::vector<ArchivedGame>& out) const;
+
+ private:
+  void* mapping;
+  size_t mappingBytes;
+  std::vector<uint64_t> blockOffsets;
+  std::vector<ArchiveEntry> entries;
+  std::unordered_map<uint64_t, size_t> byId;
+};
+
+#endif  // ASSIGN2_GAMEARCHIVE_H
@@ -1,6 +1,6 @@
 #include "GameBoard.h"
 
-#include <iostream>
+#include <algorithm>
 #include <sstream>
 
 #include "Tile.h"
@@ -95,13 +95,12 @@ GameBoard& GameBoard::operator=(GameBoard&& other) {
 }
 
 // Place a tile on the board
-void GameBoard::placeTile(int row, int col, Tile* tile) {
+bool GameBoard::placeTile(int row, int col, Tile* tile) {
   if (row >= 0 && row < rows && col >= 0 && col < cols) {
     board[row][col] = tile;
-  } else {
-    std::cout << "Invalid position [" << row << "][" << col
-              << "] for placing tile." << std::endl;
+    return true;
   }
+  return false;
 }
 
 // Get a tile from the board
@@ -109,8 +108,6 @@ Tile* GameBoard::getTile(int row, int col) const {
   if (row >= 0 && row < rows && col >= 0 && col < cols) {
     return board[row][col];
   }
-  std::cout << "Invalid position [" << row << "][" << col
-            << "] for accessing tile." << std::endl;
   return nullptr;
 }
 
@@ -122,12 +119,25 @@ int GameBoard::getCols() const { return cols; }
 
 // Display the board as a string - enhanced function
 std::string GameBoard::displayBoard(bool enhanced) const {
+  return displayBoard(enhanced, {0, 0, rows, cols});
+}
+
+std::string GameBoard::displayBoard(bool enhanced,
+                                    const BoardView& view) const {
+  int top = std::max(view.top, 0);
+  int left = std::max(view.left, 0);
+  int bottom = std::min(view.top + view.rows, rows);
+  int right = std::min(view.left + view.cols, cols);
   std::string output;
-  std::string dashes = "\n--";
+
+  // Row headers are padded to the widest one in view
+  size_t labelWidth = bottom > top ? rowLabel(bottom - 1).size() : 1;
+  std::string padding(labelWidth - 1, ' ');
+  std::string dashes = "\n" + padding + "--";
 
   // Print column headers
-  output += "   ";
-  for (int col = 0; col < cols; ++col) {
+  output += "   " + padding;
+  for (int col = left; col < right; ++col) {
     // Uses extra spacing for 0-9 for correct formatting
     if (col < 9) {
       output += std::to_string(col) + "  ";
@@ -142,9 +152,10 @@ std::string GameBoard::displayBoard(bool enhanced) const {
   // Appends the dash spacing beneath row header
   output += dashes + "\n";
   // Print each row with its row header
-  for (int row = 0; row < rows; ++row) {
-    output += std::string(1, 'A' + row) + "|";
-    for (int col = 0; col < cols; ++col) {
+  for (int row = top; row < bottom; ++row) {
+    std::string label = rowLabel(row);
+    output += label + std::string(labelWidth - label.size(), ' ') + "|";
+    for (int col = left; col < right; ++col) {
       if (board[row][col] != nullptr) {
         if (enhanced) {
           // Use color codes for enhanced display
@@ -163,6 +174,39 @@ std::string GameBoard::displayBoard(bool enhanced) const {
   return output;
 }
 
+BoardView GameBoard::occupiedView(int margin) const {
+  int top = rows;
+  int bottom = -1;
+  int left = cols;
+  int right = -1;
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      if (board[row][col] != nullptr) {
+        top = std::min(top, row);
+        bottom = std::max(bottom, row);
+        left = std::min(left, col);
+        right = std::max(right, col);
+      }
+    }
+  }
+  if (bottom < 0) {
+    return {0, 0, rows, cols};
+  }
+  top = std::max(top - margin, 0);
+  left = std::max(left - margin, 0);
+  bottom = std::min(bottom + margin, rows - 1);
+  right = std::min(right + margin, cols - 1);
+  return {top, left, bottom - top + 1, right - left + 1};
+}
+
+std::string GameBoard::rowLabel(int row) {
+  std::string label;
+  for (int n = row + 1; n > 0; n = (n - 1) / 26) {
+    label.insert(label.begin(), static_cast<char>('A' + (n - 1) % 26));
+  }
+  return label;
+}
+
 // Check if the board is empty
 bool GameBoard::isEmpty() const {
   for (int row = 0; row < rows; ++row) {
@@ -177,8 +221,6 @@ bool GameBoard::isEmpty() const {
 
 // Resize the board
 void GameBoard::resize(int newRows, int newCols) {
-  std::cout << "Resizing board to " << newRows << "x" << newCols << "."
-            << std::endl;
   board.resize(newRows);
   for (auto& row : board) {
     row.resize(newCols, nullptr);
@@ -6,6 +6,17 @@
 
 #include "Tile.h"
 
+// Empty rows and columns shown around the played area by occupiedView
+#define BOARD_VIEW_MARGIN 1
+
+// A rectangle of cells to display, from row 'top' and column 'left'
+struct BoardView {
+  int top;
+  int left;
+  int rows;
+  int cols;
+};
+
 class GameBoard {
  public:
   GameBoard();
@@ -23,15 +34,26 @@ class GameBoard {
   // Move assignment operator
   GameBoard& operator=(GameBoard&& other);
 
-  // Place a tile at a specific position
-  void placeTile(int row, int col, Tile* tile);
+  // Place a tile at a specific position; false if it is off the board
+  bool placeTile(int row, int col, Tile* tile);
 
-  // Get the tile at a specific position
+  // Get the tile at a specific position, nullptr if it is off the board
   Tile* getTile(int row, int col) const;
 
   // Display the board
   std::string displayBoard(bool enhanced) const;
 
+  // Display only the cells in 'view', clipped to the board, so the output
+  // grows with the view rather than the board
+  std::string displayBoard(bool enhanced, const BoardView& view) const;
+
+  // The occupied cells plus 'margin' on every side, clipped to the board;
+  // the whole board while it is empty
+  BoardView occupiedView(int margin) const;
+
+  // Row header: A-Z, then AA, AB and so on for boards past 26 rows
+  static std::string rowLabel(int row);
+
   // Getters for rows and cols
   int getRows() const;
   int getCols() const;
@@ -0,0 +1,345 @@
+#include "GameEngine.h"
+
+#include <utility>
+#include <vector>
+
+#include "BackgroundSaver.h"
+#include "FileHandler.h"
+#include "GameLog.h"
+#include "Rules.h"
+
+namespace {
+void mix(uint64_t& hash, uint8_t byte) {
+  hash = (hash ^ byte) * 0x100000001B3ULL;
+}
+
+void mixTiles(uint64_t& hash, LinkedList* tiles) {
+  for (Node* node = tiles->getHead(); node != nullptr;
+       node = node->getNext()) {
+    mix(hash, static_cast<uint8_t>(node->getTile()->getColour()));
+    mix(hash, static_cast<uint8_t>(node->getTile()->getShape()));
+  }
+  // Ends the list, so moving a tile between lists changes the digest
+  mix(hash, 0);
+}
+
+int countTile(LinkedList* tiles, const Tile& tile) {
+  int count = 0;
+  for (Node* node = tiles->getHead(); node != nullptr;
+       node = node->getNext()) {
+    count += *node->getTile() == tile ? 1 : 0;
+  }
+  return count;
+}
+}  // namespace
+
+GameEngine::GameEngine(bool enhanced)
+    : enhanced(enhanced), current(0), placedThisTurn(0), log(nullptr) {}
+
+void GameEngine::newGame(const std::string& name1, const std::string& name2,
+                         unsigned int randSeed) {
+  players[0].reset(new Player(name1));
+  players[1].reset(new Player(name2));
+  gameBoard.reset(new GameBoard(ENGINE_BOARD_ROWS, ENGINE_BOARD_COLS));
+  bag.reset(new TileBag());
+  bag->shuffle(randSeed);
+  players[0]->drawQuantityTiles(bag.get(), ENGINE_HAND_SIZE);
+  players[1]->drawQuantityTiles(bag.get(), ENGINE_HAND_SIZE);
+  current = 0;
+  placedThisTurn = 0;
+}
+
+bool GameEngine::load(const std::string& filename) {
+  return restore(filename, nullptr, false);
+}
+
+std::string GameEngine::saveBinary() const {
+  return FileHandler::serialiseBinary(players[0].get(), players[1].get(),
+                                      bag.get(), gameBoard.get(),
+                                      currentPlayer());
+}
+
+bool GameEngine::restoreBinary(const std::string& data) {
+  return restore("", &data, true);
+}
+
+void GameEngine::setLog(GameLog* log) { this->log = log; }
+
+bool GameEngine::restore(const std::string& filename,
+                         const std::string* binary, bool keepOrder) {
+  std::unique_ptr<Player> first(new Player("Temp1"));
+  std::unique_ptr<Player> second(new Player("Temp2"));
+  std::unique_ptr<TileBag> loadedBag(new TileBag());
+  Player mover("Current");
+  GameBoard* loadedBoard = new GameBoard();
+
+  FileHandler fileHandler;
+  bool loaded =
+      binary != nullptr
+          ? fileHandler.deserialiseBinary(*binary, first.get(), second.get(),
+                                          loadedBag.get(), loadedBoard, &mover)
+          : fileHandler.loadGame(filename, first.get(), second.get(),
+                                 loadedBag.get(), loadedBoard, &mover);
+  std::unique_ptr<GameBoard> boardOwner(loadedBoard);
+  if (!loaded) {
+    error = fileHandler.getLastError();
+    return false;
+  }
+  int moverIndex = mover.getName() == first->getName() ? 0 : 1;
+  if (!keepOrder && moverIndex == 1) {
+    std::swap(first, second);
+    moverIndex = 0;
+  }
+  players[0] = std::move(first);
+  players[1] = std::move(second);
+  bag = std::move(loadedBag);
+  gameBoard = std::move(boardOwner);
+  current = moverIndex;
+  placedThisTurn = 0;
+  return true;
+}
+
+CommandResult GameEngine::place(Colour colour, Shape shape, int row,
+                                int col) {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  Player* player = currentPlayer();
+  Tile tile(colour, shape);
+  if (!player->containsTile(&tile)) {
+    return result(COMMAND_NOT_IN_HAND);
+  }
+  if (!Rules::validateMove(gameBoard.get(), &tile, row, col)) {
+    return result(COMMAND_ILLEGAL);
+  }
+
+  gameBoard->placeTile(row, col, player->removeTileFromHand(&tile));
+  CommandResult placed = result(COMMAND_OK);
+  placed.score =
+      Rules::calculateMoveScore(gameBoard.get(), {{row, col}}, placed.qwirkles);
+  player->setScore(player->getScore() + placed.score);
+  if (enhanced) {
+    placedThisTurn++;
+    record(LOG_PLACE, GameState::encodeTile(colour, shape), row, col, placed);
+    return placed;
+  }
+  Tile* drawn = bag->drawTile();
+  if (drawn != nullptr) {
+    player->addTileToHand(drawn);
+    placed.drawn = GameState::encodeTile(drawn->getColour(), drawn->getShape());
+  }
+  placed.turnEnded = true;
+  endTurn();
+  record(LOG_PLACE, GameState::encodeTile(colour, shape), row, col, placed);
+  return placed;
+}
+
+CommandResult GameEngine::placeAll(const Move* moves, int count) {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  if (count < 1 || (!enhanced && count > 1)) {
+    return result(COMMAND_ILLEGAL);
+  }
+  std::vector<Tile> tiles;
+  std::vector<Tile*> pointers;
+  std::vector<std::pair<int, int>> positions;
+  tiles.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    if (moves[i].tile == EMPTY_CELL) {
+      return result(COMMAND_NOT_IN_HAND);
+    }
+    tiles.emplace_back(GameState::colourOf(moves[i].tile),
+                       GameState::shapeOf(moves[i].tile));
+    // A tile named twice must be held twice
+    int wanted = 0;
+    for (const Tile& tile : tiles) {
+      wanted += tile == tiles.back() ? 1 : 0;
+    }
+    if (countTile(currentPlayer()->getHand(), tiles.back()) < wanted) {
+      return result(COMMAND_NOT_IN_HAND);
+    }
+    pointers.push_back(&tiles.back());
+    positions.push_back({moves[i].row, moves[i].col});
+  }
+  if (count == 1) {
+    return place(tiles[0].getColour(), tiles[0].getShape(), moves[0].row,
+                 moves[0].col);
+  }
+  if (!Rules::validateMoveEnhanced(gameBoard.get(), pointers, positions)) {
+    return result(COMMAND_ILLEGAL);
+  }
+
+  Player* player = currentPlayer();
+  for (int i = 0; i < count; ++i) {
+    gameBoard->placeTile(moves[i].row, moves[i].col,
+                         player->removeTileFromHand(&tiles[i]));
+  }
+  placedThisTurn += count;
+  CommandResult placed = result(COMMAND_OK);
+  placed.score =
+      Rules::calculateMoveScore(gameBoard.get(), positions, placed.qwirkles);
+  player->setScore(player->getScore() + placed.score);
+  recordAll(moves, count, placed);
+  return placed;
+}
+
+CommandResult GameEngine::replace(Colour colour, Shape shape) {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  Player* player = currentPlayer();
+  Tile tile(colour, shape);
+  Tile* removed = player->removeTileFromHand(&tile);
+  if (removed == nullptr) {
+    return result(COMMAND_NOT_IN_HAND);
+  }
+
+  CommandResult replaced = result(COMMAND_OK);
+  replaced.removed = GameState::encodeTile(colour, shape);
+  bag->addTile(removed);
+  Tile* drawn = bag->drawTile();
+  if (drawn != nullptr) {
+    player->addTileToHand(drawn);
+    replaced.drawn =
+        GameState::encodeTile(drawn->getColour(), drawn->getShape());
+  }
+  // The enhanced game keeps the turn unless nothing could be drawn
+  if (!enhanced || drawn == nullptr) {
+    replaced.turnEnded = true;
+    endTurn();
+  }
+  record(LOG_REPLACE, replaced.removed, 0, 0, replaced);
+  return replaced;
+}
+
+CommandResult GameEngine::pass() {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  CommandResult passed = result(COMMAND_OK);
+  for (int i = 0; i < placedThisTurn; ++i) {
+    Tile* drawn = bag->drawTile();
+    if (drawn != nullptr) {
+      currentPlayer()->addTileToHand(drawn);
+    } else {
+      passed.undrawn++;
+    }
+  }
+  passed.turnEnded = true;
+  endTurn();
+  record(LOG_PASS, EMPTY_CELL, 0, 0, passed);
+  return passed;
+}
+
+CommandResult GameEngine::save(const std::string& filename) {
+  return save(filename, FileHandler::formatFor(filename));
+}
+
+CommandResult GameEngine::save(const std::string& filename,
+                               SaveFormat format) {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  FileHandler fileHandler;
+  if (!fileHandler.saveGame(filename, currentPlayer(), opponent(), bag.get(),
+                            gameBoard.get(), currentPlayer(), format)) {
+    error = fileHandler.getLastError();
+    return result(COMMAND_FILE_ERROR);
+  }
+  return result(COMMAND_OK);
+}
+
+CommandResult GameEngine::saveInBackground(const std::string& filename,
+                                           SaveFormat format) {
+  if (!hasGame()) {
+    return result(COMMAND_NO_GAME);
+  }
+  BackgroundSaver::shared().submit(
+      filename, FileHandler::serialise(currentPlayer(), opponent(), bag.get(),
+                                       gameBoard.get(), currentPlayer(),
+                                       format));
+  return result(COMMAND_OK);
+}
+
+bool GameEngine::isEnhanced() const { return enhanced; }
+
+bool GameEngine::hasGame() const { return players[0] != nullptr; }
+
+bool GameEngine::isGameOver() const {
+  return players[0] != nullptr &&
+         Rules::isGameOver(players[0].get(), players[1].get(), bag.get());
+}
+
+Player* GameEngine::player(int index) const { return players[index].get(); }
+
+Player* GameEngine::currentPlayer() const { return players[current].get(); }
+
+Player* GameEngine::opponent() const { return players[1 - current].get(); }
+
+Player* GameEngine::winner() const {
+  return players[0]->getScore() > players[1]->getScore() ? players[0].get()
+                                                         : players[1].get();
+}
+
+GameBoard* GameEngine::board() const { return gameBoard.get(); }
+
+TileBag* GameEngine::tileBag() const { return bag.get(); }
+
+GameState GameEngine::snapshot() const {
+  return GameState::fromGame(gameBoard.get(), currentPlayer(), opponent(),
+                             bag.get());
+}
+
+uint64_t GameEngine::digest() const {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  if (!hasGame()) {
+    return hash;
+  }
+  for (const std::unique_ptr<Player>& player : players) {
+    for (char c : player->getName()) {
+      mix(hash, static_cast<uint8_t>(c));
+    }
+    mix(hash, 0);
+    uint32_t score = static_cast<uint32_t>(player->getScore());
+    for (int shift = 0; shift < 32; shift += 8) {
+      mix(hash, static_cast<uint8_t>(score >> shift));
+    }
+    mixTiles(hash, player->getHand());
+  }
+  for (int row = 0; row < gameBoard->getRows(); ++row) {
+    for (int col = 0; col < gameBoard->getCols(); ++col) {
+      Tile* tile = gameBoard->getTile(row, col);
+      mix(hash, tile != nullptr ? static_cast<uint8_t>(tile->getColour()) : 0);
+      mix(hash, tile != nullptr ? static_cast<uint8_t>(tile->getShape()) : 0);
+    }
+  }
+  mixTiles(hash, bag->getTiles());
+  mix(hash, static_cast<uint8_t>(current));
+  return hash;
+}
+
+const std::string& GameEngine::lastError() const { return error; }
+
+CommandResult GameEngine::result(CommandStatus status) const {
+  return {status, false, 0, EMPTY_CELL, EMPTY_CELL, 0, 0};
+}
+
+void GameEngine::record(LogRecord type, TileCode tile, int row, int col,
+                        const CommandResult& done) {
+  if (log != nullptr) {
+    log->append(*this, type, tile, row, col, done);
+  }
+}
+
+void GameEngine::recordAll(const Move* moves, int count,
+                           const CommandResult& done) {
+  if (log != nullptr) {
+    log->appendAll(*this, moves, count, done);
+  }
+}
+
+void GameEngine::endTurn() {
+  current = 1 - current;
+  placedThisTurn = 0;
+}
@@ -0,0 +1,155 @@
+#ifndef ASSIGN2_GAMEENGINE_H
+#define ASSIGN2_GAMEENGINE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "FileHandler.h"
+#include "GameBoard.h"
+#include "GameState.h"
+#include "Player.h"
+#include "TileBag.h"
+
+// Board size and starting hand of a new game
+#define ENGINE_BOARD_ROWS 26
+#define ENGINE_BOARD_COLS 26
+#define ENGINE_HAND_SIZE 6
+
+enum CommandStatus : uint8_t {
+  COMMAND_OK,
+  // The tile is not in the current player's hand
+  COMMAND_NOT_IN_HAND,
+  // Rules::validateMove rejects the placement
+  COMMAND_ILLEGAL,
+  // No game has been started or loaded
+  COMMAND_NO_GAME,
+  // The file could not be written or read
+  COMMAND_FILE_ERROR
+};
+
+class GameLog;
+
+// Records of a GameLog, tagged by these values
+enum LogRecord : uint8_t {
+  // u32 length, then a binary save in session order
+  LOG_SNAPSHOT = 'S',
+  // tile, row, col, and the tile drawn after it (0 for none)
+  LOG_PLACE = 'P',
+  // tile, and the tile drawn for it (0 for none)
+  LOG_REPLACE = 'R',
+  // no payload; the tiles it draws follow from the bag
+  LOG_PASS = 'X',
+  // count, then tile, row and col of each tile of a placeAll move
+  LOG_PLACE_ALL = 'M'
+};
+
+struct CommandResult {
+  CommandStatus status;
+  // The turn passed to the other player
+  bool turnEnded;
+  // Points scored by a placement
+  int score;
+  // Tile given back by a replace, and the tile drawn for a replace or a
+  // base game placement (EMPTY_CELL when nothing was drawn)
+  TileCode removed;
+  TileCode drawn;
+  // Tiles a pass could not draw because the bag ran out
+  int undrawn;
+  // Lines of six completed by a placement, each worth a bonus
+  int qwirkles;
+};
+
+/*
+ * One game of Qwirkle behind a command/result API, with no terminal
+ * input or output. The engine owns both players, the bag and the board;
+ * commands act for the player to move and report what happened in a
+ * CommandResult, leaving all wording to the caller.
+ *
+ * In the base game a placement or replace ends the turn. In the
+ * enhanced game placements and replaces keep the turn, and pass() ends
+ * it, drawing one tile for every tile placed during the turn.
+ *
+ * Players are kept in the order they first move in this session: the
+ * first named player of a new game, or the player to move in a loaded
+ * one.
+ */
+class GameEngine {
+ public:
+  explicit GameEngine(bool enhanced);
+
+  // Deal a new game with the bag shuffled by 'randSeed'
+  void newGame(const std::string& name1, const std::string& name2,
+               unsigned int randSeed);
+  // False if the file cannot be read as a saved game; lastError() then
+  // says why
+  bool load(const std::string& filename);
+
+  CommandResult place(Colour colour, Shape shape, int row, int col);
+  // Several MOVE_PLACE moves as one, placing every tile or none. In the
+  // enhanced game they are checked by Rules::validateMoveEnhanced and
+  // scored once by Rules::calculateMoveScore; the base game takes only
+  // one.
+  CommandResult placeAll(const Move* moves, int count);
+  CommandResult replace(Colour colour, Shape shape);
+  CommandResult pass();
+  // The whole game as a binary save in session order, and back; restoring
+  // keeps the order and the player to move, and expects a turn boundary
+  std::string saveBinary() const;
+  bool restoreBinary(const std::string& data);
+  // Successful commands are appended to 'log' until it is reset to null;
+  // the engine does not own it
+  void setLog(GameLog* log);
+
+  // Saved with the player to move first, as the game loop always has.
+  // Without a format, FileHandler::formatFor picks one from the name.
+  CommandResult save(const std::string& filename);
+  CommandResult save(const std::string& filename, SaveFormat format);
+  // Serialise now and leave the write to BackgroundSaver::shared(); how
+  // it went is reported by BackgroundSaver::takeFinished()
+  CommandResult saveInBackground(const std::string& filename,
+                                 SaveFormat format);
+
+  bool isEnhanced() const;
+  bool hasGame() const;
+  // Both hands and the bag are empty. Commands are still accepted, as the
+  // game loop only checks between turns.
+  bool isGameOver() const;
+  // Player 0 or 1 in session order
+  Player* player(int index) const;
+  Player* currentPlayer() const;
+  Player* opponent() const;
+  // The higher score, or the second player on a tie
+  Player* winner() const;
+  GameBoard* board() const;
+  TileBag* tileBag() const;
+  // Compact copy of the position for bots and search
+  GameState snapshot() const;
+  // 64-bit FNV-1a hash of everything a save holds: names, scores and
+  // hands in session order, the board, the bag in order and the player
+  // to move. Equal games give equal digests across runs and hosts.
+  uint64_t digest() const;
+  const std::string& lastError() const;
+
+ private:
+  bool enhanced;
+  std::unique_ptr<Player> players[2];
+  std::unique_ptr<TileBag> bag;
+  std::unique_ptr<GameBoard> gameBoard;
+  int current;
+  // Enhanced game: tiles placed this turn, refilled by pass()
+  int placedThisTurn;
+  std::string error;
+  GameLog* log;
+
+  CommandResult result(CommandStatus status) const;
+  // Load through 'fileHandler' from the file, or from 'binary' if given
+  bool restore(const std::string& filename, const std::string* binary,
+               bool keepOrder);
+  void record(LogRecord type, TileCode tile, int row, int col,
+              const CommandResult& done);
+  void recordAll(const Move* moves, int count, const CommandResult& done);
+  void endTurn();
+};
+
+#endif  // ASSIGN2_GAMEENGINE_H
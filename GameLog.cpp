@@ -0,0 +1,338 @@
+#include "GameLog.h"
+
+#include <iterator>
+#include <memory>
+
+// Header: magic, version byte, enhanced byte
+#define GAME_LOG_HEADER_SIZE (GAME_LOG_MAGIC_SIZE + 2)
+
+namespace {
+bool readFile(const std::string& path, std::string& data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  data.assign(std::istreambuf_iterator<char>(in),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+uint32_t readLength(const std::string& data, size_t pos) {
+  uint32_t length = 0;
+  for (int i = 0; i < 4; ++i) {
+    length |= static_cast<uint32_t>(static_cast<uint8_t>(data[pos + i]))
+              << (8 * i);
+  }
+  return length;
+}
+
+// Whole size of the record starting with 'tag', or 0 for an unknown tag
+size_t recordSize(const std::string& data, size_t pos) {
+  switch (static_cast<uint8_t>(data[pos])) {
+    case LOG_SNAPSHOT:
+      return pos + 5 <= data.size() ? 5 + readLength(data, pos + 1) : 5;
+    case LOG_PLACE:
+      return 5;
+    case LOG_REPLACE:
+      return 3;
+    case LOG_PASS:
+      return 1;
+    case LOG_PLACE_ALL:
+      return pos + 2 <= data.size()
+                 ? 2 + 3 * static_cast<size_t>(static_cast<uint8_t>(
+                               data[pos + 1]))
+                 : 2;
+    default:
+      return 0;
+  }
+}
+
+TileCode byteAt(const std::string& data, size_t pos) {
+  return static_cast<TileCode>(data[pos]);
+}
+
+// Run the command record at 'pos' on 'engine', which must draw what the
+// record says it drew, and list the moves it made in 'moves'
+bool applyRecord(GameEngine& engine, const std::string& data, size_t pos,
+                 Move* moves, int& count) {
+  TileCode tile = byteAt(data, pos + 1);
+  bool validTile = tile >= 1 && tile <= NUM_TILE_KINDS;
+  CommandResult done = {COMMAND_OK, false, 0, EMPTY_CELL, EMPTY_CELL, 0, 0};
+  TileCode drawn = EMPTY_CELL;
+  count = 1;
+  if (data[pos] == LOG_PLACE_ALL) {
+    count = static_cast<uint8_t>(data[pos + 1]);
+    if (count > DEFAULT_HAND_SIZE) {
+      return false;
+    }
+    for (int i = 0; i < count; ++i) {
+      size_t at = pos + 2 + 3 * i;
+      moves[i] = {MOVE_PLACE, byteAt(data, at),
+                  static_cast<uint8_t>(data[at + 1]),
+                  static_cast<uint8_t>(data[at + 2])};
+      if (moves[i].tile < 1 || moves[i].tile > NUM_TILE_KINDS) {
+        moves[i].tile = EMPTY_CELL;
+      }
+    }
+    done = engine.placeAll(moves, count);
+  } else if (data[pos] != LOG_PASS && !validTile) {
+    return false;
+  } else if (data[pos] == LOG_PLACE) {
+    moves[0] = {MOVE_PLACE, tile, static_cast<uint8_t>(data[pos + 2]),
+                static_cast<uint8_t>(data[pos + 3])};
+    drawn = byteAt(data, pos + 4);
+    done = engine.place(GameState::colourOf(tile), GameState::shapeOf(tile),
+                        moves[0].row, moves[0].col);
+  } else if (data[pos] == LOG_REPLACE) {
+    moves[0] = {MOVE_REPLACE, tile, 0, 0};
+    drawn = byteAt(data, pos + 2);
+    done = engine.replace(GameState::colourOf(tile), GameState::shapeOf(tile));
+  } else if (data[pos] == LOG_PASS) {
+    moves[0] = {MOVE_PASS, EMPTY_CELL, 0, 0};
+    done = engine.pass();
+  } else {
+    return false;
+  }
+  return done.status == COMMAND_OK && done.drawn == drawn;
+}
+}  // namespace
+
+GameLog::GameLog() : turns(0) {}
+
+bool GameLog::start(const std::string& path, const GameEngine& engine) {
+  out.close();
+  out.open(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    error = "Error: Unable to open log " + path;
+    return false;
+  }
+  out << GAME_LOG_MAGIC << static_cast<char>(GAME_LOG_VERSION)
+      << static_cast<char>(engine.isEnhanced() ? 1 : 0);
+  turns = 0;
+  writeSnapshot(engine);
+  return static_cast<bool>(out);
+}
+
+bool GameLog::resume(const std::string& path) {
+  std::string data;
+  size_t lastSnapshot = 0;
+  size_t valid = readFile(path, data) ? scan(data, lastSnapshot) : 0;
+  if (valid == 0) {
+    error = "Error: Unable to read log " + path;
+    return false;
+  }
+  if (valid < data.size()) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(data.data(), valid);
+  }
+  out.close();
+  out.open(path, std::ios::binary | std::ios::app);
+  turns = 0;
+  if (!out) {
+    error = "Error: Unable to open log " + path;
+  }
+  return static_cast<bool>(out);
+}
+
+bool GameLog::isOpen() const { return out.is_open(); }
+
+const std::string& GameLog::lastError() const { return error; }
+
+void GameLog::append(const GameEngine& engine, LogRecord type, TileCode tile,
+                     int row, int col, const CommandResult& done) {
+  if (!out.is_open()) {
+    return;
+  }
+  char record[5] = {static_cast<char>(type), static_cast<char>(tile),
+                    static_cast<char>(row), static_cast<char>(col),
+                    static_cast<char>(done.drawn)};
+  if (type == LOG_PLACE) {
+    out.write(record, 5);
+  } else if (type == LOG_REPLACE) {
+    record[2] = static_cast<char>(done.drawn);
+    out.write(record, 3);
+  } else {
+    out.write(record, 1);
+  }
+  if (done.turnEnded && ++turns % GAME_LOG_SNAPSHOT_TURNS == 0) {
+    writeSnapshot(engine);
+  }
+  out.flush();
+}
+
+void GameLog::appendAll(const GameEngine& engine, const Move* moves,
+                        int count, const CommandResult& done) {
+  if (!out.is_open()) {
+    return;
+  }
+  out << static_cast<char>(LOG_PLACE_ALL) << static_cast<char>(count);
+  for (int i = 0; i < count; ++i) {
+    out << static_cast<char>(moves[i].tile) << static_cast<char>(moves[i].row)
+        << static_cast<char>(moves[i].col);
+  }
+  if (done.turnEnded && ++turns % GAME_LOG_SNAPSHOT_TURNS == 0) {
+    writeSnapshot(engine);
+  }
+  out.flush();
+}
+
+void GameLog::writeSnapshot(const GameEngine& engine) {
+  std::string save = engine.saveBinary();
+  uint32_t length = static_cast<uint32_t>(save.size());
+  out << static_cast<char>(LOG_SNAPSHOT);
+  for (int i = 0; i < 4; ++i) {
+    out << static_cast<char>((length >> (8 * i)) & 0xFF);
+  }
+  out << save;
+  out.flush();
+}
+
+size_t GameLog::scan(const std::string& data, size_t& lastSnapshot) {
+  lastSnapshot = 0;
+  if (data.size() < GAME_LOG_HEADER_SIZE ||
+      data.compare(0, GAME_LOG_MAGIC_SIZE, GAME_LOG_MAGIC) != 0 ||
+      data[GAME_LOG_MAGIC_SIZE] != GAME_LOG_VERSION) {
+    return 0;
+  }
+  size_t pos = GAME_LOG_HEADER_SIZE;
+  while (pos < data.size()) {
+    size_t size = recordSize(data, pos);
+    if (size == 0 || data.size() - pos < size) {
+      break;
+    }
+    if (data[pos] == LOG_SNAPSHOT) {
+      lastSnapshot = pos;
+    }
+    pos += size;
+  }
+  return pos;
+}
+
+GameEngine* GameLog::replay(const std::string& path, std::string& error) {
+  std::string data;
+  size_t lastSnapshot = 0;
+  size_t valid = readFile(path, data) ? scan(data, lastSnapshot) : 0;
+  if (valid == 0) {
+    error = "Error: Unable to read log " + path;
+    return nullptr;
+  }
+  if (lastSnapshot == 0) {
+    error = "Error: Log has no snapshot";
+    return nullptr;
+  }
+
+  bool enhanced = data[GAME_LOG_MAGIC_SIZE + 1] != 0;
+  std::unique_ptr<GameEngine> engine(new GameEngine(enhanced));
+  size_t pos = lastSnapshot;
+  if (!engine->restoreBinary(
+          data.substr(pos + 5, readLength(data, pos + 1)))) {
+    error = engine->lastError();
+    return nullptr;
+  }
+  pos += recordSize(data, pos);
+
+  while (pos < valid) {
+    Move moves[DEFAULT_HAND_SIZE];
+    int count = 0;
+    if (!applyRecord(*engine, data, pos, moves, count)) {
+      error = "Error: Log does not replay at byte " + std::to_string(pos);
+      return nullptr;
+    }
+    pos += recordSize(data, pos);
+  }
+  return engine.release();
+}
+
+bool GameLog::toArchive(const std::string& path, ArchivedGame& game,
+                        std::string& error) {
+  std::string data;
+  size_t lastSnapshot = 0;
+  size_t valid = readFile(path, data) ? scan(data, lastSnapshot) : 0;
+  if (valid == 0) {
+    error = "Error: Unable to read log " + path;
+    return false;
+  }
+  // start() always opens the log with a snapshot
+  size_t pos = GAME_LOG_HEADER_SIZE;
+  if (lastSnapshot == 0 || data[pos] != LOG_SNAPSHOT) {
+    error = "Error: Log has no snapshot";
+    return false;
+  }
+
+  game.enhanced = data[GAME_LOG_MAGIC_SIZE + 1] != 0;
+  game.start = data.substr(pos + 5, readLength(data, pos + 1));
+  game.seed = 0;
+  game.moves.clear();
+  game.joined.clear();
+  GameEngine engine(game.enhanced);
+  if (!engine.restoreBinary(game.start)) {
+    error = engine.lastError();
+    return false;
+  }
+  game.names[0] = engine.player(0)->getName();
+  game.names[1] = engine.player(1)->getName();
+  pos += recordSize(data, pos);
+
+  while (pos < valid) {
+    // Later snapshots repeat what the commands already say
+    if (data[pos] != LOG_SNAPSHOT) {
+      Move moves[DEFAULT_HAND_SIZE];
+      int count = 0;
+      if (!applyRecord(engine, data, pos, moves, count)) {
+        error = "Error: Log does not replay at byte " + std::to_string(pos);
+        return false;
+      }
+      for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+          game.joined.resize(game.moves.size() + 1);
+          game.joined.back() = true;
+        }
+        game.moves.push_back(moves[i]);
+      }
+    }
+    pos += recordSize(data, pos);
+  }
+  if (!game.joined.empty()) {
+    game.joined.resize(game.moves.size());
+  }
+  return true;
+}
+
+GameEngine* GameLog::replay(const ArchivedGame& game, std::string& error) {
+  if (game.start.empty()) {
+    error = "Error: Game was not played through the engine";
+    return nullptr;
+  }
+  std::unique_ptr<GameEngine> engine(new GameEngine(game.enhanced));
+  if (!engine->restoreBinary(game.start)) {
+    error = engine->lastError();
+    return nullptr;
+  }
+
+  size_t m = 0;
+  while (m < game.moves.size()) {
+    const Move& move = game.moves[m];
+    size_t count = 1;
+    while (m + count < game.joined.size() && game.joined[m + count]) {
+      count++;
+    }
+    CommandResult done;
+    if (count > 1) {
+      done = engine->placeAll(&move, static_cast<int>(count));
+    } else if (move.type == MOVE_PLACE) {
+      done = engine->place(GameState::colourOf(move.tile),
+                           GameState::shapeOf(move.tile), move.row, move.col);
+    } else if (move.type == MOVE_REPLACE) {
+      done = engine->replace(GameState::colourOf(move.tile),
+                             GameState::shapeOf(move.tile));
+    } else {
+      done = engine->pass();
+    }
+    if (done.status != COMMAND_OK) {
+      error = "Error: Game does not replay at move " + std::to_string(m);
+      return nullptr;
+    }
+    m += count;
+  }
+  return engine.release();
+}
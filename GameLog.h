@@ -0,0 +1,79 @@
+#ifndef ASSIGN2_GAMELOG_H
+#define ASSIGN2_GAMELOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "GameArchive.h"
+#include "GameEngine.h"
+
+#define GAME_LOG_MAGIC "QWKL"
+#define GAME_LOG_MAGIC_SIZE 4
+#define GAME_LOG_VERSION 1
+
+// Turns between snapshot records
+#define GAME_LOG_SNAPSHOT_TURNS 16
+
+/*
+ * Append-only record of one game. The file is the magic, a version byte
+ * and a byte for the enhanced rules, then records of one tag byte and a
+ * fixed payload. A snapshot opens the log and follows every
+ * GAME_LOG_SNAPSHOT_TURNS turns; each command adds three to five bytes,
+ * or two plus three per tile for a placeAll move, and is flushed straight
+ * away, so a crash loses at most the record
+ * being written.
+ *
+ * Draws are not commands of their own. The bag order is part of every
+ * snapshot, so replaying a command draws the same tiles, and the drawn
+ * tile kept in place and replace records checks that it did.
+ */
+class GameLog {
+ public:
+  GameLog();
+
+  GameLog(const GameLog& other) = delete;
+  GameLog& operator=(const GameLog& other) = delete;
+
+  // New log at 'path', replacing any file there, opened with a snapshot
+  bool start(const std::string& path, const GameEngine& engine);
+  // Keep appending to an existing log, dropping a torn last record
+  bool resume(const std::string& path);
+  bool isOpen() const;
+  const std::string& lastError() const;
+
+  // Called by the engine after every command that succeeded
+  void append(const GameEngine& engine, LogRecord type, TileCode tile,
+              int row, int col, const CommandResult& done);
+  // Called by the engine after a placeAll move that succeeded
+  void appendAll(const GameEngine& engine, const Move* moves, int count,
+                 const CommandResult& done);
+
+  // Engine holding the logged game: the last snapshot with every later
+  // record applied. Null if the log cannot be read or does not replay;
+  // 'error' then says why.
+  static GameEngine* replay(const std::string& path, std::string& error);
+
+  // The logged game as an archive entry: the position of the first
+  // snapshot, the names and rules, and every command after it as moves.
+  // The id and date are left to the caller. False if the log does not
+  // replay; 'error' then says why.
+  static bool toArchive(const std::string& path, ArchivedGame& game,
+                        std::string& error);
+  // Engine holding an archived engine game after its last move, or null
+  // with 'error' set
+  static GameEngine* replay(const ArchivedGame& game, std::string& error);
+
+ private:
+  std::ofstream out;
+  int turns;
+  std::string error;
+
+  void writeSnapshot(const GameEngine& engine);
+  // Bytes up to the end of the last whole record, with the offset of the
+  // last snapshot; 0 if 'data' is not a log
+  static size_t scan(const std::string& data, size_t& lastSnapshot);
+};
+
+#endif  // ASSIGN2_GAMELOG_H
@@ -0,0 +1,473 @@
+#include "GameState.h"
+
+#include <algorithm>
+
+#include "TileCodes.h"
+
+namespace {
+const Colour kColours[NUM_COLOURS] = {RED,   ORANGE, YELLOW,
+                                      GREEN, BLUE,   PURPLE};
+const int kDirections[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// Bit (tile - 1) set for every tile of one colour, or of one shape
+const uint64_t kColourMasks[NUM_COLOURS] = {
+    0x3FULL,       0x3FULL << 6,  0x3FULL << 12,
+    0x3FULL << 18, 0x3FULL << 24, 0x3FULL << 30};
+const uint64_t kShapeMasks[NUM_SHAPES] = {
+    0x41041041ULL,      0x41041041ULL << 1, 0x41041041ULL << 2,
+    0x41041041ULL << 3, 0x41041041ULL << 4, 0x41041041ULL << 5};
+
+// Key spaces for hash(), above any cell index * 64 + tile
+const uint64_t kHandKeys = 1ULL << 32;
+const uint64_t kBagKeys = 2ULL << 32;
+const uint64_t kToMoveKey = 3ULL << 32;
+const uint64_t kIdleKeys = 4ULL << 32;
+
+// Pseudo-random key for an index (splitmix64 finaliser), so no key table
+// has to be sized for the largest board
+uint64_t zobristKey(uint64_t index) {
+  uint64_t z = index * 0x9E3779B97F4A7C15ULL + 0x632BE59BD9B4E019ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+}  // namespace
+
+bool Move::operator==(const Move& other) const {
+  return type == other.type && tile == other.tile && row == other.row &&
+         col == other.col;
+}
+
+bool Move::operator!=(const Move& other) const { return !(*this == other); }
+
+std::string Move::toCommand() const {
+  if (type == MOVE_PLACE) {
+    return "place " + GameState::tileToString(tile) + " at " +
+           std::string(1, 'A' + row) + std::to_string(col);
+  }
+  if (type == MOVE_REPLACE) {
+    return "replace " + GameState::tileToString(tile);
+  }
+  return "pass";
+}
+
+FastRandom::FastRandom(uint64_t seed)
+    : state(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+uint64_t FastRandom::next() {
+  // xorshift64*
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+unsigned int FastRandom::below(unsigned int bound) {
+  return static_cast<unsigned int>((next() >> 32) % bound);
+}
+
+GameState::GameState() : GameState(0, 0) {}
+
+GameState::GameState(int rows, int cols)
+    : toMove(0),
+      scores{0, 0},
+      idleTurns(0),
+      bagHead(0),
+      rows(rows),
+      cols(cols),
+      placedCount(0),
+      cells(rows * cols, EMPTY_CELL),
+      minRow(rows),
+      maxRow(-1),
+      minCol(cols),
+      maxCol(-1),
+      boardKey(0) {}
+
+GameState GameState::newGame(uint64_t seed) {
+  GameState state(DEFAULT_BOARD_SIZE, DEFAULT_BOARD_SIZE);
+  for (int copy = 0; copy < QUANTITY_OF_EACH_TILE; ++copy) {
+    for (int kind = 1; kind <= NUM_TILE_KINDS; ++kind) {
+      state.bag.push_back(static_cast<TileCode>(kind));
+    }
+  }
+
+  FastRandom random(seed);
+  for (size_t i = state.bag.size(); i > 1; --i) {
+    std::swap(state.bag[i - 1],
+              state.bag[random.below(static_cast<unsigned int>(i))]);
+  }
+
+  for (int player = 0; player < 2; ++player) {
+    for (int i = 0; i < DEFAULT_HAND_SIZE; ++i) {
+      state.drawInto(player);
+    }
+  }
+  return state;
+}
+
+GameState GameState::fromGame(GameBoard* board, Player* current,
+                              Player* opponent, TileBag* tileBag) {
+  GameState state(board->getRows(), board->getCols());
+  for (int row = 0; row < state.rows; ++row) {
+    for (int col = 0; col < state.cols; ++col) {
+      Tile* tile = board->getTile(row, col);
+      if (tile != nullptr) {
+        TileCode code = encodeTile(tile->getColour(), tile->getShape());
+        if (code != EMPTY_CELL) {
+          state.cells[row * state.cols + col] = code;
+          state.markPlaced(row, col);
+        }
+      }
+    }
+  }
+
+  Player* players[2] = {current, opponent};
+  for (int p = 0; p < 2; ++p) {
+    state.scores[p] = players[p]->getScore();
+    for (Node* node = players[p]->getHand()->getHead(); node != nullptr;
+         node = node->getNext()) {
+      TileCode code =
+          encodeTile(node->getTile()->getColour(), node->getTile()->getShape());
+      if (code != EMPTY_CELL) {
+        state.hands[p].push_back(code);
+      }
+    }
+  }
+
+  for (Node* node = tileBag->getTiles()->getHead(); node != nullptr;
+       node = node->getNext()) {
+    TileCode code =
+        encodeTile(node->getTile()->getColour(), node->getTile()->getShape());
+    if (code != EMPTY_CELL) {
+      state.bag.push_back(code);
+    }
+  }
+  return state;
+}
+
+TileCode GameState::encodeTile(Colour colour, Shape shape) {
+  if (shape < CIRCLE || shape > CLOVER) {
+    return EMPTY_CELL;
+  }
+  for (int i = 0; i < NUM_COLOURS; ++i) {
+    if (kColours[i] == colour) {
+      return static_cast<TileCode>(1 + i * NUM_SHAPES + (shape - CIRCLE));
+    }
+  }
+  return EMPTY_CELL;
+}
+
+Colour GameState::colourOf(TileCode tile) {
+  return kColours[colourIndex(tile)];
+}
+
+Shape GameState::shapeOf(TileCode tile) { return CIRCLE + shapeIndex(tile); }
+
+int GameState::colourIndex(TileCode tile) { return (tile - 1) / NUM_SHAPES; }
+
+int GameState::shapeIndex(TileCode tile) { return (tile - 1) % NUM_SHAPES; }
+
+std::string GameState::tileToString(TileCode tile) {
+  return std::string(1, colourOf(tile)) + std::to_string(shapeOf(tile));
+}
+
+int GameState::getRows() const { return rows; }
+
+int GameState::getCols() const { return cols; }
+
+TileCode GameState::at(int row, int col) const {
+  return cells[row * cols + col];
+}
+
+bool GameState::isBoardEmpty() const { return placedCount == 0; }
+
+int GameState::placedTiles() const { return placedCount; }
+
+void GameState::boundingBox(int& top, int& bottom, int& left,
+                            int& right) const {
+  top = minRow;
+  bottom = maxRow;
+  left = minCol;
+  right = maxCol;
+}
+
+int GameState::bagSize() const { return static_cast<int>(bag.size() - bagHead); }
+
+bool GameState::lineAccepts(TileCode tile, int row, int col, int dr, int dc,
+                            int& lineLength) const {
+  // 0 = no neighbours yet, 1 = matched by colour, 2 = matched by shape
+  int matchKind = 0;
+  lineLength = 1;
+  for (int sign = -1; sign <= 1; sign += 2) {
+    int r = row + sign * dr;
+    int c = col + sign * dc;
+    while (r >= 0 && r < rows && c >= 0 && c < cols &&
+           cells[r * cols + c] != EMPTY_CELL) {
+      TileCode other = cells[r * cols + c];
+      int kind;
+      if (other == tile) {
+        return false;
+      } else if (colourIndex(other) == colourIndex(tile)) {
+        kind = 1;
+      } else if (shapeIndex(other) == shapeIndex(tile)) {
+        kind = 2;
+      } else {
+        return false;
+      }
+      if (matchKind != 0 && matchKind != kind) {
+        return false;
+      }
+      matchKind = kind;
+      lineLength++;
+      r += sign * dr;
+      c += sign * dc;
+    }
+  }
+  return true;
+}
+
+bool GameState::isValidPlacement(TileCode tile, int row, int col) const {
+  if (row < 0 || row >= rows || col < 0 || col >= cols) {
+    return false;
+  }
+  if (placedCount == 0) {
+    return true;
+  }
+  if (cells[row * cols + col] != EMPTY_CELL) {
+    return false;
+  }
+  int rowLength = 0;
+  int colLength = 0;
+  if (!lineAccepts(tile, row, col, 1, 0, rowLength) ||
+      !lineAccepts(tile, row, col, 0, 1, colLength)) {
+    return false;
+  }
+  // A tile with no neighbours at all is rejected
+  return rowLength > 1 || colLength > 1;
+}
+
+int GameState::scorePlacement(int row, int col) const {
+  int rowTiles = 1;
+  int colTiles = 1;
+  for (int i = row - 1; i >= 0 && cells[i * cols + col] != EMPTY_CELL; --i) {
+    rowTiles++;
+  }
+  for (int i = row + 1; i < rows && cells[i * cols + col] != EMPTY_CELL; ++i) {
+    rowTiles++;
+  }
+  for (int j = col - 1; j >= 0 && cells[row * cols + j] != EMPTY_CELL; --j) {
+    colTiles++;
+  }
+  for (int j = col + 1; j < cols && cells[row * cols + j] != EMPTY_CELL; ++j) {
+    colTiles++;
+  }
+
+  int score = 0;
+  if (rowTiles > 1) {
+    score += rowTiles;
+  }
+  if (colTiles > 1) {
+    score += colTiles;
+  }
+  if (rowTiles == 6) {
+    score += 6;
+  }
+  if (colTiles == 6) {
+    score += 6;
+  }
+  if (score == 0) {
+    score = 1;
+  }
+  return score;
+}
+
+bool GameState::hasNeighbour(int row, int col) const {
+  for (const auto& direction : kDirections) {
+    int r = row + direction[0];
+    int c = col + direction[1];
+    if (r >= 0 && r < rows && c >= 0 && c < cols &&
+        cells[r * cols + c] != EMPTY_CELL) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void GameState::generatePlacements(std::vector<Move>& moves) const {
+  const std::vector<TileCode>& hand = hands[toMove];
+
+  // Distinct tiles only, duplicates would produce identical moves
+  TileCode distinct[NUM_TILE_KINDS];
+  int distinctCount = 0;
+  bool seen[NUM_TILE_KINDS + 1] = {false};
+  for (TileCode tile : hand) {
+    if (!seen[tile]) {
+      seen[tile] = true;
+      distinct[distinctCount++] = tile;
+    }
+  }
+  if (distinctCount == 0 || rows == 0 || cols == 0) {
+    return;
+  }
+
+  if (placedCount == 0) {
+    // Any cell is legal on an empty board; they are all equivalent, so
+    // only the centre is offered
+    for (int i = 0; i < distinctCount; ++i) {
+      moves.push_back({MOVE_PLACE, distinct[i],
+                       static_cast<int16_t>(rows / 2),
+                       static_cast<int16_t>(cols / 2)});
+    }
+    return;
+  }
+
+  int firstRow = std::max(0, minRow - 1);
+  int lastRow = std::min(rows - 1, maxRow + 1);
+  int firstCol = std::max(0, minCol - 1);
+  int lastCol = std::min(cols - 1, maxCol + 1);
+  for (int row = firstRow; row <= lastRow; ++row) {
+    for (int col = firstCol; col <= lastCol; ++col) {
+      if (cells[row * cols + col] != EMPTY_CELL || !hasNeighbour(row, col)) {
+        continue;
+      }
+      // Walk each line once per cell rather than once per tile
+      uint64_t accepted = lineMask(row, col, 1, 0) & lineMask(row, col, 0, 1);
+      for (int i = 0; i < distinctCount; ++i) {
+        if (accepted & (1ULL << (distinct[i] - 1))) {
+          moves.push_back({MOVE_PLACE, distinct[i], static_cast<int16_t>(row),
+                           static_cast<int16_t>(col)});
+        }
+      }
+    }
+  }
+}
+
+uint64_t GameState::lineMask(int row, int col, int dr, int dc) const {
+  // A tile fits if it shares the colour of every tile in the line, or the
+  // shape of every tile, and is not a copy of any of them
+  uint64_t sameColour = (1ULL << NUM_TILE_KINDS) - 1;
+  uint64_t sameShape = sameColour;
+  uint64_t taken = 0;
+  for (int sign = -1; sign <= 1; sign += 2) {
+    int r = row + sign * dr;
+    int c = col + sign * dc;
+    while (r >= 0 && r < rows && c >= 0 && c < cols &&
+           cells[r * cols + c] != EMPTY_CELL) {
+      TileCode other = cells[r * cols + c];
+      sameColour &= kColourMasks[colourIndex(other)];
+      sameShape &= kShapeMasks[shapeIndex(other)];
+      taken |= 1ULL << (other - 1);
+      r += sign * dr;
+      c += sign * dc;
+    }
+  }
+  return (sameColour | sameShape) & ~taken;
+}
+
+void GameState::generateMoves(std::vector<Move>& moves) const {
+  moves.clear();
+  generatePlacements(moves);
+
+  const std::vector<TileCode>& hand = hands[toMove];
+  if (bagSize() > 0) {
+    bool seen[NUM_TILE_KINDS + 1] = {false};
+    for (TileCode tile : hand) {
+      if (!seen[tile]) {
+        seen[tile] = true;
+        moves.push_back({MOVE_REPLACE, tile, 0, 0});
+      }
+    }
+  } else {
+    // Replacing with an empty bag hands the same tile back, so it is a pass
+    moves.push_back({MOVE_PASS, EMPTY_CELL, 0, 0});
+  }
+
+  if (moves.empty()) {
+    moves.push_back({MOVE_PASS, EMPTY_CELL, 0, 0});
+  }
+}
+
+void GameState::drawInto(int player) {
+  if (bagHead < bag.size()) {
+    hands[player].push_back(bag[bagHead++]);
+  }
+}
+
+void GameState::markPlaced(int row, int col) {
+  placedCount++;
+  boardKey ^= zobristKey(static_cast<uint64_t>(row * cols + col) * 64 +
+                         cells[row * cols + col]);
+  minRow = std::min(minRow, row);
+  maxRow = std::max(maxRow, row);
+  minCol = std::min(minCol, col);
+  maxCol = std::max(maxCol, col);
+}
+
+void GameState::applyMove(const Move& move) {
+  std::vector<TileCode>& hand = hands[toMove];
+  if (move.type == MOVE_PLACE) {
+    cells[move.row * cols + move.col] = move.tile;
+    markPlaced(move.row, move.col);
+    auto it = std::find(hand.begin(), hand.end(), move.tile);
+    if (it != hand.end()) {
+      hand.erase(it);
+    }
+    drawInto(toMove);
+    scores[toMove] += scorePlacement(move.row, move.col);
+    idleTurns = 0;
+  } else if (move.type == MOVE_REPLACE) {
+    auto it = std::find(hand.begin(), hand.end(), move.tile);
+    if (it != hand.end()) {
+      hand.erase(it);
+      bag.push_back(move.tile);
+      drawInto(toMove);
+    }
+    idleTurns++;
+  } else {
+    idleTurns++;
+  }
+  toMove = 1 - toMove;
+}
+
+bool GameState::isTerminal() const {
+  return (hands[0].empty() && hands[1].empty() && bagSize() == 0) ||
+         idleTurns >= MAX_IDLE_TURNS;
+}
+
+uint64_t GameState::hash() const {
+  uint64_t key = boardKey ^ zobristKey(kIdleKeys + idleTurns);
+  if (toMove == 1) {
+    key ^= zobristKey(kToMoveKey);
+  }
+  // Hands and bag are multisets, so their keys are summed rather than
+  // xored, which keeps a pair of equal tiles from cancelling out
+  for (int player = 0; player < 2; ++player) {
+    for (TileCode tile : hands[player]) {
+      key += zobristKey(kHandKeys + player * 64 + tile);
+    }
+  }
+  for (size_t i = bagHead; i < bag.size(); ++i) {
+    key += zobristKey(kBagKeys + bag[i]);
+  }
+  return key;
+}
+
+int GameState::scoreMargin(int player) const {
+  return scores[player] - scores[1 - player];
+}
+
+void GameState::determinize(int observer, FastRandom& random) {
+  int other = 1 - observer;
+  std::vector<TileCode> unseen(hands[other]);
+  unseen.insert(unseen.end(), bag.begin() + bagHead, bag.end());
+
+  for (size_t i = unseen.size(); i > 1; --i) {
+    std::swap(unseen[i - 1],
+              unseen[random.below(static_cast<unsigned int>(i))]);
+  }
+
+  size_t handSize = hands[other].size();
+  hands[other].assign(unseen.begin(), unseen.begin() + handSize);
+  bag.assign(unseen.begin() + handSize, unseen.end());
+  bagHead = 0;
+}
@@ -0,0 +1,157 @@
+#ifndef ASSIGN2_GAMESTATE_H
+#define ASSIGN2_GAMESTATE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameBoard.h"
+#include "Player.h"
+#include "TileBag.h"
+
+// Number of distinct colours and shapes in a standard tile set
+#define NUM_COLOURS 6
+#define NUM_SHAPES 6
+#define NUM_TILE_KINDS (NUM_COLOURS * NUM_SHAPES)
+
+// Consecutive turns without a placement after which a simulated game stops
+#define MAX_IDLE_TURNS 4
+
+// Layout of a fresh game, matching the interactive game
+#define DEFAULT_BOARD_SIZE 26
+#define DEFAULT_HAND_SIZE 6
+
+// Compact tile code: 0 is an empty cell, otherwise 1 + colour * 6 + shape
+typedef uint8_t TileCode;
+
+#define EMPTY_CELL 0
+
+// Move types understood by GameState
+enum MoveType : uint8_t { MOVE_PLACE, MOVE_REPLACE, MOVE_PASS };
+
+struct Move {
+  MoveType type;
+  TileCode tile;
+  int16_t row;
+  int16_t col;
+
+  bool operator==(const Move& other) const;
+  bool operator!=(const Move& other) const;
+
+  // Render the move in the same syntax the game loop accepts
+  std::string toCommand() const;
+};
+
+// Small, fast xorshift generator used by simulations
+class FastRandom {
+ public:
+  explicit FastRandom(uint64_t seed);
+  uint64_t next();
+  // Uniform integer in [0, bound)
+  unsigned int below(unsigned int bound);
+
+ private:
+  uint64_t state;
+};
+
+/*
+ * Flat, value-type copy of a game used by search and simulation code.
+ * The board is one byte per cell, hands and bag are byte vectors, so a
+ * whole position can be copied cheaply per rollout. Placement legality
+ * and scoring mirror Rules::validateMove and Rules::calculateScore.
+ */
+class GameState {
+ public:
+  GameState();
+  GameState(int rows, int cols);
+
+  // Fresh game: full tile set shuffled with 'seed', both hands dealt
+  static GameState newGame(uint64_t seed);
+
+  // Build a state from the game objects; 'current' is the player to move
+  static GameState fromGame(GameBoard* board, Player* current,
+                            Player* opponent, TileBag* tileBag);
+
+  // Tile code helpers
+  static TileCode encodeTile(Colour colour, Shape shape);
+  static Colour colourOf(TileCode tile);
+  static Shape shapeOf(TileCode tile);
+  static int colourIndex(TileCode tile);
+  static int shapeIndex(TileCode tile);
+  static std::string tileToString(TileCode tile);
+
+  int getRows() const;
+  int getCols() const;
+  TileCode at(int row, int col) const;
+  bool isBoardEmpty() const;
+  int placedTiles() const;
+  // Smallest rectangle holding every placed tile; unset on an empty board
+  void boundingBox(int& top, int& bottom, int& left, int& right) const;
+
+  // Same result as Rules::validateMove for this position
+  bool isValidPlacement(TileCode tile, int row, int col) const;
+
+  // Same result as Rules::calculateScore; the cell itself is not read,
+  // so this works both before and after the tile is placed
+  int scorePlacement(int row, int col) const;
+
+  // All legal moves for the player to move
+  void generateMoves(std::vector<Move>& moves) const;
+
+  // Legal placements only
+  void generatePlacements(std::vector<Move>& moves) const;
+
+  // Apply a move for the player to move and pass the turn
+  void applyMove(const Move& move);
+
+  bool isTerminal() const;
+
+  // Score difference from the point of view of 'player'
+  int scoreMargin(int player) const;
+
+  // Shuffle the tiles 'observer' cannot see (opponent hand and bag)
+  // into a random layout consistent with what 'observer' knows
+  void determinize(int observer, FastRandom& random);
+
+  int bagSize() const;
+
+  // 64-bit key of the board, both hands, the unseen tiles and the side to
+  // move. Scores are left out, so search tables must store values
+  // relative to the position. Bag order is ignored.
+  uint64_t hash() const;
+
+  // Public so search code can read and tweak positions directly
+  int toMove;
+  int scores[2];
+  int idleTurns;
+  std::vector<TileCode> hands[2];
+  std::vector<TileCode> bag;
+  size_t bagHead;
+
+ private:
+  int rows;
+  int cols;
+  int placedCount;
+  std::vector<TileCode> cells;
+
+  // Bounding box of placed tiles, used to limit the move scan
+  int minRow;
+  int maxRow;
+  int minCol;
+  int maxCol;
+
+  // Zobrist key of the placed tiles, kept up to date by markPlaced
+  uint64_t boardKey;
+
+  // Checks one line (direction dr/dc and its opposite) around row/col
+  // and returns false if the tile cannot join it
+  bool lineAccepts(TileCode tile, int row, int col, int dr, int dc,
+                   int& lineLength) const;
+  // Set of tiles (bit tile - 1) that lineAccepts would let join the line
+  uint64_t lineMask(int row, int col, int dr, int dc) const;
+  bool hasNeighbour(int row, int col) const;
+  void drawInto(int player);
+  void markPlaced(int row, int col);
+};
+
+#endif  // ASSIGN2_GAMESTATE_H
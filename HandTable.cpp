@@ -0,0 +1,246 @@
+#include "HandTable.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+#include "CanonicalForm.h"
+
+namespace {
+int colourTotal(const uint8_t counts[], int colour) {
+  int total = 0;
+  for (int s = 0; s < NUM_SHAPES; ++s) {
+    total += counts[colour * NUM_SHAPES + s];
+  }
+  return total;
+}
+
+// Calls 'visit' for every hand whose colour totals and shape totals are
+// both non-increasing. Sorting colours and shapes by their totals
+// renames any hand into one of these, so every class is reached.
+void enumerateHands(uint8_t counts[], int cell, int remaining,
+                    const std::function<void(const uint8_t*)>& visit) {
+  if (cell == NUM_TILE_KINDS) {
+    if (remaining > 0) {
+      return;
+    }
+    int previous = DEFAULT_HAND_SIZE;
+    for (int s = 0; s < NUM_SHAPES; ++s) {
+      int total = 0;
+      for (int c = 0; c < NUM_COLOURS; ++c) {
+        total += counts[c * NUM_SHAPES + s];
+      }
+      if (total > previous) {
+        return;
+      }
+      previous = total;
+    }
+    visit(counts);
+    return;
+  }
+  int colour = cell / NUM_SHAPES;
+  bool rowEnds = cell % NUM_SHAPES == NUM_SHAPES - 1;
+  for (int n = 0; n <= std::min(remaining, QUANTITY_OF_EACH_TILE); ++n) {
+    counts[cell] = static_cast<uint8_t>(n);
+    if (rowEnds && colour > 0 &&
+        colourTotal(counts, colour) > colourTotal(counts, colour - 1)) {
+      break;
+    }
+    enumerateHands(counts, cell + 1, remaining - n, visit);
+  }
+  counts[cell] = 0;
+}
+
+uint16_t storedValue(double value) {
+  return static_cast<uint16_t>(std::lround(value * HAND_VALUE_SCALE));
+}
+}  // namespace
+
+bool HandAdvice::shouldSwap() const { return swapValue > keepValue; }
+
+HandTable::HandTable()
+    : mapping(nullptr), mappingBytes(0), records(nullptr), count(0) {}
+
+HandTable::~HandTable() { close(); }
+
+HandTable& HandTable::shared() {
+  static HandTable table;
+  return table;
+}
+
+bool HandTable::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(HandTableHeader)) {
+    ::close(fd);
+    return false;
+  }
+  size_t bytes = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+
+  const HandTableHeader* header = static_cast<const HandTableHeader*>(mapped);
+  if (std::memcmp(header->magic, HAND_TABLE_MAGIC, sizeof(header->magic)) !=
+          0 ||
+      header->version != HAND_TABLE_VERSION ||
+      bytes != sizeof(HandTableHeader) + header->count * sizeof(HandRecord)) {
+    munmap(mapped, bytes);
+    return false;
+  }
+  mapping = mapped;
+  mappingBytes = bytes;
+  records = reinterpret_cast<const HandRecord*>(header + 1);
+  count = header->count;
+  return true;
+}
+
+void HandTable::close() {
+  if (mapping != nullptr) {
+    munmap(mapping, mappingBytes);
+  }
+  mapping = nullptr;
+  mappingBytes = 0;
+  records = nullptr;
+  count = 0;
+}
+
+bool HandTable::isOpen() const { return records != nullptr; }
+
+size_t HandTable::size() const { return count; }
+
+bool HandTable::lookup(const std::vector<TileCode>& hand,
+                       HandAdvice& advice) const {
+  if (records == nullptr || hand.size() != DEFAULT_HAND_SIZE) {
+    return false;
+  }
+  CanonicalForm form = CanonicalForm::ofHand(hand);
+  uint64_t key = form.getKey();
+  const HandRecord* end = records + count;
+  const HandRecord* found =
+      std::lower_bound(records, end, key,
+                       [](const HandRecord& record, uint64_t wanted) {
+                         return record.key < wanted;
+                       });
+  if (found == end || found->key != key) {
+    return false;
+  }
+  advice.keepValue = static_cast<double>(found->keepValue) / HAND_VALUE_SCALE;
+  advice.swapValue = static_cast<double>(found->swapValue) / HAND_VALUE_SCALE;
+  advice.discard = form.fromCanonical(found->discard);
+  return true;
+}
+
+int HandTable::handValue(const uint8_t counts[]) {
+  int value = 0;
+  for (int line = 0; line < NUM_COLOURS + NUM_SHAPES; ++line) {
+    // Distinct tiles sharing this colour, then this shape
+    int distinct = 0;
+    for (int i = 0; i < NUM_SHAPES; ++i) {
+      int kind = line < NUM_COLOURS
+                     ? line * NUM_SHAPES + i
+                     : i * NUM_SHAPES + (line - NUM_COLOURS);
+      if (counts[kind] > 0) {
+        distinct++;
+      }
+    }
+    if (distinct > 1) {
+      value += distinct;
+    }
+    if (distinct == NUM_SHAPES) {
+      value += NUM_SHAPES;
+    }
+  }
+  return value;
+}
+
+bool HandTable::build(const std::string& path, int& hands) {
+  std::unordered_map<uint64_t, HandRecord> table;
+  uint8_t counts[NUM_TILE_KINDS] = {0};
+  enumerateHands(
+      counts, 0, DEFAULT_HAND_SIZE, [&table](const uint8_t* found) {
+        std::vector<TileCode> hand;
+        uint8_t work[NUM_TILE_KINDS];
+        for (int kind = 0; kind < NUM_TILE_KINDS; ++kind) {
+          work[kind] = found[kind];
+          for (int i = 0; i < found[kind]; ++i) {
+            hand.push_back(static_cast<TileCode>(kind + 1));
+          }
+        }
+        CanonicalForm form = CanonicalForm::ofHand(hand);
+        if (table.count(form.getKey()) > 0) {
+          return;
+        }
+
+        // Exact expectation over the tile drawn in place of the discard:
+        // every copy not in the hand is equally likely
+        double bestSwap = -1.0;
+        TileCode discard = hand[0];
+        for (int kind = 0; kind < NUM_TILE_KINDS; ++kind) {
+          if (found[kind] == 0) {
+            continue;
+          }
+          work[kind]--;
+          long total = 0;
+          long weight = 0;
+          for (int drawn = 0; drawn < NUM_TILE_KINDS; ++drawn) {
+            int copies = QUANTITY_OF_EACH_TILE - found[drawn];
+            if (copies <= 0) {
+              continue;
+            }
+            work[drawn]++;
+            total += copies * handValue(work);
+            weight += copies;
+            work[drawn]--;
+          }
+          work[kind]++;
+          double expected = static_cast<double>(total) / weight;
+          if (expected > bestSwap) {
+            bestSwap = expected;
+            discard = static_cast<TileCode>(kind + 1);
+          }
+        }
+        table[form.getKey()] = {form.getKey(),
+                                storedValue(handValue(found)),
+                                storedValue(bestSwap),
+                                form.toCanonical(discard),
+                                {0, 0, 0}};
+      });
+
+  std::vector<HandRecord> sorted;
+  for (const auto& entry : table) {
+    sorted.push_back(entry.second);
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const HandRecord& a, const HandRecord& b) {
+              return a.key < b.key;
+            });
+  hands = static_cast<int>(sorted.size());
+
+  HandTableHeader header;
+  std::memcpy(header.magic, HAND_TABLE_MAGIC, sizeof(header.magic));
+  header.version = HAND_TABLE_VERSION;
+  header.count = static_cast<uint32_t>(sorted.size());
+  header.reserved = 0;
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(sorted.data()),
+            sorted.size() * sizeof(HandRecord));
+  return static_cast<bool>(out);
+}
@@ -0,0 +1,95 @@
+#ifndef ASSIGN2_HANDTABLE_H
+#define ASSIGN2_HANDTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameState.h"
+
+#define HAND_TABLE_MAGIC "QWHT"
+#define HAND_TABLE_VERSION 1
+
+// Values are stored in hundredths of a point
+#define HAND_VALUE_SCALE 100
+
+// On-disk layout, written in the byte order of the host that built it
+struct HandTableHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+// One full hand up to renaming of colours and shapes
+struct HandRecord {
+  uint64_t key;
+  // Value of the hand as it is
+  uint16_t keepValue;
+  // Expected value after swapping 'discard' for a random unseen tile
+  uint16_t swapValue;
+  // Best tile to swap, in canonical colours and shapes
+  uint8_t discard;
+  uint8_t reserved[3];
+};
+
+struct HandAdvice {
+  double keepValue;
+  double swapValue;
+  // Best tile to swap, in the colours and shapes of the hand asked about
+  TileCode discard;
+
+  bool shouldSwap() const;
+};
+
+/*
+ * Precomputed keep/replace advice for every full hand. Hands are
+ * reduced by renaming colours and shapes (CanonicalForm::ofHand), which
+ * leaves a few hundred classes out of millions of hands.
+ *
+ * A hand is worth the points its colour lines and shape lines would
+ * score if each were laid out: k distinct tiles sharing a colour or a
+ * shape score k, plus 6 for all six. Duplicates add nothing. For each
+ * tile the table holds the exact expected value after swapping it for a
+ * tile drawn from the rest of the tile set, and the best such swap.
+ *
+ * The file is a header plus records sorted by key. It is
+ * memory-mapped read-only and searched with a binary search.
+ */
+class HandTable {
+ public:
+  HandTable();
+  ~HandTable();
+
+  HandTable(const HandTable& other) = delete;
+  HandTable& operator=(const HandTable& other) = delete;
+
+  // Engine-wide table consulted when a tile must be swapped; empty until
+  // opened
+  static HandTable& shared();
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const;
+  size_t size() const;
+
+  // Advice for a hand of DEFAULT_HAND_SIZE tiles; false for any other
+  // size or if the table is not open
+  bool lookup(const std::vector<TileCode>& hand, HandAdvice& advice) const;
+
+  // Enumerate every full hand up to renaming, value it and write the
+  // sorted table; 'hands' is set to the number of records
+  static bool build(const std::string& path, int& hands);
+
+  // Value of a hand given as counts per tile kind (index tile - 1)
+  static int handValue(const uint8_t counts[]);
+
+ private:
+  void* mapping;
+  size_t mappingBytes;
+  const HandRecord* records;
+  size_t count;
+};
+
+#endif  // ASSIGN2_HANDTABLE_H
@@ -0,0 +1,162 @@
+#include "HintSearch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Evaluator.h"
+#include "HandTable.h"
+#include "OpeningBook.h"
+
+// Deepest search ever attempted
+#define HINT_MAX_DEPTH 16
+
+#define HINT_INFINITY 1000000
+
+HintSearch::HintSearch(int deadlineMs, uint64_t seed)
+    : deadlineMs(deadlineMs),
+      random(seed),
+      nodes(0),
+      aborted(false),
+      moveStack(HINT_MAX_DEPTH + 1) {}
+
+bool HintSearch::timeUp() {
+  return std::chrono::steady_clock::now() >= deadline;
+}
+
+void HintSearch::orderedMoves(const GameState& state,
+                              std::vector<Move>& moves) {
+  moves.clear();
+  state.generatePlacements(moves);
+  if (moves.empty()) {
+    moves.push_back({MOVE_PASS, EMPTY_CELL, 0, 0});
+    return;
+  }
+  std::stable_sort(moves.begin(), moves.end(),
+                   [&state](const Move& a, const Move& b) {
+                     return state.scorePlacement(a.row, a.col) >
+                            state.scorePlacement(b.row, b.col);
+                   });
+}
+
+HintResult HintSearch::search(const GameState& state) {
+  auto start = std::chrono::steady_clock::now();
+  deadline = start + std::chrono::milliseconds(deadlineMs);
+  nodes = 0;
+  aborted = false;
+
+  HintResult result;
+  result.fromBook = false;
+  result.depth = 1;
+
+  std::vector<Move> rootMoves;
+  orderedMoves(state, rootMoves);
+  result.move = rootMoves[0];
+
+  Move bookMove;
+  if (OpeningBook::shared().lookup(state, bookMove)) {
+    result.move = bookMove;
+    result.fromBook = true;
+  } else if (rootMoves[0].type == MOVE_PASS) {
+    // Nothing fits: suggest the swap the hand table advises, else a
+    // duplicate, else the first tile
+    const std::vector<TileCode>& hand = state.hands[state.toMove];
+    HandAdvice advice;
+    if (state.bagSize() > 0 && HandTable::shared().lookup(hand, advice)) {
+      result.move = {MOVE_REPLACE, advice.discard, 0, 0};
+    } else if (state.bagSize() > 0 && !hand.empty()) {
+      TileCode tile = hand[0];
+      for (size_t i = 0; i < hand.size(); ++i) {
+        if (std::count(hand.begin(), hand.end(), hand[i]) > 1) {
+          tile = hand[i];
+          break;
+        }
+      }
+      result.move = {MOVE_REPLACE, tile, 0, 0};
+    }
+  } else if (rootMoves.size() > 1) {
+    std::vector<GameState> samples;
+    for (int i = 0; i < HINT_SAMPLES; ++i) {
+      samples.push_back(state);
+      samples.back().determinize(state.toMove, random);
+    }
+
+    std::vector<std::pair<int, Move>> scored(rootMoves.size());
+    for (int depth = 2; depth <= HINT_MAX_DEPTH && !aborted; ++depth) {
+      for (size_t i = 0; i < rootMoves.size() && !aborted; ++i) {
+        int total = 0;
+        for (const GameState& sample : samples) {
+          GameState child = sample;
+          child.applyMove(rootMoves[i]);
+          total += -negamax(child, depth - 1, -HINT_INFINITY, HINT_INFINITY);
+          if (aborted) {
+            break;
+          }
+        }
+        scored[i] = {total, rootMoves[i]};
+      }
+      if (aborted) {
+        break;
+      }
+
+      // Best first, which also orders the next iteration for alpha-beta;
+      // equal lines prefer the bigger score now
+      std::stable_sort(scored.begin(), scored.end(),
+                       [&state](const std::pair<int, Move>& a,
+                                const std::pair<int, Move>& b) {
+                         if (a.first != b.first) {
+                           return a.first > b.first;
+                         }
+                         return state.scorePlacement(a.second.row,
+                                                     a.second.col) >
+                                state.scorePlacement(b.second.row,
+                                                     b.second.col);
+                       });
+      for (size_t i = 0; i < scored.size(); ++i) {
+        rootMoves[i] = scored[i].second;
+      }
+      result.move = rootMoves[0];
+      result.depth = depth;
+    }
+  }
+
+  result.timedOut = aborted;
+  result.nodes = nodes;
+  result.elapsedMs = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  return result;
+}
+
+int HintSearch::negamax(GameState& state, int depth, int alpha, int beta) {
+  nodes++;
+  if (nodes % HINT_CLOCK_INTERVAL == 0 && timeUp()) {
+    aborted = true;
+  }
+  if (aborted) {
+    return 0;
+  }
+  if (state.isTerminal()) {
+    return state.scoreMargin(state.toMove);
+  }
+  if (depth == 0) {
+    return static_cast<int>(std::lround(Evaluator::shared().evaluate(state)));
+  }
+
+  std::vector<Move>& moves = moveStack[depth];
+  orderedMoves(state, moves);
+  int best = -HINT_INFINITY;
+  for (const Move& move : moves) {
+    GameState child = state;
+    child.applyMove(move);
+    int value = -negamax(child, depth - 1, -beta, -alpha);
+    if (aborted) {
+      return 0;
+    }
+    best = std::max(best, value);
+    alpha = std::max(alpha, value);
+    if (alpha >= beta) {
+      break;
+    }
+  }
+  return best;
+}
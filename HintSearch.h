@@ -0,0 +1,59 @@
+#ifndef ASSIGN2_HINTSEARCH_H
+#define ASSIGN2_HINTSEARCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "GameState.h"
+
+// Deadline used by the 'hint' command when none is given
+#define HINT_DEFAULT_MS 200
+
+// Hidden-tile layouts each depth is averaged over
+#define HINT_SAMPLES 6
+
+// Nodes searched between clock checks
+#define HINT_CLOCK_INTERVAL 256
+
+struct HintResult {
+  Move move;
+  // Taken from the opening book without searching
+  bool fromBook;
+  // Deepest fully searched depth (1 = best immediate score)
+  int depth;
+  // The deadline cut a deeper search short
+  bool timedOut;
+  long nodes;
+  double elapsedMs;
+};
+
+/*
+ * Anytime move suggestion. Depth 1 is the best immediate score and is
+ * always available; each further depth runs an alpha-beta search on the
+ * score margin, averaged over a few samples of the hidden tiles, with
+ * Evaluator::shared() scoring the positions where it stops. Depths
+ * keep increasing until the deadline, and the answer from the deepest
+ * completed depth is returned.
+ */
+class HintSearch {
+ public:
+  HintSearch(int deadlineMs, uint64_t seed);
+
+  HintResult search(const GameState& state);
+
+ private:
+  int deadlineMs;
+  FastRandom random;
+  std::chrono::steady_clock::time_point deadline;
+  long nodes;
+  bool aborted;
+  std::vector<std::vector<Move>> moveStack;
+
+  int negamax(GameState& state, int depth, int alpha, int beta);
+  bool timeUp();
+  // Placements ordered by immediate score, or a lone pass if none
+  void orderedMoves(const GameState& state, std::vector<Move>& moves);
+};
+
+#endif  // ASSIGN2_HINTSEARCH_H
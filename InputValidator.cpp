@@ -1,7 +1,190 @@
 #include "InputValidator.h"
 
+#include <bitset>
 #include <cctype>
-#include <regex>
+
+#include "CommandParser.h"
+#include "FileHandler.h"
+#include "GameState.h"
+
+namespace {
+struct TextSpan {
+  const char* begin = nullptr;
+  const char* end = nullptr;
+
+  bool empty() const { return begin == end; }
+  size_t size() const { return static_cast<size_t>(end - begin); }
+};
+
+/*
+ * One forward pass over a text save. Every read works on spans of the
+ * data and never backtracks, and the first failure records what went
+ * wrong and where.
+ */
+class SaveScanner {
+ public:
+  SaveScanner(const char* data, size_t size, SaveFormatError& error)
+      : pos(data),
+        end(data + size),
+        lineStart(data),
+        lineNumber(0),
+        error(error) {}
+
+  // The next line without its newline; the last line may lack one
+  bool line(TextSpan& out, const char* what) {
+    lineNumber++;
+    lineStart = pos;
+    if (pos == end) {
+      return fail("Missing", what, {pos, pos});
+    }
+    out.begin = pos;
+    while (pos != end && *pos != '\n') {
+      ++pos;
+    }
+    out.end = pos;
+    if (pos != end) {
+      ++pos;
+    }
+    return true;
+  }
+
+  // A line holding a name of letters, digits and spaces
+  bool name(TextSpan& out, const char* what) {
+    if (!line(out, what)) {
+      return false;
+    }
+    bool ok = !out.empty();
+    for (const char* c = out.begin; c != out.end && ok; ++c) {
+      ok = std::isalnum(static_cast<unsigned char>(*c)) || *c == ' ';
+    }
+    return ok || fail("Invalid", what, out);
+  }
+
+  // Digits only, at most 9 of them
+  static bool toInt(TextSpan text, int& out) {
+    out = 0;
+    if (text.empty() || text.size() > 9) {
+      return false;
+    }
+    for (const char* c = text.begin; c != text.end; ++c) {
+      if (*c < '0' || *c > '9') {
+        return false;
+      }
+      out = out * 10 + (*c - '0');
+    }
+    return true;
+  }
+
+  bool number(TextSpan text, int& out, const char* what) {
+    return toInt(text, out) || fail("Invalid", what, text);
+  }
+
+  // A colour letter and a shape digit, such as "R1"
+  bool tile(TextSpan text, char& colour, int& shape) {
+    if (text.size() != 2 || text.begin[1] < '0' || text.begin[1] > '9' ||
+        GameState::encodeTile(text.begin[0], text.begin[1] - '0') ==
+            EMPTY_CELL) {
+      return fail("Invalid", "tile", text);
+    }
+    colour = text.begin[0];
+    shape = text.begin[1] - '0';
+    return true;
+  }
+
+  // A line of comma-separated tiles, each passed to 'visit'; an empty
+  // line holds none
+  template <typename Visit>
+  bool tiles(const char* what, Visit visit) {
+    TextSpan text;
+    if (!line(text, what)) {
+      return false;
+    }
+    TextSpan item;
+    while (next(text, item)) {
+      char colour = 0;
+      int shape = 0;
+      if (!tile(item, colour, shape)) {
+        return false;
+      }
+      visit(colour, shape);
+    }
+    return true;
+  }
+
+  // Takes the next comma-separated item off the front of 'list'
+  static bool next(TextSpan& list, TextSpan& item) {
+    if (list.empty()) {
+      return false;
+    }
+    item.begin = list.begin;
+    item.end = list.begin;
+    while (item.end != list.end && *item.end != ',') {
+      ++item.end;
+    }
+    list.begin = item.end == list.end ? item.end : item.end + 1;
+    return true;
+  }
+
+  // Splits 'text' at the first 'separator'
+  bool split(TextSpan text, char separator, TextSpan& first, TextSpan& second,
+             const char* what) {
+    const char* at = text.begin;
+    while (at != text.end && *at != separator) {
+      ++at;
+    }
+    if (at == text.end) {
+      return fail("Invalid", what, text);
+    }
+    first = {text.begin, at};
+    second = {at + 1, text.end};
+    return true;
+  }
+
+  // Only blank lines may follow the last field
+  bool finish() {
+    TextSpan text;
+    while (pos != end) {
+      line(text, "data");
+      if (!text.empty()) {
+        return fail("Unexpected", "data", text);
+      }
+    }
+    return true;
+  }
+
+  // Keeps the first failure
+  bool fail(const char* problem, const char* what, TextSpan text) {
+    if (error.problem == nullptr) {
+      error.problem = problem;
+      error.what = what;
+      error.text = text.begin;
+      error.length = text.size();
+      error.line = lineNumber;
+      error.column = static_cast<int>(text.begin - lineStart) + 1;
+    }
+    return false;
+  }
+
+ private:
+  const char* pos;
+  const char* end;
+  const char* lineStart;
+  int lineNumber;
+  SaveFormatError& error;
+};
+}  // namespace
+
+std::string SaveFormatError::message() const {
+  if (problem == nullptr) {
+    return "";
+  }
+  std::string result = std::string("Error: ") + problem + " " + what;
+  if (length > 0) {
+    result += " - " + std::string(text, length);
+  }
+  return result + " at line " + std::to_string(line) + ", column " +
+         std::to_string(column);
+}
 
 bool InputValidator::isValidName(const std::string& name) {
   if (name.empty()) return false;
@@ -13,48 +196,139 @@ bool InputValidator::isValidName(const std::string& name) {
 
 bool InputValidator::isFileNameValid(const std::string& filename) {
   // Check if filename is not empty and contains only valid characters ending
-  // with .txt
-  std::regex validFileNamePattern("^[a-zA-Z0-9./_-]+\\.txt$");
-  bool isValid =
-      !filename.empty() && std::regex_match(filename, validFileNamePattern);
-  return isValid;
+  // with .txt, or .qwb for a binary save
+  size_t dot = filename.rfind('.');
+  if (dot == std::string::npos || dot == 0 ||
+      (filename.compare(dot, std::string::npos, ".txt") != 0 &&
+       filename.compare(dot, std::string::npos, BINARY_SAVE_EXTENSION) !=
+           0)) {
+    return false;
+  }
+  for (char c : filename) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '.' &&
+        c != '/' && c != '_' && c != '-') {
+      return false;
+    }
+  }
+  return true;
 }
 
 // Check if the file format is valid according to the specified game format
 bool InputValidator::isFileFormatValid(const std::string& data) {
-  std::regex validFileFormatPattern(
-      "^[a-zA-Z0-9 ]+\n"                            // Player 1 name
-      "\\d+\n"                                      // Player 1 score
-      "([A-Z][1-6],)*[A-Z][1-6]?\n"                 // Player 1 hand
-      "[a-zA-Z0-9 ]+\n"                             // Player 2 name
-      "\\d+\n"                                      // Player 2 score
-      "([A-Z][1-6],)*[A-Z][1-6]?\n"                 // Player 2 hand
-      "\\d+,\\d+\n"                                 // Board size
-      "([A-Z][1-6]@\\w\\d,)*([A-Z][1-6]@\\w\\d)\n"  // Board tiles
-      "([A-Z][1-6],)*[A-Z][1-6]?\n"                 // Tile bag contents
-      "[a-zA-Z0-9 ]+$"                              // Current player name
-  );
-
-  return std::regex_match(data, validFileFormatPattern);
+  SaveFormatError error;
+  return isFileFormatValid(data, error);
 }
 
-// Check if the input string is in a valid format when 'place' is mentioned
-bool InputValidator::isValidPlaceCommand(const std::string& input) {
-  std::regex placeCommandPattern("place [A-Z][1-6] at [A-Z][0-9]");
-  std::smatch match;
+bool InputValidator::isFileFormatValid(const std::string& data,
+                                       SaveFormatError& error) {
+  return scanSaveText(data.data(), data.size(), nullptr, error);
+}
+
+bool InputValidator::scanSaveText(const char* data, size_t size,
+                                  SaveTextHandler* handler,
+                                  SaveFormatError& error) {
+  error = SaveFormatError();
+  SaveScanner scanner(data, size, error);
+  TextSpan text;
+
+  for (int p = 0; p < 2; ++p) {
+    TextSpan name;
+    int score = 0;
+    if (!scanner.name(name, "player name") ||
+        !scanner.line(text, "player score") ||
+        !scanner.number(text, score, "player score")) {
+      return false;
+    }
+    if (handler != nullptr) {
+      handler->player(p, name.begin, name.size(), score);
+    }
+    bool ok = scanner.tiles("player hand", [handler, p](char colour,
+                                                        int shape) {
+      if (handler != nullptr) {
+        handler->handTile(p, colour, shape);
+      }
+    });
+    if (!ok) {
+      return false;
+    }
+  }
+
+  TextSpan rowsText;
+  TextSpan colsText;
+  int rows = 0;
+  int cols = 0;
+  if (!scanner.line(text, "board size") ||
+      !scanner.split(text, ',', rowsText, colsText, "board size format") ||
+      !scanner.number(rowsText, rows, "board size") ||
+      !scanner.number(colsText, cols, "board size")) {
+    return false;
+  }
+  if (rows < 1 || cols < 1 || rows > SAVE_MAX_BOARD_ROWS ||
+      cols > SAVE_MAX_BOARD_COLS) {
+    return scanner.fail("Invalid", "board size", text);
+  }
+  if (handler != nullptr) {
+    handler->boardSize(rows, cols);
+  }
 
-  // Ensure the input contains "place" and is followed by a valid tile code and
-  // position
-  if (input.find("place") != std::string::npos) {
-    // Check if the entire input matches the place command pattern
-    if (std::regex_search(input, match, placeCommandPattern) &&
-        match.size() > 0) {
-      return true;
-    } else {
+  if (!scanner.line(text, "board tiles")) {
+    return false;
+  }
+  // Cells already holding a tile, so a repeated one fails with or
+  // without a handler
+  std::bitset<SAVE_MAX_BOARD_ROWS * SAVE_MAX_BOARD_COLS> occupied;
+  TextSpan item;
+  while (SaveScanner::next(text, item)) {
+    TextSpan tileText;
+    TextSpan position;
+    char colour = 0;
+    int shape = 0;
+    int col = 0;
+    if (!scanner.split(item, '@', tileText, position, "tile data format")) {
       return false;
     }
+    if (position.empty() || *position.begin < 'A' || *position.begin > 'Z' ||
+        !SaveScanner::toInt({position.begin + 1, position.end}, col)) {
+      return scanner.fail("Invalid", "tile position format", position);
+    }
+    if (!scanner.tile(tileText, colour, shape)) {
+      return false;
+    }
+    int row = *position.begin - 'A';
+    if (row >= rows || col >= cols) {
+      return scanner.fail("Invalid", "tile position", position);
+    }
+    size_t cell = static_cast<size_t>(row) * SAVE_MAX_BOARD_COLS + col;
+    if (occupied.test(cell)) {
+      return scanner.fail("Duplicate", "tile position", position);
+    }
+    occupied.set(cell);
+    if (handler != nullptr && !handler->boardTile(row, col, colour, shape)) {
+      return scanner.fail("Invalid", "tile position", position);
+    }
+  }
+
+  bool ok = scanner.tiles("tile bag", [handler](char colour, int shape) {
+    if (handler != nullptr) {
+      handler->bagTile(colour, shape);
+    }
+  });
+  if (!ok || !scanner.name(text, "current player")) {
+    return false;
+  }
+  if (handler != nullptr) {
+    handler->currentPlayer(text.begin, text.size());
   }
+  return scanner.finish();
+}
 
+// Check if the input string is in a valid format when 'place' is mentioned
+bool InputValidator::isValidPlaceCommand(const std::string& input) {
   // Return true if "place" is not in the input (i.e., not a place command)
-  return true;
+  if (input.find("place") == std::string::npos) {
+    return true;
+  }
+  Command command;
+  return CommandParser::parse(input, true, command) &&
+         command.verb == VERB_PLACE;
 }
@@ -1,8 +1,48 @@
 #ifndef ASSIGN2_INPUTVALIDATOR_H
 #define ASSIGN2_INPUTVALIDATOR_H
 
+#include <cstddef>
 #include <string>
 
+// Largest board a text save may declare: rows are addressed by the
+// letters A-Z, and the binary format stores each dimension in one byte
+#define SAVE_MAX_BOARD_ROWS 26
+#define SAVE_MAX_BOARD_COLS 255
+
+// Where and why a text save stopped matching the format. The fields point
+// into the scanned data, so describing an error is the only allocation.
+struct SaveFormatError {
+  // "Missing", "Invalid" or "Unexpected"
+  const char* problem = nullptr;
+  const char* what = nullptr;
+  // The offending text, possibly empty
+  const char* text = nullptr;
+  size_t length = 0;
+  int line = 0;
+  int column = 0;
+
+  // Such as "Error: Invalid tile - X1 at line 3, column 4"
+  std::string message() const;
+};
+
+/*
+ * Receives each item of a text save as scanSaveText reads it, so a
+ * loader builds the game in the same pass that checks the format.
+ * Returning false from boardTile rejects the cell as an invalid position;
+ * a cell named twice is rejected before it reaches the handler.
+ */
+class SaveTextHandler {
+ public:
+  virtual ~SaveTextHandler() = default;
+  virtual void player(int index, const char* name, size_t length,
+                      int score) = 0;
+  virtual void handTile(int index, char colour, int shape) = 0;
+  virtual void boardSize(int rows, int cols) = 0;
+  virtual bool boardTile(int row, int col, char colour, int shape) = 0;
+  virtual void bagTile(char colour, int shape) = 0;
+  virtual void currentPlayer(const char* name, size_t length) = 0;
+};
+
 class InputValidator {
  public:
   // Validate player name
@@ -13,6 +53,13 @@ class InputValidator {
 
   // Validate file format is acceptable
   static bool isFileFormatValid(const std::string& data);
+  static bool isFileFormatValid(const std::string& data,
+                                SaveFormatError& error);
+
+  // One pass over a text save, stopping at the first error. Linear in the
+  // size of the data and allocation-free; 'handler' may be null.
+  static bool scanSaveText(const char* data, size_t size,
+                           SaveTextHandler* handler, SaveFormatError& error);
 
   // Validate if place tile is correct format
   static bool isValidPlaceCommand(const std::string& input);
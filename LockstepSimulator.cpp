@@ -0,0 +1,377 @@
+#include "LockstepSimulator.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "Rules.h"
+
+// Tiles a bag can hold, the size of each game's bag ring
+#define LOCKSTEP_BAG (NUM_TILE_KINDS * QUANTITY_OF_EACH_TILE)
+
+namespace {
+// Row and column step of each window arm, in PositionBatch order
+const int kArms[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+// Set open[lane] to 1 where the game is running and the target cell is
+// empty; false if no lane is open
+bool openLanes(const uint8_t* active, const uint8_t* target, uint8_t* open) {
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  __m128i lanes = _mm_and_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(active)),
+      _mm_cmpeq_epi8(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(target)), zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(open), lanes);
+  return _mm_movemask_epi8(_mm_cmpgt_epi8(lanes, zero)) != 0;
+#else
+  bool any = false;
+  for (int lane = 0; lane < BATCH_LANES; ++lane) {
+    open[lane] = target[lane] == 0 ? active[lane] : 0;
+    any = any || open[lane] != 0;
+  }
+  return any;
+#endif
+}
+
+// Bit per lane where points beat the best so far
+int improvedLanes(const uint8_t* points, const uint8_t* best) {
+#ifdef __SSE2__
+  return _mm_movemask_epi8(_mm_cmpgt_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(points)),
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(best))));
+#else
+  int mask = 0;
+  for (int lane = 0; lane < BATCH_LANES; ++lane) {
+    mask |= points[lane] > best[lane] ? 1 << lane : 0;
+  }
+  return mask;
+#endif
+}
+}  // namespace
+
+LockstepSimulator::LockstepSimulator(size_t games)
+    : count(games),
+      capacity((games + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES),
+      rows(DEFAULT_BOARD_SIZE),
+      cols(DEFAULT_BOARD_SIZE),
+      paddedCols(DEFAULT_BOARD_SIZE + 2 * LOCKSTEP_BORDER),
+      plies(0) {
+  size_t paddedRows = rows + 2 * LOCKSTEP_BORDER;
+  cellPlane.assign(paddedRows * paddedCols * capacity, 0);
+  handPlane.assign(2 * DEFAULT_HAND_SIZE * capacity, 0);
+  bagPlane.assign(LOCKSTEP_BAG * capacity, 0);
+  bagHead.assign(capacity, 0);
+  bagSize.assign(capacity, 0);
+  handSize[0].assign(capacity, 0);
+  handSize[1].assign(capacity, 0);
+  active.assign(capacity, 0);
+  boardEmpty.assign(capacity, 0);
+  idleTurns.assign(capacity, 0);
+  scores[0].assign(capacity, 0);
+  scores[1].assign(capacity, 0);
+  top.assign(capacity, 0);
+  bottom.assign(capacity, 0);
+  left.assign(capacity, 0);
+  right.assign(capacity, 0);
+}
+
+size_t LockstepSimulator::games() const { return count; }
+
+int LockstepSimulator::score(size_t game, int player) const {
+  return scores[player][game];
+}
+
+long LockstepSimulator::pliesPlayed() const { return plies; }
+
+void LockstepSimulator::run(uint64_t firstSeed) {
+  std::fill(cellPlane.begin(), cellPlane.end(), 0);
+  std::fill(active.begin(), active.end(), 0);
+  for (size_t game = 0; game < count; ++game) {
+    deal(game, firstSeed + game);
+  }
+  plies = 0;
+
+  const uint8_t zeros[BATCH_LANES] = {0};
+  size_t running = count;
+  for (int player = 0; running > 0; player = 1 - player) {
+    for (size_t first = 0; first < capacity; first += BATCH_LANES) {
+      stepBlock(first, player, zeros);
+    }
+    plies += static_cast<long>(running);
+    for (size_t game = 0; game < count; ++game) {
+      if (active[game] != 0 && isFinished(game)) {
+        active[game] = 0;
+        running--;
+      }
+    }
+  }
+}
+
+void LockstepSimulator::deal(size_t game, uint64_t seed) {
+  GameState state = GameState::newGame(seed);
+  for (int player = 0; player < 2; ++player) {
+    const std::vector<TileCode>& hand = state.hands[player];
+    for (size_t slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+      handPlane[(player * DEFAULT_HAND_SIZE + slot) * capacity + game] =
+          slot < hand.size() ? PositionBatch::pack(hand[slot]) : 0;
+    }
+    handSize[player][game] = static_cast<uint8_t>(hand.size());
+    scores[player][game] = 0;
+  }
+  size_t tiles = 0;
+  for (size_t i = state.bagHead; i < state.bag.size(); ++i) {
+    bagPlane[tiles++ * capacity + game] = PositionBatch::pack(state.bag[i]);
+  }
+  bagHead[game] = 0;
+  bagSize[game] = static_cast<uint8_t>(tiles);
+  active[game] = 1;
+  boardEmpty[game] = 1;
+  idleTurns[game] = 0;
+}
+
+void LockstepSimulator::stepBlock(size_t first, int player,
+                                  const uint8_t* zeros) {
+  // Cells to scan: the union of every running board's bounding box grown
+  // by one, or the centre for an empty board
+  int centreRow = LOCKSTEP_BORDER + rows / 2;
+  int centreCol = LOCKSTEP_BORDER + cols / 2;
+  int fromRow = rows + 2 * LOCKSTEP_BORDER;
+  int toRow = -1;
+  int fromCol = paddedCols;
+  int toCol = -1;
+  for (size_t game = first; game < first + BATCH_LANES; ++game) {
+    if (active[game] == 0) {
+      continue;
+    }
+    if (boardEmpty[game] != 0) {
+      fromRow = std::min(fromRow, centreRow);
+      toRow = std::max(toRow, centreRow);
+      fromCol = std::min(fromCol, centreCol);
+      toCol = std::max(toCol, centreCol);
+    } else {
+      fromRow = std::min(fromRow, top[game] - 1);
+      toRow = std::max(toRow, bottom[game] + 1);
+      fromCol = std::min(fromCol, left[game] - 1);
+      toCol = std::max(toCol, right[game] + 1);
+    }
+  }
+  if (toRow < 0) {
+    return;
+  }
+  fromRow = std::max(fromRow, LOCKSTEP_BORDER);
+  toRow = std::min(toRow, LOCKSTEP_BORDER + rows - 1);
+  fromCol = std::max(fromCol, LOCKSTEP_BORDER);
+  toCol = std::min(toCol, LOCKSTEP_BORDER + cols - 1);
+
+  std::ptrdiff_t offsets[BATCH_WINDOW];
+  for (int arm = 0; arm < 4; ++arm) {
+    for (int step = 0; step < BATCH_ARM_LENGTH; ++step) {
+      offsets[arm * BATCH_ARM_LENGTH + step] =
+          (kArms[arm][0] * paddedCols + kArms[arm][1]) * (step + 1) *
+          static_cast<std::ptrdiff_t>(capacity);
+    }
+  }
+  const uint8_t* hand = &handPlane[player * DEFAULT_HAND_SIZE * capacity +
+                                   first];
+  const uint8_t* window[BATCH_WINDOW];
+  uint8_t open[BATCH_LANES];
+  uint8_t legal[BATCH_LANES];
+  uint8_t points[BATCH_LANES];
+  uint8_t best[BATCH_LANES] = {0};
+  int bestCell[BATCH_LANES];
+  int bestSlot[BATCH_LANES];
+
+  for (int row = fromRow; row <= toRow; ++row) {
+    for (int col = fromCol; col <= toCol; ++col) {
+      int cell = row * paddedCols + col;
+      const uint8_t* target = &cellPlane[cell * capacity + first];
+      if (!openLanes(&active[first], target, open)) {
+        continue;
+      }
+      for (int w = 0; w < BATCH_WINDOW; ++w) {
+        window[w] = target + offsets[w];
+      }
+      // Only the centre takes a first tile
+      const uint8_t* empty =
+          row == centreRow && col == centreCol ? &boardEmpty[first] : zeros;
+      for (int slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+        PositionBatch::placementLanes(window, hand + slot * capacity, open,
+                                      hand, capacity, empty, legal, points);
+        int improved = improvedLanes(points, best);
+        for (int lane = 0; improved != 0; ++lane, improved >>= 1) {
+          if (improved & 1) {
+            best[lane] = points[lane];
+            bestCell[lane] = cell;
+            bestSlot[lane] = slot;
+          }
+        }
+      }
+    }
+  }
+
+  for (int lane = 0; lane < BATCH_LANES; ++lane) {
+    size_t game = first + lane;
+    if (active[game] == 0) {
+      continue;
+    }
+    if (best[lane] > 0) {
+      place(game, player, bestCell[lane], bestSlot[lane], best[lane]);
+    } else if (handSize[player][game] > 0 && bagSize[game] > 0) {
+      swapFirst(game, player);
+    } else {
+      idleTurns[game]++;
+    }
+  }
+}
+
+void LockstepSimulator::place(size_t game, int player, int cell, int slot,
+                              int points) {
+  cellPlane[cell * capacity + game] =
+      handPlane[(player * DEFAULT_HAND_SIZE + slot) * capacity + game];
+  removeFromHand(game, player, slot);
+  draw(game, player);
+  scores[player][game] += points;
+  idleTurns[game] = 0;
+
+  int16_t row = static_cast<int16_t>(cell / paddedCols);
+  int16_t col = static_cast<int16_t>(cell % paddedCols);
+  if (boardEmpty[game] != 0) {
+    boardEmpty[game] = 0;
+    top[game] = bottom[game] = row;
+    left[game] = right[game] = col;
+  } else {
+    top[game] = std::min(top[game], row);
+    bottom[game] = std::max(bottom[game], row);
+    left[game] = std::min(left[game], col);
+    right[game] = std::max(right[game], col);
+  }
+}
+
+void LockstepSimulator::swapFirst(size_t game, int player) {
+  uint8_t tile = handPlane[player * DEFAULT_HAND_SIZE * capacity + game];
+  removeFromHand(game, player, 0);
+  bagPlane[(bagHead[game] + bagSize[game]) % LOCKSTEP_BAG * capacity + game] =
+      tile;
+  bagSize[game]++;
+  draw(game, player);
+  idleTurns[game]++;
+}
+
+void LockstepSimulator::removeFromHand(size_t game, int player, int slot) {
+  uint8_t* hand = &handPlane[player * DEFAULT_HAND_SIZE * capacity + game];
+  int size = handSize[player][game];
+  for (int i = slot; i + 1 < size; ++i) {
+    hand[i * capacity] = hand[(i + 1) * capacity];
+  }
+  hand[(size - 1) * capacity] = 0;
+  handSize[player][game]--;
+}
+
+void LockstepSimulator::draw(size_t game, int player) {
+  if (bagSize[game] == 0) {
+    return;
+  }
+  int size = handSize[player][game]++;
+  handPlane[(player * DEFAULT_HAND_SIZE + size) * capacity + game] =
+      bagPlane[bagHead[game] * capacity + game];
+  bagHead[game] = static_cast<uint8_t>((bagHead[game] + 1) % LOCKSTEP_BAG);
+  bagSize[game]--;
+}
+
+bool LockstepSimulator::isFinished(size_t game) const {
+  return (handSize[0][game] == 0 && handSize[1][game] == 0 &&
+          bagSize[game] == 0) ||
+         idleTurns[game] >= MAX_IDLE_TURNS;
+}
+
+void LockstepSimulator::playObjects(uint64_t seed, int scores[2]) {
+  GameState dealt = GameState::newGame(seed);
+  GameBoard board(dealt.getRows(), dealt.getCols());
+  Player first("1");
+  Player second("2");
+  Player* players[2] = {&first, &second};
+  for (int player = 0; player < 2; ++player) {
+    for (TileCode code : dealt.hands[player]) {
+      players[player]->addTileToHand(
+          new Tile(GameState::colourOf(code), GameState::shapeOf(code)));
+    }
+  }
+  std::vector<Tile*> tiles;
+  for (size_t i = dealt.bagHead; i < dealt.bag.size(); ++i) {
+    tiles.push_back(new Tile(GameState::colourOf(dealt.bag[i]),
+                             GameState::shapeOf(dealt.bag[i])));
+  }
+  TileBag tileBag(tiles);
+
+  bool empty = true;
+  int top = 0;
+  int bottom = 0;
+  int left = 0;
+  int right = 0;
+  int idle = 0;
+  for (int turn = 0; !Rules::isGameOver(&first, &second, &tileBag) &&
+                     idle < MAX_IDLE_TURNS;
+       ++turn) {
+    Player* player = players[turn % 2];
+    int fromRow = empty ? board.getRows() / 2 : std::max(top - 1, 0);
+    int toRow = empty ? fromRow : std::min(bottom + 1, board.getRows() - 1);
+    int fromCol = empty ? board.getCols() / 2 : std::max(left - 1, 0);
+    int toCol = empty ? fromCol : std::min(right + 1, board.getCols() - 1);
+
+    int best = 0;
+    int bestRow = 0;
+    int bestCol = 0;
+    Tile* bestTile = nullptr;
+    for (int row = fromRow; row <= toRow; ++row) {
+      for (int col = fromCol; col <= toCol; ++col) {
+        for (Node* node = player->getHand()->getHead(); node != nullptr;
+             node = node->getNext()) {
+          if (!Rules::validateMove(&board, node->getTile(), row, col)) {
+            continue;
+          }
+          int points = Rules::calculateScore(&board, row, col);
+          if (points > best) {
+            best = points;
+            bestRow = row;
+            bestCol = col;
+            bestTile = node->getTile();
+          }
+        }
+      }
+    }
+
+    if (bestTile != nullptr) {
+      board.placeTile(bestRow, bestCol, player->removeTileFromHand(bestTile));
+      Tile* drawn = tileBag.drawTile();
+      if (drawn != nullptr) {
+        player->addTileToHand(drawn);
+      }
+      player->setScore(player->getScore() +
+                       Rules::calculateScore(&board, bestRow, bestCol));
+      idle = 0;
+      if (empty) {
+        empty = false;
+        top = bottom = bestRow;
+        left = right = bestCol;
+      } else {
+        top = std::min(top, bestRow);
+        bottom = std::max(bottom, bestRow);
+        left = std::min(left, bestCol);
+        right = std::max(right, bestCol);
+      }
+    } else if (player->getHand()->getHead() != nullptr &&
+               !tileBag.isEmpty()) {
+      tileBag.addTile(
+          player->removeTileFromHand(player->getHand()->getHead()->getTile()));
+      player->addTileToHand(tileBag.drawTile());
+      idle++;
+    } else {
+      idle++;
+    }
+  }
+  scores[0] = first.getScore();
+  scores[1] = second.getScore();
+}
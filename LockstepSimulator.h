@@ -0,0 +1,88 @@
+#ifndef ASSIGN2_LOCKSTEPSIMULATOR_H
+#define ASSIGN2_LOCKSTEPSIMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GameState.h"
+#include "PositionBatch.h"
+
+// Default number of games for 'qwirkle simulate'
+#define LOCKSTEP_DEFAULT_GAMES 512
+
+// Empty border around each board so that every window read stays inside
+// the planes
+#define LOCKSTEP_BORDER BATCH_ARM_LENGTH
+
+/*
+ * Plays many independent games on one thread, one ply of every game per
+ * step. Boards, hands and bags are kept structure-of-arrays style as
+ * [cell or slot][game], with cells packed as in PositionBatch, so a
+ * candidate placement is checked and scored for BATCH_LANES games at
+ * once by PositionBatch::placementLanes.
+ *
+ * Every game follows the same fixed policy: place the highest-scoring
+ * legal tile, taking the first in row-major cell order and then hand
+ * order on ties, with the first move in the centre of the board; with
+ * nothing to place, swap the first tile in hand while the bag has tiles,
+ * otherwise pass. playObjects() plays the same policy on
+ * GameBoard/Player/TileBag objects, so both give identical games for
+ * the same seed.
+ */
+class LockstepSimulator {
+ public:
+  explicit LockstepSimulator(size_t games);
+
+  // Deal game i as GameState::newGame(firstSeed + i) and play all of them
+  // to the end
+  void run(uint64_t firstSeed);
+
+  size_t games() const;
+  int score(size_t game, int player) const;
+  // Plies played over all games in the last run
+  long pliesPlayed() const;
+
+  // One game of the same policy on the game objects, scores into 'scores'
+  static void playObjects(uint64_t seed, int scores[2]);
+
+ private:
+  size_t count;
+  size_t capacity;
+  int rows;
+  int cols;
+  // Plane dimensions including the border
+  int paddedCols;
+  long plies;
+
+  // [padded cell * capacity + game], packed cell bytes
+  std::vector<uint8_t> cellPlane;
+  // [(player * DEFAULT_HAND_SIZE + slot) * capacity + game], packed tiles
+  // in hand order with 0 after the last
+  std::vector<uint8_t> handPlane;
+  // [index * capacity + game], a ring of packed tiles per game
+  std::vector<uint8_t> bagPlane;
+  std::vector<uint8_t> bagHead;
+  std::vector<uint8_t> bagSize;
+  std::vector<uint8_t> handSize[2];
+  std::vector<uint8_t> active;
+  std::vector<uint8_t> boardEmpty;
+  std::vector<uint8_t> idleTurns;
+  std::vector<int> scores[2];
+  // Bounding box of each board, in padded coordinates
+  std::vector<int16_t> top;
+  std::vector<int16_t> bottom;
+  std::vector<int16_t> left;
+  std::vector<int16_t> right;
+
+  void deal(size_t game, uint64_t seed);
+  // Find and play the move of 'player' in the games of one block
+  void stepBlock(size_t first, int player, const uint8_t* zeros);
+  void place(size_t game, int player, int cell, int slot, int points);
+  void swapFirst(size_t game, int player);
+  void removeFromHand(size_t game, int player, int slot);
+  void draw(size_t game, int player);
+  bool isFinished(size_t game) const;
+};
+
+#endif  // ASSIGN2_LOCKSTEPSIMULATOR_H
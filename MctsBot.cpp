@@ -0,0 +1,242 @@
+#include "MctsBot.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "HandTable.h"
+#include "OpeningBook.h"
+
+MctsConfig::MctsConfig()
+    : iterations(MCTS_DEFAULT_ITERATIONS),
+      timeBudgetMs(MCTS_DEFAULT_TIME_MS),
+      exploration(MCTS_DEFAULT_EXPLORATION),
+      widening(MCTS_DEFAULT_WIDENING),
+      seed(1) {}
+
+int MctsConfig::iterationLimit() const {
+  if (iterations > 0) {
+    return iterations;
+  }
+  return timeBudgetMs > 0 ? 0 : MCTS_DEFAULT_ITERATIONS;
+}
+
+SearchStats::SearchStats()
+    : iterations(0), treeNodes(0), nodesVisited(0), elapsedMs(0.0) {}
+
+double SearchStats::nodesPerSecond() const {
+  if (elapsedMs <= 0.0) {
+    return 0.0;
+  }
+  return nodesVisited * 1000.0 / elapsedMs;
+}
+
+MctsBot::MctsBot(const MctsConfig& config)
+    : config(config), random(config.seed) {}
+
+const SearchStats& MctsBot::getStats() const { return stats; }
+
+double MctsBot::terminalReward(const GameState& state, int player) {
+  // Mostly win/loss, with the margin breaking ties between wins
+  double margin = state.scoreMargin(player);
+  return 0.5 + 0.5 * std::tanh(margin / 10.0);
+}
+
+Move MctsBot::greedyMove(const GameState& state, std::vector<Move>& scratch,
+                         FastRandom& random) {
+  state.generateMoves(scratch);
+  int bestScore = -1;
+  int ties = 0;
+  Move best = scratch[0];
+  for (const Move& move : scratch) {
+    if (move.type != MOVE_PLACE) {
+      continue;
+    }
+    int score = state.scorePlacement(move.row, move.col);
+    if (score > bestScore) {
+      bestScore = score;
+      best = move;
+      ties = 1;
+    } else if (score == bestScore && random.below(++ties) == 0) {
+      best = move;
+    }
+  }
+  if (bestScore < 0) {
+    // Nothing fits: swap the tile the hand table says to give up, if
+    // there is one to draw
+    HandAdvice advice;
+    if (state.bagSize() > 0 &&
+        HandTable::shared().lookup(state.hands[state.toMove], advice)) {
+      best = {MOVE_REPLACE, advice.discard, 0, 0};
+    } else {
+      best = scratch[random.below(static_cast<unsigned int>(scratch.size()))];
+    }
+  }
+  return best;
+}
+
+bool MctsBot::canExpand(const MctsConfig& config, int visits,
+                        size_t children) {
+  if (config.widening <= 0.0 || children == 0) {
+    return true;
+  }
+  return children < 1 + config.widening * std::sqrt(visits);
+}
+
+int MctsBot::pickExpansion(const GameState& state,
+                           const std::vector<Move>& untried,
+                           FastRandom& random) {
+  int best = 0;
+  int bestScore = -1;
+  int ties = 0;
+  for (size_t i = 0; i < untried.size(); ++i) {
+    const Move& move = untried[i];
+    int score =
+        move.type == MOVE_PLACE ? state.scorePlacement(move.row, move.col) : 0;
+    if (score > bestScore) {
+      bestScore = score;
+      best = static_cast<int>(i);
+      ties = 1;
+    } else if (score == bestScore && random.below(++ties) == 0) {
+      best = static_cast<int>(i);
+    }
+  }
+  return best;
+}
+
+Move MctsBot::chooseMove(const GameState& state) {
+  stats = SearchStats();
+  Move bookMove;
+  if (OpeningBook::shared().lookup(state, bookMove)) {
+    return bookMove;
+  }
+  tree.clear();
+  tree.push_back({{MOVE_PASS, EMPTY_CELL, 0, 0}, 1 - state.toMove, -1, -1, -1,
+                  0, 0, 0.0});
+
+  state.generateMoves(legal);
+  if (legal.size() == 1) {
+    return legal[0];
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(config.timeBudgetMs);
+  int limit = config.iterationLimit();
+  while (limit == 0 || stats.iterations < limit) {
+    if (config.timeBudgetMs > 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    runIteration(state);
+    stats.iterations++;
+  }
+  stats.elapsedMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  stats.treeNodes = static_cast<long>(tree.size());
+
+  // The most visited root child is the most robust choice
+  int bestChild = -1;
+  for (int child = tree[0].firstChild; child != -1;
+       child = tree[child].nextSibling) {
+    // Ties on visits go to the better average reward
+    if (bestChild == -1 || tree[child].visits > tree[bestChild].visits ||
+        (tree[child].visits == tree[bestChild].visits &&
+         tree[child].reward > tree[bestChild].reward)) {
+      bestChild = child;
+    }
+  }
+  if (bestChild == -1) {
+    return greedyMove(state, legal, random);
+  }
+  return tree[bestChild].move;
+}
+
+int MctsBot::addChild(int parent, const Move& move, int player) {
+  int index = static_cast<int>(tree.size());
+  tree.push_back(
+      {move, player, parent, -1, tree[parent].firstChild, 0, 1, 0.0});
+  tree[parent].firstChild = index;
+  return index;
+}
+
+void MctsBot::runIteration(const GameState& root) {
+  GameState state = root;
+  state.determinize(root.toMove, random);
+
+  int node = 0;
+  path.clear();
+  path.push_back(node);
+
+  bool expanded = false;
+  while (!expanded && !state.isTerminal()) {
+    state.generateMoves(legal);
+    stats.nodesVisited++;
+
+    // Split the legal moves into ones with a child already and new ones
+    compatible.clear();
+    untried.clear();
+    for (const Move& move : legal) {
+      int found = -1;
+      for (int child = tree[node].firstChild; child != -1;
+           child = tree[child].nextSibling) {
+        if (tree[child].move == move) {
+          found = child;
+          break;
+        }
+      }
+      if (found == -1) {
+        untried.push_back(move);
+      } else {
+        compatible.push_back(found);
+        tree[found].availability++;
+      }
+    }
+
+    int next;
+    if (!untried.empty() &&
+        canExpand(config, tree[node].visits, compatible.size())) {
+      const Move& move = untried[pickExpansion(state, untried, random)];
+      next = addChild(node, move, state.toMove);
+      expanded = true;
+    } else {
+      next = compatible[0];
+      double bestValue = -1.0;
+      for (int child : compatible) {
+        const TreeNode& candidate = tree[child];
+        double value = candidate.reward / candidate.visits +
+                       config.exploration *
+                           std::sqrt(std::log(candidate.availability) /
+                                     candidate.visits);
+        if (value > bestValue) {
+          bestValue = value;
+          next = child;
+        }
+      }
+    }
+    state.applyMove(tree[next].move);
+    node = next;
+    path.push_back(node);
+  }
+
+  double reward = rollout(state, root.toMove);
+  for (int index : path) {
+    TreeNode& visited = tree[index];
+    visited.visits++;
+    visited.reward += visited.player == root.toMove ? reward : 1.0 - reward;
+  }
+}
+
+double MctsBot::rollout(GameState& state, int rootPlayer) {
+  while (!state.isTerminal()) {
+    Move move;
+    if (random.below(10) < 2) {
+      state.generateMoves(legal);
+      move = legal[random.below(static_cast<unsigned int>(legal.size()))];
+    } else {
+      move = greedyMove(state, legal, random);
+    }
+    state.applyMove(move);
+    stats.nodesVisited++;
+  }
+  return terminalReward(state, rootPlayer);
+}
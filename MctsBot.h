@@ -0,0 +1,105 @@
+#ifndef ASSIGN2_MCTSBOT_H
+#define ASSIGN2_MCTSBOT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Bot.h"
+#include "GameState.h"
+
+// Defaults used when no budget is given
+#define MCTS_DEFAULT_ITERATIONS 100000
+#define MCTS_DEFAULT_TIME_MS 100
+#define MCTS_DEFAULT_EXPLORATION 0.7
+#define MCTS_DEFAULT_WIDENING 0.5
+
+struct MctsConfig {
+  // Stop after this many iterations (0 = no iteration limit)
+  int iterations;
+  // Stop after this many milliseconds (0 = no time limit)
+  int timeBudgetMs;
+  // UCB exploration constant
+  double exploration;
+  // Progressive widening: a node with n visits may have at most
+  // 1 + widening * sqrt(n) children (0 = expand every move)
+  double widening;
+  uint64_t seed;
+
+  MctsConfig();
+  // Iterations to stop after (0 = none). With neither limit set this is
+  // MCTS_DEFAULT_ITERATIONS, so every search ends.
+  int iterationLimit() const;
+};
+
+struct SearchStats {
+  long iterations;
+  long treeNodes;
+  // Positions visited, counting both tree steps and rollout plies
+  long nodesVisited;
+  double elapsedMs;
+
+  SearchStats();
+  double nodesPerSecond() const;
+};
+
+/*
+ * Information-set Monte Carlo tree search (single observer).
+ * Each iteration samples a determinization of the hidden tiles (the
+ * opponent's hand and the bag order) consistent with what the player to
+ * move can see, then walks one shared tree restricted to the moves legal
+ * in that sample.
+ */
+class MctsBot : public Bot {
+ public:
+  explicit MctsBot(const MctsConfig& config);
+
+  // Pick a move for the player to move in 'state'
+  Move chooseMove(const GameState& state) override;
+
+  const SearchStats& getStats() const;
+
+  // Reward in [0, 1] for 'player' at the end of a simulated game
+  static double terminalReward(const GameState& state, int player);
+
+  // True if a node with 'visits' visits and 'children' compatible
+  // children may still add another child
+  static bool canExpand(const MctsConfig& config, int visits, size_t children);
+
+  // Untried move to expand next: the best immediate score first, so
+  // even a small budget never plays worse than greedy
+  static int pickExpansion(const GameState& state,
+                           const std::vector<Move>& untried,
+                           FastRandom& random);
+
+  // Highest scoring placement, or the first other legal move if none
+  static Move greedyMove(const GameState& state, std::vector<Move>& scratch,
+                         FastRandom& random);
+
+ private:
+  struct TreeNode {
+    Move move;
+    // Player who made 'move' to reach this node
+    int player;
+    int parent;
+    int firstChild;
+    int nextSibling;
+    int visits;
+    int availability;
+    double reward;
+  };
+
+  MctsConfig config;
+  SearchStats stats;
+  FastRandom random;
+  std::vector<TreeNode> tree;
+  std::vector<Move> legal;
+  std::vector<Move> untried;
+  std::vector<int> compatible;
+  std::vector<int> path;
+
+  void runIteration(const GameState& root);
+  int addChild(int parent, const Move& move, int player);
+  double rollout(GameState& state, int rootPlayer);
+};
+
+#endif  // ASSIGN2_MCTSBOT_H
@@ -0,0 +1,224 @@
+#include "OpeningBook.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "MctsBot.h"
+#include "ThreadPool.h"
+
+BookConfig::BookConfig()
+    : games(BOOK_DEFAULT_GAMES),
+      plies(BOOK_DEFAULT_PLIES),
+      iterations(BOOK_DEFAULT_ITERATIONS),
+      seed(1) {}
+
+OpeningBook::OpeningBook()
+    : mapping(nullptr),
+      mappingBytes(0),
+      records(nullptr),
+      count(0),
+      maxTiles(0) {}
+
+OpeningBook::~OpeningBook() { close(); }
+
+OpeningBook& OpeningBook::shared() {
+  static OpeningBook book;
+  return book;
+}
+
+bool OpeningBook::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<size_t>(info.st_size) < sizeof(BookHeader)) {
+    ::close(fd);
+    return false;
+  }
+  size_t bytes = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (mapped == MAP_FAILED) {
+    return false;
+  }
+
+  const BookHeader* header = static_cast<const BookHeader*>(mapped);
+  if (std::memcmp(header->magic, BOOK_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != BOOK_VERSION ||
+      bytes != sizeof(BookHeader) + header->count * sizeof(BookRecord)) {
+    munmap(mapped, bytes);
+    return false;
+  }
+  mapping = mapped;
+  mappingBytes = bytes;
+  records = reinterpret_cast<const BookRecord*>(header + 1);
+  count = header->count;
+  maxTiles = static_cast<int>(header->maxTiles);
+  return true;
+}
+
+void OpeningBook::close() {
+  if (mapping != nullptr) {
+    munmap(mapping, mappingBytes);
+  }
+  mapping = nullptr;
+  mappingBytes = 0;
+  records = nullptr;
+  count = 0;
+  maxTiles = 0;
+}
+
+bool OpeningBook::isOpen() const { return records != nullptr; }
+
+size_t OpeningBook::size() const { return count; }
+
+bool OpeningBook::lookup(const GameState& state, Move& move) const {
+  if (records == nullptr || state.placedTiles() > maxTiles) {
+    return false;
+  }
+  CanonicalForm form = CanonicalForm::of(state, CANON_OWN_HAND);
+  uint64_t key = form.getKey();
+  const BookRecord* end = records + count;
+  const BookRecord* found =
+      std::lower_bound(records, end, key,
+                       [](const BookRecord& record, uint64_t wanted) {
+                         return record.key < wanted;
+                       });
+  if (found == end || found->key != key) {
+    return false;
+  }
+
+  Move canonical = {static_cast<MoveType>(found->type), found->tile,
+                    found->row, found->col};
+  Move mapped = form.fromCanonical(canonical);
+  // A key collision, or a position pushed against the edge of the board,
+  // can give a move that does not fit here
+  const std::vector<TileCode>& hand = state.hands[state.toMove];
+  if (std::find(hand.begin(), hand.end(), mapped.tile) == hand.end()) {
+    return false;
+  }
+  if (mapped.type == MOVE_PLACE &&
+      state.isValidPlacement(mapped.tile, mapped.row, mapped.col)) {
+    move = mapped;
+    return true;
+  }
+  if (mapped.type == MOVE_REPLACE && state.bagSize() > 0) {
+    move = mapped;
+    return true;
+  }
+  return false;
+}
+
+bool OpeningBook::build(const BookConfig& config, const std::string& path,
+                        BookBuildStats& stats) {
+  auto start = std::chrono::steady_clock::now();
+  stats.positions = 0;
+  stats.repeats = 0;
+
+  std::vector<GameState> games;
+  for (int i = 0; i < config.games; ++i) {
+    games.push_back(GameState::newGame(config.seed + i));
+  }
+
+  // One ply of every game at a time, so positions reached by several
+  // games are searched once and the searches can run side by side
+  std::unordered_map<uint64_t, BookRecord> book;
+  ThreadPool& pool = ThreadPool::shared();
+  for (int ply = 0; ply < config.plies; ++ply) {
+    std::vector<CanonicalForm> forms(games.size());
+    std::vector<size_t> fresh;
+    std::unordered_map<uint64_t, size_t> firstSeen;
+    for (size_t i = 0; i < games.size(); ++i) {
+      if (games[i].isTerminal()) {
+        continue;
+      }
+      forms[i] = CanonicalForm::of(games[i], CANON_OWN_HAND);
+      uint64_t key = forms[i].getKey();
+      if (book.count(key) == 0 && firstSeen.count(key) == 0) {
+        firstSeen[key] = i;
+        fresh.push_back(i);
+      }
+    }
+
+    // Each search is seeded from its position, so the book does not
+    // depend on how the pool schedules them
+    std::vector<Move> chosen(fresh.size());
+    TaskGroup group;
+    for (size_t j = 0; j < fresh.size(); ++j) {
+      pool.submit(group, [&config, &games, &forms, &fresh, &chosen, j]() {
+        MctsConfig search;
+        search.iterations = config.iterations;
+        search.timeBudgetMs = 0;
+        search.seed = config.seed ^ forms[fresh[j]].getKey();
+        MctsBot bot(search);
+        chosen[j] = forms[fresh[j]].toCanonical(
+            bot.chooseMove(games[fresh[j]]));
+      });
+    }
+    pool.wait(group);
+    for (size_t j = 0; j < fresh.size(); ++j) {
+      const Move& move = chosen[j];
+      book[forms[fresh[j]].getKey()] = {forms[fresh[j]].getKey(),
+                                        static_cast<uint8_t>(move.type),
+                                        move.tile,
+                                        static_cast<int8_t>(move.row),
+                                        static_cast<int8_t>(move.col),
+                                        0,
+                                        0};
+    }
+
+    // Every game follows the book, so later plies are book replies
+    for (size_t i = 0; i < games.size(); ++i) {
+      if (games[i].isTerminal()) {
+        continue;
+      }
+      BookRecord& record = book[forms[i].getKey()];
+      if (record.samples < UINT16_MAX) {
+        record.samples++;
+      }
+      Move canonical = {static_cast<MoveType>(record.type), record.tile,
+                        record.row, record.col};
+      games[i].applyMove(forms[i].fromCanonical(canonical));
+    }
+  }
+
+  std::vector<BookRecord> sorted;
+  for (const auto& entry : book) {
+    sorted.push_back(entry.second);
+    if (entry.second.samples > 1) {
+      stats.repeats++;
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const BookRecord& a, const BookRecord& b) {
+              return a.key < b.key;
+            });
+  stats.positions = static_cast<int>(sorted.size());
+
+  BookHeader header;
+  std::memcpy(header.magic, BOOK_MAGIC, sizeof(header.magic));
+  header.version = BOOK_VERSION;
+  header.maxTiles = static_cast<uint32_t>(std::max(config.plies - 1, 0));
+  header.count = static_cast<uint32_t>(sorted.size());
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(sorted.data()),
+            sorted.size() * sizeof(BookRecord));
+  stats.elapsedMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  return static_cast<bool>(out);
+}
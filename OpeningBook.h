@@ -0,0 +1,102 @@
+#ifndef ASSIGN2_OPENINGBOOK_H
+#define ASSIGN2_OPENINGBOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "CanonicalForm.h"
+#include "GameState.h"
+
+// Defaults for 'qwirkle book'
+#define BOOK_DEFAULT_GAMES 200
+#define BOOK_DEFAULT_PLIES 2
+#define BOOK_DEFAULT_ITERATIONS 2000
+
+#define BOOK_MAGIC "QWBK"
+#define BOOK_VERSION 2
+
+// On-disk layout, written in the byte order of the host that built it
+struct BookHeader {
+  char magic[4];
+  uint32_t version;
+  // Lookups are skipped once the board holds more tiles than this
+  uint32_t maxTiles;
+  uint32_t count;
+};
+
+// One position: its canonical key and the best move in canonical terms
+struct BookRecord {
+  uint64_t key;
+  uint8_t type;
+  uint8_t tile;
+  // Relative to the cropped board, so one step outside it is -1
+  int8_t row;
+  int8_t col;
+  // Generated games that reached this position
+  uint16_t samples;
+  uint16_t reserved;
+};
+
+struct BookConfig {
+  // Seeded games played from the first deal
+  int games;
+  // Moves per game taken into the book
+  int plies;
+  // MCTS iterations spent on each new position
+  int iterations;
+  uint64_t seed;
+
+  BookConfig();
+};
+
+struct BookBuildStats {
+  int positions;
+  // Positions reached more than once across the generated games
+  int repeats;
+  double elapsedMs;
+};
+
+/*
+ * Precomputed best moves for the first few turns, keyed by the canonical
+ * form of the board and the hand of the player to move (what that player
+ * can see), so every rotation, reflection, translation and renaming of
+ * colours or shapes of a position shares one record. The file is a
+ * header followed by records sorted by key; it is memory-mapped
+ * read-only and looked up with a binary search, so loading is instant
+ * and the pages are shared by every process using the same book.
+ */
+class OpeningBook {
+ public:
+  OpeningBook();
+  ~OpeningBook();
+
+  OpeningBook(const OpeningBook& other) = delete;
+  OpeningBook& operator=(const OpeningBook& other) = delete;
+
+  // Engine-wide book consulted by the bots and hints; empty until opened
+  static OpeningBook& shared();
+
+  bool open(const std::string& path);
+  void close();
+  bool isOpen() const;
+  size_t size() const;
+
+  // Book move for the player to move, mapped onto this position; false if
+  // the position is not in the book
+  bool lookup(const GameState& state, Move& move) const;
+
+  // Play seeded games, search every new position among the first plies
+  // with MCTS on the shared thread pool and write the sorted book
+  static bool build(const BookConfig& config, const std::string& path,
+                    BookBuildStats& stats);
+
+ private:
+  void* mapping;
+  size_t mappingBytes;
+  const BookRecord* records;
+  size_t count;
+  int maxTiles;
+};
+
+#endif  // ASSIGN2_OPENINGBOOK_H
@@ -0,0 +1,301 @@
+#include "ParallelMcts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "OpeningBook.h"
+#include "ThreadPool.h"
+
+#define REWARD_SCALE 1000000.0
+
+double ScalingReport::speedup() const {
+  if (singleThreadRate <= 0.0) {
+    return 0.0;
+  }
+  return multiThreadRate / singleThreadRate;
+}
+
+double ScalingReport::efficiency() const {
+  if (threads <= 0) {
+    return 0.0;
+  }
+  return speedup() / threads;
+}
+
+ParallelMcts::Worker::Worker(uint64_t seed) : random(seed), nodesVisited(0) {}
+
+ParallelMcts::ParallelMcts(const MctsConfig& config, int threads)
+    : config(config),
+      threads(std::max(1, std::min(threads, ThreadPool::shared().size() + 1))),
+      nodes(new TreeNode[PARALLEL_MCTS_NODE_CAPACITY]),
+      nodeCount(0),
+      iterationsStarted(0),
+      stopFlag(false) {}
+
+const SearchStats& ParallelMcts::getStats() const { return stats; }
+
+int ParallelMcts::getThreads() const { return threads; }
+
+void ParallelMcts::resetTree(int rootPlayer) {
+  TreeNode& root = nodes[0];
+  root.move = {MOVE_PASS, EMPTY_CELL, 0, 0};
+  root.player = 1 - rootPlayer;
+  root.nextSibling = -1;
+  root.firstChild.store(-1);
+  root.visits.store(0);
+  root.virtualLoss.store(0);
+  root.availability.store(0);
+  root.reward.store(0);
+  nodeCount.store(1);
+  iterationsStarted.store(0);
+  stopFlag.store(false);
+}
+
+Move ParallelMcts::chooseMove(const GameState& state) {
+  stats = SearchStats();
+  Move bookMove;
+  if (OpeningBook::shared().lookup(state, bookMove)) {
+    return bookMove;
+  }
+  resetTree(state.toMove);
+
+  std::vector<Move> legal;
+  state.generateMoves(legal);
+  if (legal.size() == 1) {
+    return legal[0];
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < threads; ++i) {
+    workers.emplace_back(new Worker(config.seed * 7919 + i + 1));
+  }
+
+  // Helpers run on the engine-wide pool so concurrent searches share cores
+  ThreadPool& pool = ThreadPool::shared();
+  TaskGroup group;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 1; i < threads; ++i) {
+    pool.submit(group,
+                [this, &state, &workers, i]() { workerLoop(state, *workers[i]); });
+  }
+  // The calling thread works too
+  workerLoop(state, *workers[0]);
+  pool.wait(group);
+  stats.elapsedMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  stats.iterations = nodes[0].visits.load();
+  stats.treeNodes = std::min(nodeCount.load(), PARALLEL_MCTS_NODE_CAPACITY);
+  for (const auto& worker : workers) {
+    stats.nodesVisited += worker->nodesVisited;
+  }
+
+  int bestChild = -1;
+  for (int child = nodes[0].firstChild.load(); child != -1;
+       child = nodes[child].nextSibling) {
+    int visits = nodes[child].visits.load();
+    int bestVisits = bestChild == -1 ? -1 : nodes[bestChild].visits.load();
+    // Ties on visits go to the better average reward
+    if (visits > bestVisits ||
+        (visits == bestVisits &&
+         nodes[child].reward.load() > nodes[bestChild].reward.load())) {
+      bestChild = child;
+    }
+  }
+  if (bestChild == -1) {
+    FastRandom random(config.seed);
+    return MctsBot::greedyMove(state, legal, random);
+  }
+  return nodes[bestChild].move;
+}
+
+void ParallelMcts::workerLoop(const GameState& root, Worker& worker) {
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(config.timeBudgetMs);
+  int limit = config.iterationLimit();
+  while (!stopFlag.load(std::memory_order_relaxed)) {
+    if (limit > 0 &&
+        iterationsStarted.fetch_add(1, std::memory_order_relaxed) >= limit) {
+      stopFlag.store(true);
+      break;
+    }
+    if (config.timeBudgetMs > 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      stopFlag.store(true);
+      break;
+    }
+    runIteration(root, worker);
+  }
+}
+
+int ParallelMcts::findSibling(int from, int stopAt, const Move& move) const {
+  for (int child = from; child != stopAt && child != -1;
+       child = nodes[child].nextSibling) {
+    if (nodes[child].move == move) {
+      return child;
+    }
+  }
+  return -1;
+}
+
+int ParallelMcts::addChild(int parent, const Move& move, int player) {
+  std::atomic<int>& head = nodes[parent].firstChild;
+  int seen = head.load(std::memory_order_acquire);
+  int existing = findSibling(seen, -1, move);
+  if (existing != -1) {
+    return existing;
+  }
+
+  int index = nodeCount.fetch_add(1, std::memory_order_relaxed);
+  if (index >= PARALLEL_MCTS_NODE_CAPACITY) {
+    return -1;
+  }
+  TreeNode& child = nodes[index];
+  child.move = move;
+  child.player = player;
+  child.firstChild.store(-1, std::memory_order_relaxed);
+  child.visits.store(0, std::memory_order_relaxed);
+  child.virtualLoss.store(0, std::memory_order_relaxed);
+  child.availability.store(1, std::memory_order_relaxed);
+  child.reward.store(0, std::memory_order_relaxed);
+
+  while (true) {
+    child.nextSibling = seen;
+    int expected = seen;
+    if (head.compare_exchange_weak(expected, index, std::memory_order_release,
+                                   std::memory_order_acquire)) {
+      return index;
+    }
+    // Another thread pushed first; it may have added the same move, in
+    // which case our slot is simply left unused
+    existing = findSibling(expected, seen, move);
+    if (existing != -1) {
+      return existing;
+    }
+    seen = expected;
+  }
+}
+
+void ParallelMcts::runIteration(const GameState& root, Worker& worker) {
+  GameState state = root;
+  state.determinize(root.toMove, worker.random);
+
+  int node = 0;
+  worker.path.clear();
+  worker.path.push_back(node);
+
+  bool expanded = false;
+  while (!expanded && !state.isTerminal()) {
+    state.generateMoves(worker.legal);
+    worker.nodesVisited++;
+
+    worker.compatible.clear();
+    worker.untried.clear();
+    int head = nodes[node].firstChild.load(std::memory_order_acquire);
+    for (const Move& move : worker.legal) {
+      int found = findSibling(head, -1, move);
+      if (found == -1) {
+        worker.untried.push_back(move);
+      } else {
+        worker.compatible.push_back(found);
+        nodes[found].availability.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+
+    int next = -1;
+    if (!worker.untried.empty() &&
+        MctsBot::canExpand(config, nodes[node].visits.load(),
+                           worker.compatible.size())) {
+      const Move& move = worker.untried[MctsBot::pickExpansion(
+          state, worker.untried, worker.random)];
+      next = addChild(node, move, state.toMove);
+      if (next == -1) {
+        // Pool exhausted: finish this iteration with a plain rollout
+        break;
+      }
+      expanded = true;
+    } else {
+      double bestValue = -1.0;
+      for (int child : worker.compatible) {
+        const TreeNode& candidate = nodes[child];
+        int visits = candidate.visits.load(std::memory_order_relaxed) +
+                     candidate.virtualLoss.load(std::memory_order_relaxed);
+        double value;
+        if (visits == 0) {
+          value = 1e9;
+        } else {
+          int availability =
+              candidate.availability.load(std::memory_order_relaxed);
+          value = candidate.reward.load(std::memory_order_relaxed) /
+                      REWARD_SCALE / visits +
+                  config.exploration *
+                      std::sqrt(std::log(availability) / visits);
+        }
+        if (value > bestValue) {
+          bestValue = value;
+          next = child;
+        }
+      }
+    }
+
+    nodes[next].virtualLoss.fetch_add(PARALLEL_MCTS_VIRTUAL_LOSS,
+                                      std::memory_order_relaxed);
+    state.applyMove(nodes[next].move);
+    node = next;
+    worker.path.push_back(node);
+  }
+
+  double reward = rollout(state, root.toMove, worker);
+  for (int index : worker.path) {
+    TreeNode& visited = nodes[index];
+    double value = visited.player == root.toMove ? reward : 1.0 - reward;
+    visited.reward.fetch_add(static_cast<long long>(value * REWARD_SCALE),
+                             std::memory_order_relaxed);
+    visited.visits.fetch_add(1, std::memory_order_relaxed);
+    if (index != 0) {
+      visited.virtualLoss.fetch_sub(PARALLEL_MCTS_VIRTUAL_LOSS,
+                                    std::memory_order_relaxed);
+    }
+  }
+}
+
+double ParallelMcts::rollout(GameState& state, int rootPlayer,
+                             Worker& worker) {
+  while (!state.isTerminal()) {
+    Move move;
+    if (worker.random.below(10) < 2) {
+      state.generateMoves(worker.legal);
+      move = worker.legal[worker.random.below(
+          static_cast<unsigned int>(worker.legal.size()))];
+    } else {
+      move = MctsBot::greedyMove(state, worker.legal, worker.random);
+    }
+    state.applyMove(move);
+    worker.nodesVisited++;
+  }
+  return MctsBot::terminalReward(state, rootPlayer);
+}
+
+ScalingReport ParallelMcts::measureScaling(const GameState& state,
+                                           const MctsConfig& config,
+                                           int threads) {
+  MctsConfig timed = config;
+  if (timed.timeBudgetMs > 0) {
+    timed.iterations = 0;
+  }
+
+  ScalingReport report;
+  ParallelMcts single(timed, 1);
+  single.chooseMove(state);
+  report.singleThreadRate =
+      single.stats.iterations * 1000.0 / std::max(single.stats.elapsedMs, 1e-3);
+
+  ParallelMcts parallel(timed, threads);
+  report.threads = parallel.getThreads();
+  parallel.chooseMove(state);
+  report.multiThreadRate = parallel.stats.iterations * 1000.0 /
+                           std::max(parallel.stats.elapsedMs, 1e-3);
+  return report;
+}
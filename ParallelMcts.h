@@ -0,0 +1,89 @@
+#ifndef ASSIGN2_PARALLELMCTS_H
+#define ASSIGN2_PARALLELMCTS_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "GameState.h"
+#include "MctsBot.h"
+
+// Number of tree nodes preallocated per search
+#define PARALLEL_MCTS_NODE_CAPACITY (1 << 18)
+
+// Visits added to a node while a thread is still inside its subtree
+#define PARALLEL_MCTS_VIRTUAL_LOSS 3
+
+struct ScalingReport {
+  int threads;
+  double singleThreadRate;  // iterations per second with one thread
+  double multiThreadRate;   // iterations per second with 'threads' threads
+  double speedup() const;
+  double efficiency() const;
+};
+
+/*
+ * Tree-parallel ISMCTS. All threads share one tree whose nodes live in a
+ * preallocated pool; children are pushed onto sibling lists with a CAS
+ * and visit/score counters are atomics, so no locks are taken. Virtual
+ * loss steers concurrent threads into different branches. Helper
+ * threads are tasks on ThreadPool::shared().
+ */
+class ParallelMcts {
+ public:
+  ParallelMcts(const MctsConfig& config, int threads);
+
+  Move chooseMove(const GameState& state);
+
+  const SearchStats& getStats() const;
+
+  // Threads actually used, capped by the size of the shared pool
+  int getThreads() const;
+
+  // Run the same budget with one thread and with 'threads' threads
+  static ScalingReport measureScaling(const GameState& state,
+                                      const MctsConfig& config, int threads);
+
+ private:
+  struct TreeNode {
+    Move move;
+    int player;
+    int nextSibling;
+    std::atomic<int> firstChild;
+    std::atomic<int> visits;
+    std::atomic<int> virtualLoss;
+    std::atomic<int> availability;
+    // Sum of rewards in millionths, to keep the counter integral
+    std::atomic<long long> reward;
+  };
+
+  // Per-thread scratch space
+  struct Worker {
+    FastRandom random;
+    std::vector<Move> legal;
+    std::vector<Move> untried;
+    std::vector<int> compatible;
+    std::vector<int> path;
+    long nodesVisited;
+
+    explicit Worker(uint64_t seed);
+  };
+
+  MctsConfig config;
+  int threads;
+  SearchStats stats;
+  std::unique_ptr<TreeNode[]> nodes;
+  std::atomic<int> nodeCount;
+  std::atomic<long> iterationsStarted;
+  std::atomic<bool> stopFlag;
+
+  void resetTree(int rootPlayer);
+  void workerLoop(const GameState& root, Worker& worker);
+  void runIteration(const GameState& root, Worker& worker);
+  // Walk a sibling list from 'from' up to (not including) 'stopAt'
+  int findSibling(int from, int stopAt, const Move& move) const;
+  int addChild(int parent, const Move& move, int player);
+  double rollout(GameState& state, int rootPlayer, Worker& worker);
+};
+
+#endif  // ASSIGN2_PARALLELMCTS_H
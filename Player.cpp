@@ -108,11 +108,7 @@ void Player::drawQuantityTiles(TileBag* tileBag, int quantity) {
 
 // Remove a tile from the player's hand
 Tile* Player::removeTileFromHand(Tile* tile) {
-  Tile* removedTile = hand.remove(tile);
-  if (removedTile == nullptr) {
-    std::cout << "Error: Failed to remove tile from hand." << std::endl;
-  }
-  return removedTile;
+  return hand.remove(tile);
 }
 
 // Getter for player's hand
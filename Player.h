@@ -45,7 +45,7 @@ class Player {
   // Add quantity of tiles to player's hand
   void drawQuantityTiles(TileBag* tileBag, int quantity);
 
-  // Remove a tile from the player's hand
+  // Remove a tile from the player's hand; nullptr if it is not there
   Tile* removeTileFromHand(Tile* tile);
 
   // Get the player's hand
@@ -0,0 +1,397 @@
+#include "PositionBatch.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Masks of the two halves of a packed cell byte
+#define BATCH_COLOUR_MASK 0xF0
+#define BATCH_SHAPE_MASK 0x0F
+
+// Offsets of a line's planes from the first line plane of an axis
+#define BATCH_LINE_COLOURS 0
+#define BATCH_LINE_SHAPES 1
+#define BATCH_LINE_LENGTH 2
+
+namespace {
+// Row and column step of each arm: left, right, up, down. Arms 0 and 1
+// make the horizontal line, arms 2 and 3 the vertical one.
+const int kArms[4][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+
+#ifndef __SSE2__
+// Points for a line of 'tiles' tiles including the new one
+int lineScore(int tiles) {
+  int score = tiles > 1 ? tiles : 0;
+  if (tiles == NUM_SHAPES) {
+    score += NUM_SHAPES;
+  }
+  return score;
+}
+#endif
+}  // namespace
+
+PositionBatch::PositionBatch(int rows, int cols, size_t capacity)
+    : rows(rows),
+      cols(cols),
+      capacity((capacity + BATCH_LANES - 1) / BATCH_LANES * BATCH_LANES),
+      count(0) {
+  size_t cells = static_cast<size_t>(rows) * cols;
+  cellPlane.assign(cells * BATCH_CELL_PLANES * this->capacity, 0);
+  handPlane.assign(DEFAULT_HAND_SIZE * this->capacity, 0);
+  boardEmpty.assign(this->capacity, 0);
+  margins.assign(this->capacity, 0.0f);
+  featurePlane.assign(EVAL_FEATURES * this->capacity, 0.0f);
+}
+
+uint8_t PositionBatch::pack(TileCode tile) {
+  if (tile == EMPTY_CELL) {
+    return 0;
+  }
+  return static_cast<uint8_t>((GameState::colourIndex(tile) + 1) << 4 |
+                              (GameState::shapeIndex(tile) + 1));
+}
+
+bool PositionBatch::add(const GameState& state) {
+  if (state.getRows() != rows || state.getCols() != cols ||
+      count >= capacity) {
+    return false;
+  }
+  size_t position = count++;
+  for (int cell = 0; cell < rows * cols; ++cell) {
+    int row = cell / cols;
+    int col = cell % cols;
+    uint8_t* planes = &cellPlane[cellIndex(cell, position)];
+    TileCode tile = state.at(row, col);
+    planes[0] = pack(tile);
+    // Arms 0 and 1 fill the horizontal line planes, 2 and 3 the vertical
+    for (int arm = 0; arm < 4; ++arm) {
+      uint8_t* line = planes + (1 + arm / 2 * 3) * BATCH_LANES;
+      if (arm % 2 == 0) {
+        line[BATCH_LINE_COLOURS * BATCH_LANES] = 0;
+        line[BATCH_LINE_SHAPES * BATCH_LANES] = 0;
+        line[BATCH_LINE_LENGTH * BATCH_LANES] = 0;
+      }
+      int r = row + kArms[arm][0];
+      int c = col + kArms[arm][1];
+      for (int step = 0; tile == EMPTY_CELL && step < BATCH_ARM_LENGTH &&
+                         r >= 0 && r < rows && c >= 0 && c < cols &&
+                         state.at(r, c) != EMPTY_CELL;
+           ++step) {
+        line[BATCH_LINE_COLOURS * BATCH_LANES] |=
+            1 << GameState::colourIndex(state.at(r, c));
+        line[BATCH_LINE_SHAPES * BATCH_LANES] |=
+            1 << GameState::shapeIndex(state.at(r, c));
+        line[BATCH_LINE_LENGTH * BATCH_LANES]++;
+        r += kArms[arm][0];
+        c += kArms[arm][1];
+      }
+    }
+  }
+  const std::vector<TileCode>& hand = state.hands[state.toMove];
+  for (size_t slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+    handPlane[slot * capacity + position] =
+        slot < hand.size() ? pack(hand[slot]) : 0;
+  }
+  boardEmpty[position] = state.isBoardEmpty() ? 1 : 0;
+  margins[position] = static_cast<float>(state.scoreMargin(state.toMove));
+
+  float features[EVAL_FEATURES];
+  Evaluator::extractFeatures(state, features);
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    featurePlane[f * capacity + position] = features[f];
+  }
+  return true;
+}
+
+void PositionBatch::clear() { count = 0; }
+
+size_t PositionBatch::size() const { return count; }
+
+void PositionBatch::evaluate(const TileCode* tiles, const int16_t* rows,
+                             const int16_t* cols, BatchResults& results) {
+  // The kernel writes whole vectors, so the results briefly span every lane
+  results.legal.resize(capacity);
+  results.scores.resize(capacity);
+  placementKernel(tiles, rows, cols, results.legal.data(),
+                  results.scores.data());
+  results.legal.resize(count);
+  results.scores.resize(count);
+
+  results.evaluations.resize(count);
+  Evaluator::shared().evaluateBatch(featurePlane.data(), count, capacity,
+                                    results.evaluations.data());
+  for (size_t i = 0; i < count; ++i) {
+    results.evaluations[i] += margins[i];
+  }
+}
+
+size_t PositionBatch::cellIndex(int cell, size_t position) const {
+  size_t group = position / BATCH_LANES * BATCH_LANES;
+  return (group * rows * cols + cell * BATCH_LANES) * BATCH_CELL_PLANES +
+         position - group;
+}
+
+void PositionBatch::placementKernel(const TileCode* tiles,
+                                    const int16_t* rows, const int16_t* cols,
+                                    uint8_t* legal, uint8_t* scores) const {
+  uint8_t query[BATCH_LANES];
+  uint8_t open[BATCH_LANES];
+  // The query tile's colour and shape as single mask bits
+  uint8_t colourBit[BATCH_LANES];
+  uint8_t shapeBit[BATCH_LANES];
+  // The line planes of each lane's target cell, in plane order
+  uint8_t lines[BATCH_CELL_PLANES - 1][BATCH_LANES];
+  size_t blockSize =
+      static_cast<size_t>(this->rows) * this->cols * BATCH_CELL_PLANES;
+  // The same three bytes for every tile code, all 0 for code 0
+  uint8_t packedOf[NUM_TILE_KINDS + 1] = {0};
+  uint8_t colourBitOf[NUM_TILE_KINDS + 1] = {0};
+  uint8_t shapeBitOf[NUM_TILE_KINDS + 1] = {0};
+  for (TileCode code = 1; code <= NUM_TILE_KINDS; ++code) {
+    packedOf[code] = pack(code);
+    colourBitOf[code] = 1 << GameState::colourIndex(code);
+    shapeBitOf[code] = 1 << GameState::shapeIndex(code);
+  }
+
+  for (size_t group = 0; group < capacity; group += BATCH_LANES) {
+    const uint8_t* block = &cellPlane[group * blockSize];
+    for (int lane = 0; lane < BATCH_LANES; ++lane) {
+      size_t i = group + lane;
+      // Lanes past the last position take part but never pass
+      bool valid = i < count && tiles[i] >= 1 && tiles[i] <= NUM_TILE_KINDS;
+      bool onBoard = valid && rows[i] >= 0 && rows[i] < this->rows &&
+                     cols[i] >= 0 && cols[i] < this->cols;
+      const uint8_t* planes =
+          block + lane +
+          (onBoard ? (rows[i] * this->cols + cols[i]) * BATCH_CELL_PLANES *
+                         BATCH_LANES
+                   : 0);
+      TileCode code = valid ? tiles[i] : 0;
+      query[lane] = packedOf[code];
+      open[lane] = onBoard && planes[0] == 0 ? 1 : 0;
+      colourBit[lane] = colourBitOf[code];
+      shapeBit[lane] = shapeBitOf[code];
+      for (int plane = 1; plane < BATCH_CELL_PLANES; ++plane) {
+        lines[plane - 1][lane] = planes[plane * BATCH_LANES];
+      }
+    }
+    const uint8_t* hand = &handPlane[group];
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i full = _mm_set1_epi8(NUM_SHAPES);
+    __m128i tile = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query));
+    __m128i colour =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(colourBit));
+    __m128i shape = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shapeBit));
+
+    // All-ones bytes where the lane passes so far
+    __m128i pass = _mm_andnot_si128(
+        _mm_cmpeq_epi8(tile, zero),
+        _mm_cmpgt_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(open)), zero));
+    __m128i inHand = zero;
+    for (int slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+      __m128i held = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(hand + slot * capacity));
+      inHand = _mm_or_si128(inHand, _mm_cmpeq_epi8(held, tile));
+    }
+    pass = _mm_and_si128(pass, inHand);
+
+    __m128i neighbours = _mm_cmpgt_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&boardEmpty[group])),
+        zero);
+    __m128i score = zero;
+    for (int axis = 0; axis < 2; ++axis) {
+      __m128i colours = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+          lines[axis * 3 + BATCH_LINE_COLOURS]));
+      __m128i shapes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+          lines[axis * 3 + BATCH_LINE_SHAPES]));
+      __m128i length = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+          lines[axis * 3 + BATCH_LINE_LENGTH]));
+      // Every tile along the line shares the colour and none the shape,
+      // or the other way round
+      __m128i colourLine = _mm_and_si128(
+          _mm_cmpeq_epi8(colours, colour),
+          _mm_cmpeq_epi8(_mm_and_si128(shapes, shape), zero));
+      __m128i shapeLine = _mm_and_si128(
+          _mm_cmpeq_epi8(shapes, shape),
+          _mm_cmpeq_epi8(_mm_and_si128(colours, colour), zero));
+      __m128i ok = _mm_or_si128(_mm_cmpeq_epi8(length, zero),
+                                _mm_or_si128(colourLine, shapeLine));
+      pass = _mm_and_si128(pass, ok);
+      neighbours = _mm_or_si128(neighbours, _mm_cmpgt_epi8(length, zero));
+
+      __m128i lineTiles = _mm_add_epi8(length, one);
+      score = _mm_add_epi8(
+          score, _mm_and_si128(_mm_cmpgt_epi8(lineTiles, one), lineTiles));
+      score = _mm_add_epi8(
+          score, _mm_and_si128(_mm_cmpeq_epi8(lineTiles, full), full));
+    }
+    pass = _mm_and_si128(pass, neighbours);
+    // A placement with no line at all still scores a point
+    score =
+        _mm_or_si128(score, _mm_and_si128(_mm_cmpeq_epi8(score, zero), one));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&legal[group]),
+                     _mm_and_si128(pass, one));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&scores[group]),
+                     _mm_and_si128(pass, score));
+#else
+    for (int lane = 0; lane < BATCH_LANES; ++lane) {
+      uint8_t tile = query[lane];
+      bool pass = open[lane] != 0 && tile != 0;
+      bool inHand = false;
+      for (int slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+        inHand = inHand || hand[slot * capacity + lane] == tile;
+      }
+      pass = pass && inHand;
+
+      bool neighbours = boardEmpty[group + lane] != 0;
+      int score = 0;
+      for (int axis = 0; axis < 2; ++axis) {
+        uint8_t colours = lines[axis * 3 + BATCH_LINE_COLOURS][lane];
+        uint8_t shapes = lines[axis * 3 + BATCH_LINE_SHAPES][lane];
+        int length = lines[axis * 3 + BATCH_LINE_LENGTH][lane];
+        bool colourLine =
+            colours == colourBit[lane] && (shapes & shapeBit[lane]) == 0;
+        bool shapeLine =
+            shapes == shapeBit[lane] && (colours & colourBit[lane]) == 0;
+        pass = pass && (length == 0 || colourLine || shapeLine);
+        neighbours = neighbours || length > 0;
+        score += lineScore(length + 1);
+      }
+      pass = pass && neighbours;
+      legal[group + lane] = pass ? 1 : 0;
+      scores[group + lane] =
+          pass ? static_cast<uint8_t>(std::max(score, 1)) : 0;
+    }
+#endif
+  }
+}
+
+void PositionBatch::placementLanes(const uint8_t* const* window,
+                                   const uint8_t* query, const uint8_t* open,
+                                   const uint8_t* hand, size_t handStride,
+                                   const uint8_t* boardEmpty, uint8_t* legal,
+                                   uint8_t* scores) {
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i full = _mm_set1_epi8(NUM_SHAPES);
+  const __m128i colourMask = _mm_set1_epi8(BATCH_COLOUR_MASK);
+  const __m128i shapeMask = _mm_set1_epi8(BATCH_SHAPE_MASK);
+  __m128i tile = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query));
+
+  // All-ones bytes where the lane passes so far
+  __m128i pass = _mm_andnot_si128(
+      _mm_cmpeq_epi8(tile, zero),
+      _mm_cmpgt_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(open)),
+                     zero));
+  __m128i inHand = zero;
+  for (int slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+    __m128i held = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(hand + slot * handStride));
+    inHand = _mm_or_si128(inHand, _mm_cmpeq_epi8(held, tile));
+  }
+  pass = _mm_and_si128(pass, inHand);
+
+  __m128i neighbours = _mm_cmpgt_epi8(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(boardEmpty)), zero);
+  __m128i score = zero;
+  for (int line = 0; line < 2; ++line) {
+    __m128i length = zero;
+    // Tiles matching neither or both of colour and shape, and tiles
+    // matching by colour only or by shape only
+    __m128i bad = zero;
+    __m128i colourKind = zero;
+    __m128i shapeKind = zero;
+    for (int arm = 2 * line; arm < 2 * line + 2; ++arm) {
+      __m128i active = _mm_cmpeq_epi8(zero, zero);
+      for (int step = 0; step < BATCH_ARM_LENGTH; ++step) {
+        __m128i cell = _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+            window[arm * BATCH_ARM_LENGTH + step]));
+        active = _mm_andnot_si128(_mm_cmpeq_epi8(cell, zero), active);
+        __m128i differ = _mm_xor_si128(cell, tile);
+        __m128i colourMatch =
+            _mm_cmpeq_epi8(_mm_and_si128(differ, colourMask), zero);
+        __m128i shapeMatch =
+            _mm_cmpeq_epi8(_mm_and_si128(differ, shapeMask), zero);
+        bad = _mm_or_si128(
+            bad,
+            _mm_and_si128(active, _mm_cmpeq_epi8(colourMatch, shapeMatch)));
+        colourKind = _mm_or_si128(
+            colourKind,
+            _mm_and_si128(active, _mm_andnot_si128(shapeMatch, colourMatch)));
+        shapeKind = _mm_or_si128(
+            shapeKind,
+            _mm_and_si128(active, _mm_andnot_si128(colourMatch, shapeMatch)));
+        // active is -1 per live lane, so subtracting counts the tile
+        length = _mm_sub_epi8(length, active);
+        if (_mm_movemask_epi8(active) == 0) {
+          break;
+        }
+      }
+    }
+    __m128i reject = _mm_or_si128(bad, _mm_and_si128(colourKind, shapeKind));
+    pass = _mm_andnot_si128(reject, pass);
+    neighbours = _mm_or_si128(neighbours, _mm_cmpgt_epi8(length, zero));
+
+    __m128i tiles = _mm_add_epi8(length, one);
+    score = _mm_add_epi8(score,
+                         _mm_and_si128(_mm_cmpgt_epi8(tiles, one), tiles));
+    score = _mm_add_epi8(score,
+                         _mm_and_si128(_mm_cmpeq_epi8(tiles, full), full));
+  }
+  pass = _mm_and_si128(pass, neighbours);
+  // A placement with no line at all still scores a point
+  score =
+      _mm_or_si128(score, _mm_and_si128(_mm_cmpeq_epi8(score, zero), one));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(legal),
+                   _mm_and_si128(pass, one));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(scores),
+                   _mm_and_si128(pass, score));
+#else
+  for (int lane = 0; lane < BATCH_LANES; ++lane) {
+    uint8_t tile = query[lane];
+    bool pass = open[lane] != 0 && tile != 0;
+    bool inHand = false;
+    for (int slot = 0; slot < DEFAULT_HAND_SIZE; ++slot) {
+      inHand = inHand || hand[slot * handStride + lane] == tile;
+    }
+    pass = pass && inHand;
+
+    bool neighbours = boardEmpty[lane] != 0;
+    int score = 0;
+    for (int line = 0; line < 2; ++line) {
+      int length = 0;
+      bool bad = false;
+      bool colourKind = false;
+      bool shapeKind = false;
+      for (int arm = 2 * line; arm < 2 * line + 2; ++arm) {
+        for (int step = 0; step < BATCH_ARM_LENGTH; ++step) {
+          uint8_t cell = window[arm * BATCH_ARM_LENGTH + step][lane];
+          if (cell == 0) {
+            break;
+          }
+          uint8_t differ = cell ^ tile;
+          bool colourMatch = (differ & BATCH_COLOUR_MASK) == 0;
+          bool shapeMatch = (differ & BATCH_SHAPE_MASK) == 0;
+          bad = bad || colourMatch == shapeMatch;
+          colourKind = colourKind || (colourMatch && !shapeMatch);
+          shapeKind = shapeKind || (shapeMatch && !colourMatch);
+          length++;
+        }
+      }
+      pass = pass && !bad && !(colourKind && shapeKind);
+      neighbours = neighbours || length > 0;
+      score += lineScore(length + 1);
+    }
+    pass = pass && neighbours;
+    legal[lane] = pass ? 1 : 0;
+    scores[lane] = pass ? static_cast<uint8_t>(std::max(score, 1)) : 0;
+  }
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef ASSIGN2_POSITIONBATCH_H
+#define ASSIGN2_POSITIONBATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Evaluator.h"
+#include "GameState.h"
+
+// Positions handled per vector step; capacity is rounded up to this
+#define BATCH_LANES 16
+
+// Cells read along each of the four arms around a placement. Every tile
+// in a line shares one colour or one shape, so a line holds at most
+// NUM_SHAPES * QUANTITY_OF_EACH_TILE tiles; Rules does not stop lines at
+// six, so the other tiles along one arm can number one less than that.
+#define BATCH_ARM_LENGTH (NUM_SHAPES * QUANTITY_OF_EACH_TILE - 1)
+#define BATCH_WINDOW (4 * BATCH_ARM_LENGTH)
+
+// Bytes kept per cell of each position: the packed cell, then for the
+// horizontal and the vertical line through the cell the colours and the
+// shapes of the tiles along it as bit masks, and how many there are
+#define BATCH_CELL_PLANES 7
+
+struct BatchResults {
+  // 1 if the placement is legal for the player to move
+  std::vector<uint8_t> legal;
+  // Points the placement scores, 0 if it is not legal
+  std::vector<uint8_t> scores;
+  // Evaluator::evaluate of each position as it was added
+  std::vector<float> evaluations;
+};
+
+/*
+ * Many positions of one board size packed structure-of-arrays style, with
+ * one cell plane, hand slot or evaluation feature of consecutive positions
+ * stored contiguously. Board cells are blocked by lane group: each run of
+ * BATCH_LANES positions keeps its own [cell][plane][lane] block, so the
+ * planes of one cell sit together. A cell byte holds the colour in its
+ * high nibble and the shape in its low nibble, both counted from 1, so a
+ * zero byte is an empty cell and one load answers occupancy, colour and
+ * shape.
+ *
+ * add() also fills the line planes of every empty cell from the tiles
+ * along its four arms, up to BATCH_ARM_LENGTH each. evaluate() then
+ * answers one placement per position with a fixed number of loads per
+ * position, whatever the line lengths, and checks legality and scores
+ * BATCH_LANES positions at a time on those masks with SSE2 byte lanes,
+ * or a scalar loop without SSE2. Evaluations use Evaluator::evaluateBatch
+ * on the feature planes.
+ */
+class PositionBatch {
+ public:
+  PositionBatch(int rows, int cols, size_t capacity);
+
+  // Pack a position; false if the board size differs or the batch is full
+  bool add(const GameState& state);
+  void clear();
+  size_t size() const;
+
+  // Legality, score and evaluation for placing tiles[i] at rows[i],
+  // cols[i] in position i, for every position in the batch
+  void evaluate(const TileCode* tiles, const int16_t* rows,
+                const int16_t* cols, BatchResults& results);
+
+  // Cell byte of a tile, 0 for EMPTY_CELL
+  static uint8_t pack(TileCode tile);
+
+  // The legality and scoring kernel for BATCH_LANES lanes. window[w]
+  // points at the lanes' bytes for window cell arm * BATCH_ARM_LENGTH +
+  // step, read up to the first empty cell of each arm. A lane passes only
+  // if open is nonzero, its query is nonzero and held in one of the
+  // DEFAULT_HAND_SIZE hand slots (handStride bytes apart), and it has a
+  // neighbour or boardEmpty is nonzero.
+  static void placementLanes(const uint8_t* const* window,
+                             const uint8_t* query, const uint8_t* open,
+                             const uint8_t* hand, size_t handStride,
+                             const uint8_t* boardEmpty, uint8_t* legal,
+                             uint8_t* scores);
+
+ private:
+  int rows;
+  int cols;
+  size_t capacity;
+  size_t count;
+
+  // Packed cell bytes, indexed by cellIndex()
+  std::vector<uint8_t> cellPlane;
+  // [slot * capacity + position], packed tiles with 0 for unused slots
+  std::vector<uint8_t> handPlane;
+  std::vector<uint8_t> boardEmpty;
+  std::vector<float> margins;
+  // [feature * capacity + position]
+  std::vector<float> featurePlane;
+
+  // Index in cellPlane of a cell of a position: the block of its lane
+  // group, then [(cell * BATCH_CELL_PLANES + plane) * BATCH_LANES + lane]
+  // for plane 0
+  size_t cellIndex(int cell, size_t position) const;
+  void placementKernel(const TileCode* tiles, const int16_t* rows,
+                       const int16_t* cols, uint8_t* legal,
+                       uint8_t* scores) const;
+};
+
+#endif  // ASSIGN2_POSITIONBATCH_H
@@ -1,5 +1,6 @@
 #include "Rules.h"
 
+#include <algorithm>
 #include <set>
 
 bool Rules::validateMove(GameBoard* board, Tile* tile, int x, int y) {
@@ -9,55 +10,81 @@ bool Rules::validateMove(GameBoard* board, Tile* tile, int x, int y) {
 bool Rules::validateMoveEnhanced(
     GameBoard* board, const std::vector<Tile*>& tiles,
     const std::vector<std::pair<int, int>>& positions) {
-  if (tiles.size() != positions.size()) {
+  if (tiles.empty() || tiles.size() != positions.size()) {
     return false;  // Number of tiles must match number of positions
   }
-  for (size_t i = 0; i < tiles.size(); ++i) {
-    if (!isValidPlacement(board, tiles[i], positions[i].first,
-                          positions[i].second)) {
-      return false;  // Check each tile's placement validity
-    }
+  // All tiles share one row or one column
+  bool sameRow = true;
+  bool sameCol = true;
+  for (const std::pair<int, int>& position : positions) {
+    sameRow = sameRow && position.first == positions[0].first;
+    sameCol = sameCol && position.second == positions[0].second;
+  }
+  if (!sameRow && !sameCol) {
+    return false;
   }
-  return true;  // All tiles are validly placed
-}
 
-int Rules::calculateScore(GameBoard* board, int x, int y) {
-  int rowTiles = 1;
-  int colTiles = 1;
+  // Each tile must be valid once the ones before it are down, so they go
+  // onto the board in turn and come off again at the end
+  size_t placed = 0;
+  while (placed < tiles.size() &&
+         isValidPlacement(board, tiles[placed], positions[placed].first,
+                          positions[placed].second)) {
+    board->placeTile(positions[placed].first, positions[placed].second,
+                     tiles[placed]);
+    placed++;
+  }
+  bool valid = placed == tiles.size();
 
-  // Check horizontal (row) tiles
-  for (int i = x - 1; i >= 0 && board->getTile(i, y) != nullptr; --i) {
-    rowTiles++;
+  // With every tile down, the line between the outermost two has no gaps
+  int first = sameRow ? positions[0].second : positions[0].first;
+  int last = first;
+  for (const std::pair<int, int>& position : positions) {
+    int along = sameRow ? position.second : position.first;
+    first = std::min(first, along);
+    last = std::max(last, along);
   }
-  for (int i = x + 1; i < board->getRows() && board->getTile(i, y) != nullptr;
-       ++i) {
-    rowTiles++;
+  for (int along = first; valid && along <= last; ++along) {
+    valid = sameRow ? board->getTile(positions[0].first, along) != nullptr
+                    : board->getTile(along, positions[0].second) != nullptr;
   }
 
-  // Check vertical (column) tiles
-  for (int j = y - 1; j >= 0 && board->getTile(x, j) != nullptr; --j) {
-    colTiles++;
-  }
-  for (int j = y + 1; j < board->getCols() && board->getTile(x, j) != nullptr;
-       ++j) {
-    colTiles++;
+  for (size_t i = 0; i < placed; ++i) {
+    board->placeTile(positions[i].first, positions[i].second, nullptr);
   }
+  return valid;
+}
+
+int Rules::calculateScore(GameBoard* board, int x, int y) {
+  int qwirkles = 0;
+  return calculateMoveScore(board, {{x, y}}, qwirkles);
+}
 
-  // Calculate the score
+int Rules::calculateMoveScore(GameBoard* board,
+                              const std::vector<std::pair<int, int>>& positions,
+                              int& qwirkles) {
+  // The line the tiles share runs along x when they share a column, and
+  // along y otherwise (including for a single tile)
+  bool alongX = positions.size() > 1 &&
+                positions[0].second == positions[1].second;
   int score = 0;
-  if (rowTiles > 1) {
-    score += rowTiles;
-  }
-  if (colTiles > 1) {
-    score += colTiles;
-  }
+  qwirkles = 0;
+  auto scoreLine = [&](int x, int y, bool lineAlongX) {
+    int tiles = lineLength(board, x, y, lineAlongX);
+    if (tiles > 1) {
+      score += tiles;
+    }
+    // Check for QWIRKLEs and add bonus points if applicable
+    if (tiles == 6) {
+      score += 6;
+      qwirkles++;
+    }
+  };
 
-  // Check for QWIRKLEs and add bonus points if applicable
-  if (rowTiles == 6) {
-    score += 6;
-  }
-  if (colTiles == 6) {
-    score += 6;
+  // The shared line once, then the cross line through each tile
+  scoreLine(positions[0].first, positions[0].second, alongX);
+  for (const std::pair<int, int>& position : positions) {
+    scoreLine(position.first, position.second, !alongX);
   }
 
   // If this is the first move, add one point
@@ -68,6 +95,21 @@ int Rules::calculateScore(GameBoard* board, int x, int y) {
   return score;
 }
 
+int Rules::lineLength(GameBoard* board, int x, int y, bool alongX) {
+  int dx = alongX ? 1 : 0;
+  int dy = alongX ? 0 : 1;
+  int tiles = 1;
+  for (int i = x - dx, j = y - dy; board->getTile(i, j) != nullptr;
+       i -= dx, j -= dy) {
+    tiles++;
+  }
+  for (int i = x + dx, j = y + dy; board->getTile(i, j) != nullptr;
+       i += dx, j += dy) {
+    tiles++;
+  }
+  return tiles;
+}
+
 bool Rules::isGameOver(Player* player1, Player* player2, TileBag* tileBag) {
   return (player1->getHand()->getHead() == nullptr &&
           player2->getHand()->getHead() == nullptr) &&
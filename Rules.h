@@ -1,6 +1,9 @@
 #ifndef ASSIGN2_RULES_H
 #define ASSIGN2_RULES_H
 
+#include <utility>
+#include <vector>
+
 #include "GameBoard.h"
 #include "Player.h"
 #include "TileBag.h"
@@ -10,7 +13,9 @@ class Rules {
   // Validate a move
   static bool validateMove(GameBoard* board, Tile* tile, int x, int y);
 
-  // Validate multiple moves
+  // Validate several tiles placed as one move: they share a row or a
+  // column, leave no gap along it, and each is valid once the ones before
+  // it are down. The board is left as it was.
   static bool validateMoveEnhanced(
       GameBoard* board, const std::vector<Tile*>& tiles,
       const std::vector<std::pair<int, int>>& positions);
@@ -18,6 +23,13 @@ class Rules {
   // Calculate the score of a move
   static int calculateScore(GameBoard* board, int x, int y);
 
+  // Score of tiles already placed as one move: the line they share once,
+  // plus the line across each tile, counting only lines of two or more.
+  // 'qwirkles' is the number of those lines that hold six tiles.
+  static int calculateMoveScore(
+      GameBoard* board, const std::vector<std::pair<int, int>>& positions,
+      int& qwirkles);
+
   // Check if the game is over
   static bool isGameOver(Player* player1, Player* player2, TileBag* tileBag);
 
@@ -25,6 +37,9 @@ class Rules {
   // Helper functions for move validation and scoring
   static bool isValidPlacement(GameBoard* board, Tile* tile, int x, int y);
 
+  // Tiles in the line through x, y, counting the tile there
+  static int lineLength(GameBoard* board, int x, int y, bool alongX);
+
   // Check if tile placement is valid in rows
   static bool isRowInvalid(GameBoard* board, Tile* tile, int x, int y);
 };
@@ -1,10 +1,38 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <sstream>
 
+#include "BackgroundSaver.h"
+#include "BulkLoader.h"
+#include "Bot.h"
+#include "CanonicalForm.h"
+#include "CommandParser.h"
+#include "EndgameSolver.h"
+#include "Evaluator.h"
 #include "FileHandler.h"
+#include "GameArchive.h"
+#include "GameEngine.h"
+#include "GameLog.h"
+#include "GameState.h"
+#include "HandTable.h"
+#include "HintSearch.h"
+#include "InputValidator.h"
+#include "LockstepSimulator.h"
+#include "MctsBot.h"
+#include "OpeningBook.h"
+#include "PositionBatch.h"
+#include "Rules.h"
 #include "TileBag.h"
 #include "TileCodes.h"
+#include "ThreadPool.h"
+#include "Trainer.h"
+#include "TranspositionTable.h"
 
 class Tests {
  public:
@@ -15,6 +43,30 @@ class Tests {
     tileBagShuffleTest();
     readFileContentTest();
     saveGameTest();
+    gameStateMatchesRulesTest();
+    hintDeadlineTest();
+    endgameSolverTest();
+    transpositionTableTest();
+    canonicalFormTest();
+    openingBookTest();
+    handTableTest();
+    evaluatorTest();
+    positionBatchTest();
+    lockstepTest();
+    gameEngineTest();
+    binarySaveTest();
+    binaryDuplicateCellTest();
+    textSaveErrorTest();
+    saveFormatValidatorTest();
+    commandParserTest();
+    placeAllTest();
+    boardViewTest();
+    gameLogTest();
+    backgroundSaverTest();
+    gameArchiveTest();
+    corruptArchiveTest();
+    engineArchiveTest();
+    bulkLoaderTest();
     // enhancedBoardTest();
     // handleEnhancedPlayerTurnTest();
   }
@@ -111,6 +163,1085 @@ class Tests {
     assert_equality(savedGame, fileContent);
   }
 
+  static void gameStateMatchesRulesTest() {
+    std::cout << "#gameStateMatchesRulesTest" << std::endl;
+    // given
+    GameBoard board(6, 6);
+    board.placeTile(2, 0, new Tile(BLUE, CIRCLE));
+    board.placeTile(2, 1, new Tile(BLUE, STAR_4));
+    board.placeTile(2, 2, new Tile(BLUE, DIAMOND));
+    board.placeTile(3, 2, new Tile(RED, DIAMOND));
+    Player player1("ALICE");
+    Player player2("BOB");
+    std::vector<Tile*> noTiles;
+    TileBag tileBag(noTiles);
+    GameState state =
+        GameState::fromGame(&board, &player1, &player2, &tileBag);
+
+    // when
+    std::string mismatches;
+    for (Colour colour : {RED, BLUE, GREEN}) {
+      for (Shape shape : {CIRCLE, DIAMOND, SQUARE}) {
+        Tile tile(colour, shape);
+        TileCode code = GameState::encodeTile(colour, shape);
+        for (int row = 0; row < 6; ++row) {
+          for (int col = 0; col < 6; ++col) {
+            bool expected = Rules::validateMove(&board, &tile, row, col);
+            if (expected != state.isValidPlacement(code, row, col)) {
+              mismatches += tile.print() + "@" + std::to_string(row) + "," +
+                            std::to_string(col) + " ";
+            } else if (expected && board.getTile(row, col) == nullptr) {
+              board.placeTile(row, col, &tile);
+              int rulesScore = Rules::calculateScore(&board, row, col);
+              board.placeTile(row, col, nullptr);
+              if (rulesScore != state.scorePlacement(row, col)) {
+                mismatches += "score:" + tile.print() + " ";
+              }
+            }
+          }
+        }
+      }
+    }
+
+    // then
+    assert_equality("", mismatches);
+  }
+
+  static void hintDeadlineTest() {
+    std::cout << "#hintDeadlineTest" << std::endl;
+    // given a crowded board from a greedy self-play game
+    GameState state = GameState::newGame(7);
+    FastRandom random(7);
+    std::vector<Move> scratch;
+    for (int turn = 0; turn < 50 && !state.isTerminal(); ++turn) {
+      state.applyMove(MctsBot::greedyMove(state, scratch, random));
+    }
+    int deadlineMs = 30;
+
+    // when
+    HintSearch search(deadlineMs, 7);
+    HintResult hint = search.search(state);
+
+    // then the move is legal, the deadline stopped the search, and the
+    // answer came back within budget, with room for a loaded machine
+    std::vector<Move> legal;
+    state.generateMoves(legal);
+    bool isLegal = false;
+    for (const Move& move : legal) {
+      isLegal = isLegal || move == hint.move;
+    }
+    std::cout << "Hint " << hint.move.toCommand() << " at depth "
+              << hint.depth << " in " << hint.elapsedMs << " ms"
+              << std::endl;
+    std::ostringstream outcome;
+    outcome << isLegal << hint.timedOut
+            << (hint.elapsedMs < 2 * deadlineMs + 20);
+    assert_equality("111", outcome.str());
+  }
+
+  static void endgameSolverTest() {
+    std::cout << "#endgameSolverTest" << std::endl;
+    // given small endgames: greedy self-play until the bag runs out, with
+    // the hands cut down so a plain minimax can check the answer
+    std::string mismatches;
+    for (int seed = 1; seed <= 3; ++seed) {
+      GameState state = GameState::newGame(seed);
+      FastRandom random(seed);
+      std::vector<Move> scratch;
+      while (state.bagSize() > 0 && !state.isTerminal()) {
+        state.applyMove(MctsBot::greedyMove(state, scratch, random));
+      }
+      for (int player = 0; player < 2; ++player) {
+        if (state.hands[player].size() > 2) {
+          state.hands[player].resize(2);
+        }
+      }
+
+      // when
+      EndgameConfig config;
+      EndgameSolver solver(config);
+      EndgameResult result = solver.solve(state);
+
+      // then
+      int expected = state.scoreMargin(state.toMove) +
+                     minimaxEndgame(state, config.finishingBonus);
+      int lineMargin = result.finalScores[state.toMove] -
+                       result.finalScores[1 - state.toMove];
+      if (!result.solved || !result.lineComplete ||
+          result.margin != expected || lineMargin != expected) {
+        mismatches += "seed " + std::to_string(seed) + " ";
+      }
+    }
+    assert_equality("", mismatches);
+  }
+
+  static void transpositionTableTest() {
+    std::cout << "#transpositionTableTest" << std::endl;
+    // given a small table hammered by every pool worker at once, with
+    // values derived from the keys so a torn entry would show up
+    TranspositionTable table(1);
+    ThreadPool& pool = ThreadPool::shared();
+    TaskGroup group;
+    std::atomic<int> corrupt(0);
+    for (int worker = 0; worker < 4; ++worker) {
+      pool.submit(group, [&table, &corrupt, worker]() {
+        FastRandom random(worker + 1);
+        for (int i = 0; i < 200000; ++i) {
+          uint64_t key = random.next() % 100000 + 1;
+          int value = static_cast<int>(key % 30000);
+          TableEntry entry;
+          if (table.probe(key, entry)) {
+            if (entry.value != value || entry.best.tile != key % 36 + 1) {
+              corrupt++;
+            }
+          } else {
+            Move best = {MOVE_PLACE, static_cast<TileCode>(key % 36 + 1),
+                         static_cast<int16_t>(key % 26),
+                         static_cast<int16_t>(key % 25)};
+            table.store(key, {value, static_cast<int>(key % 20),
+                              BOUND_EXACT, best});
+          }
+        }
+      });
+    }
+    pool.wait(group);
+
+    // when a shallower result for a known position arrives
+    table.store(7, {70, 9, BOUND_EXACT, {MOVE_PASS, EMPTY_CELL, 0, 0}});
+    table.store(7, {71, 3, BOUND_LOWER, {MOVE_PASS, EMPTY_CELL, 0, 0}});
+    TableEntry kept;
+    bool found = table.probe(7, kept);
+
+    // then
+    TableStats stats = table.getStats();
+    std::cout << "Hit rate " << stats.hitRate() * 100 << "%, "
+              << stats.collisions << " collisions" << std::endl;
+    assert_equality("0 corrupt, deeper kept",
+                    std::to_string(corrupt.load()) + " corrupt, " +
+                        (found && kept.value == 70 ? "deeper kept"
+                                                   : "deeper lost"));
+  }
+
+  static void canonicalFormTest() {
+    std::cout << "#canonicalFormTest" << std::endl;
+    // given a mid-game position and a copy that is turned a quarter,
+    // moved across the board and has its colours and shapes renamed
+    GameState original = GameState::newGame(3);
+    FastRandom random(3);
+    std::vector<Move> scratch;
+    for (int turn = 0; turn < 8; ++turn) {
+      original.applyMove(MctsBot::greedyMove(original, scratch, random));
+    }
+    auto rename = [](TileCode tile) {
+      int colour = (GameState::colourIndex(tile) + 2) % NUM_COLOURS;
+      int shape = NUM_SHAPES - 1 - GameState::shapeIndex(tile);
+      return static_cast<TileCode>(1 + colour * NUM_SHAPES + shape);
+    };
+    GameState copy(original.getRows(), original.getCols());
+    for (int row = 0; row < original.getRows(); ++row) {
+      for (int col = 0; col < original.getCols(); ++col) {
+        TileCode tile = original.at(row, col);
+        if (tile != EMPTY_CELL) {
+          // (row, col) -> (col, 20 - row), then shifted two rows up
+          copy.applyMove({MOVE_PLACE, rename(tile),
+                          static_cast<int16_t>(col - 2),
+                          static_cast<int16_t>(20 - row)});
+        }
+      }
+    }
+    copy.toMove = original.toMove;
+    for (int player = 0; player < 2; ++player) {
+      copy.hands[player].clear();
+      for (TileCode tile : original.hands[player]) {
+        copy.hands[player].push_back(rename(tile));
+      }
+    }
+    for (size_t i = original.bagHead; i < original.bag.size(); ++i) {
+      copy.bag.push_back(rename(original.bag[i]));
+    }
+
+    // when
+    CanonicalForm first = CanonicalForm::of(original);
+    CanonicalForm second = CanonicalForm::of(copy);
+
+    // then every move maps to an equally legal, equally scoring move
+    std::string mismatches;
+    if (first != second || first.getKey() != second.getKey()) {
+      mismatches += "forms differ ";
+    }
+    std::vector<Move> moves;
+    original.generatePlacements(moves);
+    for (const Move& move : moves) {
+      Move mapped = second.fromCanonical(first.toCanonical(move));
+      if (first.fromCanonical(first.toCanonical(move)) != move ||
+          !copy.isValidPlacement(mapped.tile, mapped.row, mapped.col) ||
+          copy.scorePlacement(mapped.row, mapped.col) !=
+              original.scorePlacement(move.row, move.col)) {
+        mismatches += move.toCommand() + " ";
+      }
+    }
+    std::cout << moves.size() << " moves mapped" << std::endl;
+    assert_equality("", mismatches);
+  }
+
+  static void openingBookTest() {
+    std::cout << "#openingBookTest" << std::endl;
+    // given a small book built from the first two moves of three games
+    BookConfig config;
+    config.games = 3;
+    config.plies = 2;
+    config.iterations = 50;
+    config.seed = 11;
+    std::string path = "tests/stubs/opening-book-test-stub.book";
+    BookBuildStats stats;
+    OpeningBook::build(config, path, stats);
+
+    // and the first deal again, plus a copy with colours and shapes renamed
+    GameState first = GameState::newGame(config.seed);
+    auto rename = [](TileCode tile) {
+      int colour = (GameState::colourIndex(tile) + 1) % NUM_COLOURS;
+      int shape = NUM_SHAPES - 1 - GameState::shapeIndex(tile);
+      return static_cast<TileCode>(1 + colour * NUM_SHAPES + shape);
+    };
+    GameState renamed = first;
+    for (TileCode& tile : renamed.hands[renamed.toMove]) {
+      tile = rename(tile);
+    }
+
+    // when
+    OpeningBook book;
+    bool opened = book.open(path);
+    Move move;
+    Move renamedMove;
+    bool found = book.lookup(first, move);
+    bool renamedFound = book.lookup(renamed, renamedMove);
+    GameState reply = first;
+    reply.applyMove(move);
+    Move replyMove;
+    bool replyFound = book.lookup(reply, replyMove);
+    book.close();
+    std::remove(path.c_str());
+
+    // then both deals get the same move, and the reply is in the book too
+    std::cout << book.size() << " of " << stats.positions
+              << " positions after close, first move " << move.toCommand()
+              << std::endl;
+    bool sameMove = move.type == renamedMove.type &&
+                    rename(move.tile) == renamedMove.tile;
+    assert_equality("opened, found, renamed found, reply found",
+                    std::string(opened ? "opened" : "not opened") +
+                        (found ? ", found" : ", missing") +
+                        (renamedFound && sameMove ? ", renamed found"
+                                                  : ", renamed missing") +
+                        (replyFound ? ", reply found" : ", reply missing"));
+  }
+
+  static void handTableTest() {
+    std::cout << "#handTableTest" << std::endl;
+    // given the table of every full hand
+    std::string path = "tests/stubs/hand-table-test-stub.tbl";
+    int hands = 0;
+    HandTable::build(path, hands);
+    HandTable table;
+    bool opened = table.open(path);
+    auto rename = [](TileCode tile) {
+      int colour = NUM_COLOURS - 1 - GameState::colourIndex(tile);
+      int shape = (GameState::shapeIndex(tile) + 4) % NUM_SHAPES;
+      return static_cast<TileCode>(1 + colour * NUM_SHAPES + shape);
+    };
+
+    // when the opening hands of many deals, and renamed copies, are
+    // looked up
+    int missing = 0;
+    int wrong = 0;
+    for (uint64_t seed = 1; seed <= 300; ++seed) {
+      std::vector<TileCode> hand = GameState::newGame(seed).hands[0];
+      std::vector<TileCode> renamed;
+      for (TileCode tile : hand) {
+        renamed.push_back(rename(tile));
+      }
+      HandAdvice advice;
+      HandAdvice renamedAdvice;
+      if (!table.lookup(hand, advice) ||
+          !table.lookup(renamed, renamedAdvice)) {
+        missing++;
+        continue;
+      }
+      if (std::find(hand.begin(), hand.end(), advice.discard) == hand.end() ||
+          std::find(renamed.begin(), renamed.end(), renamedAdvice.discard) ==
+              renamed.end() ||
+          advice.keepValue != renamedAdvice.keepValue ||
+          advice.swapValue != renamedAdvice.swapValue) {
+        wrong++;
+      }
+    }
+    table.close();
+    std::remove(path.c_str());
+
+    // then every hand is found with advice that survives the renaming
+    std::cout << hands << " hand classes" << std::endl;
+    assert_equality("opened, 0 missing, 0 wrong",
+                    std::string(opened ? "opened" : "not opened") + ", " +
+                        std::to_string(missing) + " missing, " +
+                        std::to_string(wrong) + " wrong");
+  }
+
+  static void evaluatorTest() {
+    std::cout << "#evaluatorTest" << std::endl;
+    // given a short self-play log and the positions of its first game
+    std::string path = "tests/stubs/selfplay-test-stub.log";
+    std::remove(path.c_str());
+    Trainer::writeSelfPlay(path, "greedy", 20, 5);
+    std::vector<GameState> positions;
+    GameState state = GameState::newGame(5);
+    FastRandom random(5);
+    std::vector<Move> scratch;
+    for (int turn = 0; turn < 7; ++turn) {
+      state.applyMove(MctsBot::greedyMove(state, scratch, random));
+      positions.push_back(state);
+    }
+
+    // when the positions are evaluated one by one and as a batch, and
+    // the weights are trained on the log
+    Evaluator evaluator;
+    size_t count = positions.size();
+    std::vector<float> batch(EVAL_FEATURES * count);
+    std::vector<float> single(count);
+    for (size_t i = 0; i < count; ++i) {
+      alignas(16) float features[EVAL_FEATURES];
+      Evaluator::extractFeatures(positions[i], features);
+      single[i] = evaluator.predict(features);
+      for (int f = 0; f < EVAL_FEATURES; ++f) {
+        batch[f * count + i] = features[f];
+      }
+    }
+    std::vector<float> batched(count);
+    evaluator.evaluateBatch(batch.data(), count, count, batched.data());
+    TrainStats stats;
+    bool trained = Trainer::train(path, evaluator, stats);
+    std::remove(path.c_str());
+
+    // then the batch agrees and training does not make the fit worse
+    int mismatches = 0;
+    for (size_t i = 0; i < count; ++i) {
+      if (std::fabs(single[i] - batched[i]) > 1e-3f) {
+        mismatches++;
+      }
+    }
+    std::cout << stats.positions << " positions, RMS error "
+              << stats.errorBefore << " -> " << stats.errorAfter
+              << std::endl;
+    assert_equality("0 mismatches, trained, no worse",
+                    std::to_string(mismatches) + " mismatches, " +
+                        (trained ? "trained" : "not trained") +
+                        (stats.errorAfter <= stats.errorBefore
+                             ? ", no worse"
+                             : ", worse"));
+  }
+
+  static void positionBatchTest() {
+    std::cout << "#positionBatchTest" << std::endl;
+    // given positions from several greedy games, each with one placement
+    // to check: a legal one, or any tile near the placed tiles
+    PositionBatch batch(DEFAULT_BOARD_SIZE, DEFAULT_BOARD_SIZE, 200);
+    std::vector<GameState> positions;
+    std::vector<TileCode> tiles;
+    std::vector<int16_t> rows;
+    std::vector<int16_t> cols;
+    FastRandom random(9);
+    std::vector<Move> scratch;
+    for (uint64_t seed = 1; seed <= 5; ++seed) {
+      GameState state = GameState::newGame(seed);
+      for (int turn = 0; turn < 37 && !state.isTerminal(); ++turn) {
+        scratch.clear();
+        state.generatePlacements(scratch);
+        if (!scratch.empty() && random.below(2) == 0) {
+          const Move& move = scratch[random.below(scratch.size())];
+          tiles.push_back(move.tile);
+          rows.push_back(move.row);
+          cols.push_back(move.col);
+        } else {
+          const std::vector<TileCode>& hand = state.hands[state.toMove];
+          int top = state.getRows() / 2;
+          int bottom = top;
+          int left = state.getCols() / 2;
+          int right = left;
+          if (!state.isBoardEmpty()) {
+            state.boundingBox(top, bottom, left, right);
+          }
+          tiles.push_back(hand.empty() || random.below(4) == 0
+                              ? static_cast<TileCode>(1 + random.below(36))
+                              : hand[random.below(hand.size())]);
+          rows.push_back(static_cast<int16_t>(
+              top - 1 + random.below(bottom - top + 3)));
+          cols.push_back(static_cast<int16_t>(
+              left - 1 + random.below(right - left + 3)));
+        }
+        positions.push_back(state);
+        batch.add(state);
+        state.applyMove(MctsBot::greedyMove(state, scratch, random));
+      }
+    }
+
+    // when
+    BatchResults results;
+    batch.evaluate(tiles.data(), rows.data(), cols.data(), results);
+
+    // then every answer matches the one-position code
+    int mismatches = 0;
+    int legalCount = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+      const GameState& state = positions[i];
+      const std::vector<TileCode>& hand = state.hands[state.toMove];
+      bool legal =
+          std::find(hand.begin(), hand.end(), tiles[i]) != hand.end() &&
+          state.isValidPlacement(tiles[i], rows[i], cols[i]);
+      int score = legal ? state.scorePlacement(rows[i], cols[i]) : 0;
+      legalCount += legal ? 1 : 0;
+      if ((results.legal[i] != 0) != legal || results.scores[i] != score ||
+          std::fabs(results.evaluations[i] -
+                    Evaluator::shared().evaluate(state)) > 1e-3f) {
+        mismatches++;
+      }
+    }
+    std::cout << positions.size() << " positions, " << legalCount
+              << " legal placements" << std::endl;
+    assert_equality("0 mismatches", std::to_string(mismatches) +
+                                        " mismatches");
+  }
+
+  static void lockstepTest() {
+    std::cout << "#lockstepTest" << std::endl;
+    // given 40 seeded deals, more than two blocks of lanes
+    LockstepSimulator simulator(40);
+
+    // when they are played in lockstep
+    simulator.run(100);
+
+    // then each game ends exactly as it does on the game objects
+    int mismatches = 0;
+    for (size_t game = 0; game < simulator.games(); ++game) {
+      int scores[2];
+      LockstepSimulator::playObjects(100 + game, scores);
+      if (simulator.score(game, 0) != scores[0] ||
+          simulator.score(game, 1) != scores[1]) {
+        mismatches++;
+      }
+    }
+    std::cout << simulator.pliesPlayed() << " plies" << std::endl;
+    assert_equality("0 mismatches", std::to_string(mismatches) +
+                                        " mismatches");
+  }
+
+  static void gameEngineTest() {
+    std::cout << "#gameEngineTest" << std::endl;
+    // given unshuffled bags: the first player holds R1-R6, the second
+    // O1-O6
+    GameEngine base(false);
+    base.newGame("ALICE", "BOB", 0);
+    GameEngine enhanced(true);
+    enhanced.newGame("ALICE", "BOB", 0);
+
+    // when
+    CommandResult missing = base.place('Y', 1, 12, 12);
+    CommandResult first = base.place('R', 1, 12, 12);
+    CommandResult detached = base.place('O', 2, 0, 0);
+    CommandResult second = base.place('O', 1, 12, 13);
+    CommandResult swapped = base.replace('R', 2);
+    CommandResult kept = enhanced.place('R', 1, 12, 12);
+    CommandResult line = enhanced.place('R', 2, 12, 13);
+    int handBeforePass = enhanced.currentPlayer()->getHand()->getLength();
+    CommandResult passed = enhanced.pass();
+
+    // then base turns end with each move, enhanced turns with the pass
+    std::ostringstream outcome;
+    outcome << static_cast<int>(missing.status)
+            << static_cast<int>(detached.status) << " " << first.score
+            << first.turnEnded << " " << second.score << second.turnEnded
+            << " " << GameState::tileToString(swapped.removed)
+            << swapped.turnEnded << " " << kept.turnEnded << line.score
+            << handBeforePass << passed.turnEnded << " "
+            << enhanced.opponent()->getHand()->getLength() << " "
+            << base.currentPlayer()->getName() << " "
+            << base.player(0)->getScore() << "-" << base.player(1)->getScore();
+    assert_equality("12 11 21 R21 0241 6 BOB 1-2", outcome.str());
+  }
+
+  static void binarySaveTest() {
+    std::cout << "#binarySaveTest" << std::endl;
+    // given a shuffled game a few moves in, saved in both formats
+    GameEngine engine(false);
+    engine.newGame("ALICE", "BOB", 7);
+    for (int turn = 0; turn < 6; ++turn) {
+      Move move = GreedyBot(1).chooseMove(engine.snapshot());
+      if (move.type == MOVE_PLACE) {
+        engine.place(GameState::colourOf(move.tile),
+                     GameState::shapeOf(move.tile), move.row, move.col);
+      } else {
+        engine.replace(GameState::colourOf(move.tile),
+                       GameState::shapeOf(move.tile));
+      }
+    }
+    std::string textPath = "tests/stubs/binary-save-test-stub.txt";
+    std::string binaryPath = "tests/stubs/binary-save-test-stub.qwb";
+    engine.save(textPath);
+    engine.save(binaryPath);
+
+    // when both are loaded, and a copy with one byte flipped
+    GameEngine fromText(false);
+    GameEngine fromBinary(false);
+    bool textLoaded = fromText.load(textPath);
+    bool binaryLoaded = fromBinary.load(binaryPath);
+    std::ifstream in(binaryPath, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    in.close();
+    bytes[bytes.size() / 2] ^= 1;
+    std::ofstream(binaryPath, std::ios::binary) << bytes;
+    GameEngine corrupted(false);
+    bool corruptedLoaded = corrupted.load(binaryPath);
+    std::string textSize = std::to_string(
+        FileHandler().readFileContent(textPath).size());
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+
+    // then both formats give back the same game and the flip is caught
+    std::cout << "Text " << textSize << " bytes, binary " << bytes.size()
+              << " bytes" << std::endl;
+    std::ostringstream outcome;
+    outcome << textLoaded << binaryLoaded << corruptedLoaded << " "
+            << (fromText.digest() == engine.digest())
+            << (fromBinary.digest() == engine.digest()) << " "
+            << corrupted.lastError();
+    assert_equality("110 11 Error: Save file checksum mismatch",
+                    outcome.str());
+  }
+
+  static void binaryDuplicateCellTest() {
+    std::cout << "#binaryDuplicateCellTest" << std::endl;
+    // given a binary save whose second board cell is rewritten to repeat
+    // the first, with the checksum fixed up to match
+    GameEngine engine(false);
+    engine.newGame("ALICE", "BOB", 7);
+    engine.board()->placeTile(0, 0, new Tile(RED, CIRCLE));
+    engine.board()->placeTile(0, 1, new Tile(GREEN, CIRCLE));
+    std::string bytes = engine.saveBinary();
+    size_t at = BINARY_SAVE_MAGIC_SIZE + 1;
+    for (int p = 0; p < 2; ++p) {
+      at += 2 + engine.player(p)->getName().size() + 4 + 2 +
+            engine.player(p)->getHand()->getLength();
+    }
+    // Past rows, cols and the cell count to the second cell's column
+    at += 1 + 1 + 2 + 3 + 1;
+    bytes[at] = 0;
+    size_t body = bytes.size() - 4;
+    uint32_t hash = 0x811C9DC5u;
+    for (size_t i = 0; i < body; ++i) {
+      hash = (hash ^ static_cast<uint8_t>(bytes[i])) * 0x01000193u;
+    }
+    for (int i = 0; i < 4; ++i) {
+      bytes[body + i] = static_cast<char>((hash >> (8 * i)) & 0xFF);
+    }
+    std::string path = "tests/stubs/binary-duplicate-cell-test-stub.qwb";
+    std::ofstream(path, std::ios::binary) << bytes;
+
+    // when
+    GameEngine loaded(false);
+    bool ok = loaded.load(path);
+    std::remove(path.c_str());
+
+    // then the save is rejected rather than the first tile overwritten
+    std::ostringstream outcome;
+    outcome << ok << " " << loaded.lastError();
+    assert_equality("0 Error: Duplicate tile position - A0", outcome.str());
+  }
+
+  static void gameLogTest() {
+    std::cout << "#gameLogTest" << std::endl;
+    // given a logged game played past two snapshots
+    std::string path = "tests/stubs/game-log-test-stub.log";
+    GameEngine engine(false);
+    engine.newGame("ALICE", "BOB", 3);
+    GameLog log;
+    log.start(path, engine);
+    engine.setLog(&log);
+    GreedyBot bot(1);
+    for (int turn = 0; turn < 2 * GAME_LOG_SNAPSHOT_TURNS + 5; ++turn) {
+      Move move = bot.chooseMove(engine.snapshot());
+      if (move.type == MOVE_PLACE) {
+        engine.place(GameState::colourOf(move.tile),
+                     GameState::shapeOf(move.tile), move.row, move.col);
+      } else {
+        engine.replace(GameState::colourOf(move.tile),
+                       GameState::shapeOf(move.tile));
+      }
+    }
+    engine.setLog(nullptr);
+
+    // when the log is replayed, and again with its last byte torn off
+    std::string error;
+    std::unique_ptr<GameEngine> replayed(GameLog::replay(path, error));
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        << bytes.substr(0, bytes.size() - 1);
+    std::unique_ptr<GameEngine> torn(GameLog::replay(path, error));
+    GameLog resumed;
+    bool reopened = resumed.resume(path);
+    std::remove(path.c_str());
+
+    // then the replay matches the game and the torn log stops one short
+    std::ostringstream outcome;
+    outcome << (replayed && replayed->digest() == engine.digest())
+            << (torn && torn->digest() != engine.digest()) << reopened;
+    assert_equality("111", outcome.str());
+  }
+
+  static void backgroundSaverTest() {
+    std::cout << "#backgroundSaverTest" << std::endl;
+    // given
+    std::string path = "tests/stubs/background-saver-test-stub.txt";
+    BackgroundSaver saver;
+
+    // when saves of one path arrive faster than they are written, and
+    // one save targets a missing directory
+    for (int i = 0; i < 50; ++i) {
+      saver.submit(path, "save " + std::to_string(i));
+    }
+    saver.submit("tests/stubs/missing/save.txt", "lost");
+    saver.flush();
+    std::vector<SaveCompletion> finished = saver.takeFinished();
+    std::string content = FileHandler().readFileContent(path);
+    bool tempLeft = FileHandler::fileExists(path + SAVE_TEMP_SUFFIX);
+    std::remove(path.c_str());
+
+    // then every save is accounted for and the last one won
+    int saves = 0;
+    int failed = 0;
+    for (const SaveCompletion& save : finished) {
+      saves += 1 + save.coalesced;
+      failed += save.ok ? 0 : 1;
+    }
+    std::ostringstream outcome;
+    outcome << saves << " " << failed << " " << content << " " << tempLeft;
+    assert_equality("51 1 save 49 0", outcome.str());
+  }
+
+  static void gameArchiveTest() {
+    std::cout << "#gameArchiveTest" << std::endl;
+    // given more games than fit in one block, with ids far apart and
+    // placements on both sides of the previous one
+    std::string path = "tests/stubs/game-archive-test-stub.qwa";
+    int games = ARCHIVE_BLOCK_GAMES + 44;
+    auto makeGame = [](int i) {
+      ArchivedGame game;
+      game.id = 1000000007ULL * (i + 1);
+      game.date = 1700000000 + i * 60;
+      game.names[0] = "ALICE";
+      game.names[1] = i % 2 == 0 ? "BOB" : "CAROL";
+      game.seed = static_cast<uint64_t>(i);
+      for (int m = 0; m < i % 9; ++m) {
+        MoveType type = static_cast<MoveType>(m % 3);
+        TileCode tile =
+            type == MOVE_PASS ? EMPTY_CELL : static_cast<TileCode>(1 + m);
+        int16_t row = type == MOVE_PLACE ? static_cast<int16_t>(25 - m) : 0;
+        int16_t col = type == MOVE_PLACE ? static_cast<int16_t>(m * 3) : 0;
+        game.moves.push_back({type, tile, row, col});
+      }
+      return game;
+    };
+    ArchiveWriter writer;
+    writer.open(path);
+    for (int i = 0; i < games; ++i) {
+      writer.add(makeGame(i));
+    }
+    writer.close();
+
+    // when
+    ArchiveReader reader;
+    bool opened = reader.open(path);
+    int matching = 0;
+    for (int i = 0; i < games; ++i) {
+      size_t index = 0;
+      ArchivedGame game;
+      ArchivedGame expected = makeGame(i);
+      if (reader.find(expected.id, index) && reader.readGame(index, game) &&
+          game.date == expected.date && game.names[1] == expected.names[1] &&
+          game.seed == expected.seed && game.moves == expected.moves) {
+        matching++;
+      }
+    }
+    reader.close();
+    std::remove(path.c_str());
+
+    // then
+    std::ostringstream outcome;
+    outcome << opened << " " << matching;
+    assert_equality("1 " + std::to_string(games), outcome.str());
+  }
+
+  static void corruptArchiveTest() {
+    std::cout << "#corruptArchiveTest" << std::endl;
+    // given one archive holding a byte that is not a tile code, and one
+    // whose block claims fewer games than the index lists
+    std::string badTile = "tests/stubs/bad-tile-archive-test-stub.qwa";
+    std::string badCount = "tests/stubs/bad-count-archive-test-stub.qwa";
+    ArchivedGame game;
+    game.id = 1;
+    game.date = 1700000000;
+    game.names[0] = "ALICE";
+    game.names[1] = "BOB";
+    game.seed = 7;
+    game.moves.push_back({MOVE_REPLACE, NUM_TILE_KINDS + 1, 0, 0});
+    ArchiveWriter writer;
+    writer.open(badTile);
+    writer.add(game);
+    writer.close();
+    game.moves.clear();
+    writer.open(badCount);
+    for (int i = 0; i < 3; ++i) {
+      game.id = i + 1;
+      writer.add(game);
+    }
+    writer.close();
+    {
+      // The block's game count is the varint right after the header
+      std::fstream file(badCount, std::ios::in | std::ios::out |
+                                      std::ios::binary);
+      file.seekp(ARCHIVE_MAGIC_SIZE + 1);
+      file.put(2);
+    }
+
+    // when
+    ArchiveReader reader;
+    ArchivedGame out;
+    reader.open(badTile);
+    bool tileRead = reader.readGame(0, out);
+    reader.close();
+    reader.open(badCount);
+    bool lastRead = reader.readGame(2, out);
+    bool firstRead = reader.readGame(0, out);
+    reader.close();
+    std::remove(badTile.c_str());
+    std::remove(badCount.c_str());
+
+    // then both are rejected rather than decoded
+    std::ostringstream outcome;
+    outcome << tileRead << " " << lastRead << " " << firstRead;
+    assert_equality("0 0 0", outcome.str());
+  }
+
+  static void engineArchiveTest() {
+    std::cout << "#engineArchiveTest" << std::endl;
+    // given a logged enhanced game, which has no seed, opened with a
+    // placeAll move and then played one placement a turn
+    std::string logPath = "tests/stubs/engine-archive-test-stub.log";
+    std::string archivePath = "tests/stubs/engine-archive-test-stub.qwa";
+    GameEngine engine(true);
+    engine.newGame("ALICE", "BOB", 5);
+    LinkedList* hand = engine.currentPlayer()->getHand();
+    hand->clear();
+    for (int shape = 1; shape <= 6; ++shape) {
+      hand->addBack(new Tile(BLUE, shape));
+    }
+    GameLog log;
+    log.start(logPath, engine);
+    engine.setLog(&log);
+    Command opening;
+    CommandParser::parse("place B1 at M10, B2 at M11, B3 at M12", true,
+                         opening);
+    engine.placeAll(opening.placements, opening.placementCount);
+    engine.pass();
+    GreedyBot bot(1);
+    for (int turn = 0; turn < 12; ++turn) {
+      Move move = bot.chooseMove(engine.snapshot());
+      if (move.type == MOVE_PLACE) {
+        engine.place(GameState::colourOf(move.tile),
+                     GameState::shapeOf(move.tile), move.row, move.col);
+      }
+      engine.pass();
+    }
+    engine.setLog(nullptr);
+
+    // when it is archived beside a self-play game and read back
+    ArchivedGame game;
+    std::string error;
+    bool imported = GameLog::toArchive(logPath, game, error);
+    game.id = 2;
+    ArchivedGame seeded;
+    seeded.id = 1;
+    seeded.seed = 9;
+    ArchiveWriter writer;
+    writer.open(archivePath);
+    writer.add(seeded);
+    writer.add(game);
+    writer.close();
+    ArchiveReader reader;
+    ArchivedGame read;
+    reader.open(archivePath);
+    bool found = reader.readGame(1, read);
+    reader.close();
+    std::unique_ptr<GameEngine> replayed(GameLog::replay(read, error));
+    std::unique_ptr<GameEngine> fromSeed(GameLog::replay(seeded, error));
+    std::remove(logPath.c_str());
+    std::remove(archivePath.c_str());
+
+    // then the archived game keeps its names, rules and grouped opening,
+    // and replays to the same position; a seeded game is not replayed
+    std::ostringstream outcome;
+    outcome << imported << found << read.names[1] << read.enhanced
+            << (read.joined.size() == read.moves.size()) << read.joined[2]
+            << (replayed && replayed->digest() == engine.digest())
+            << (fromSeed == nullptr);
+    assert_equality("11BOB11111", outcome.str());
+  }
+
+  static void bulkLoaderTest() {
+    std::cout << "#bulkLoaderTest" << std::endl;
+    // given the stubs directory and one save that does not exist
+    std::vector<std::string> files = BulkLoader::collect(
+        {"tests/stubs", "tests/stubs/missing-save.txt"});
+    std::string converted = BulkLoader::outputPath(
+        "tests/stubs/load-game-test-stub.txt", SAVE_BINARY);
+
+    // when every save is converted to binary and the results validated
+    BulkStats convertStats;
+    std::vector<BulkResult> results =
+        BulkLoader::run(files, true, SAVE_BINARY, convertStats);
+    BulkStats validateStats;
+    BulkLoader::run({converted}, false, SAVE_TEXT, validateStats);
+    for (const BulkResult& result : results) {
+      std::remove(result.output.c_str());
+    }
+
+    // then the missing save alone fails, and the stub keeps its warning
+    std::ostringstream outcome;
+    outcome << files.size() << " " << convertStats.failed << " "
+            << results[0].ok << " " << results[0].warning << " "
+            << validateStats.failed;
+    assert_equality("3 1 1 3 copies of R1 0", outcome.str());
+  }
+
+  static void textSaveErrorTest() {
+    std::cout << "#textSaveErrorTest" << std::endl;
+    // given the load-game stub with one board tile off the board
+    std::string content = FileHandler().readFileContent(
+        "tests/stubs/load-game-test-stub.txt");
+    content.replace(content.find("B3@C2"), 5, "B3@Z2");
+    std::string path = "tests/stubs/text-save-error-test-stub.txt";
+    std::ofstream(path) << content;
+
+    // when
+    Player player1("P1");
+    Player player2("P2");
+    TileBag tileBag;
+    Player current("CURRENT");
+    GameBoard* board = nullptr;
+    FileHandler fileHandler;
+    bool loaded = fileHandler.loadGame(path, &player1, &player2, &tileBag,
+                                       board, &current);
+    std::remove(path.c_str());
+
+    // then the error names the cell and nothing was changed
+    std::ostringstream outcome;
+    outcome << loaded << (board == nullptr) << " " << player1.getName()
+            << " " << fileHandler.getLastError();
+    assert_equality(
+        "01 P1 Error: Invalid tile position - Z2 at line 8, column 16",
+        outcome.str());
+  }
+  static void saveFormatValidatorTest() {
+    std::cout << "#saveFormatValidatorTest" << std::endl;
+    // given the load-game stub, edited to use a two-digit column, to put a
+    // tile past the last column, to put two tiles on one cell, and to
+    // declare an empty board, and a name far longer than any line the
+    // regex could backtrack over
+    std::string stub = FileHandler().readFileContent(
+        "tests/stubs/load-game-test-stub.txt");
+    std::string wideColumn = stub;
+    wideColumn.replace(wideColumn.find("Y4@D3"), 5, "Y4@D11");
+    std::string offBoard = stub;
+    offBoard.replace(offBoard.find("Y4@D3"), 5, "Y4@D12");
+    std::string sameCell = stub;
+    sameCell.replace(sameCell.find("Y4@D3"), 5, "Y4@C2");
+    std::string noBoard = stub;
+    noBoard.replace(noBoard.find("12,12\nR1@A0,G2@B1,B3@C2,Y4@D3"), 29,
+                    "0,0\n");
+    std::string longName = std::string(1 << 20, 'A') + "\n";
+
+    // when
+    SaveFormatError wideError;
+    SaveFormatError offBoardError;
+    SaveFormatError sameCellError;
+    SaveFormatError noBoardError;
+    SaveFormatError longNameError;
+    bool stubValid = InputValidator::isFileFormatValid(stub);
+    bool wideValid = InputValidator::isFileFormatValid(wideColumn, wideError);
+    InputValidator::isFileFormatValid(offBoard, offBoardError);
+    InputValidator::isFileFormatValid(sameCell, sameCellError);
+    InputValidator::isFileFormatValid(noBoard, noBoardError);
+    InputValidator::isFileFormatValid(longName, longNameError);
+
+    // then
+    std::ostringstream outcome;
+    outcome << stubValid << wideValid << " " << offBoardError.message()
+            << " / " << sameCellError.message() << " / "
+            << noBoardError.message() << " / " << longNameError.message();
+    assert_equality(
+        "11 Error: Invalid tile position - D12 at line 8, column 22 / "
+        "Error: Duplicate tile position - C2 at line 8, column 22 / "
+        "Error: Invalid board size - 0,0 at line 7, column 1 / "
+        "Error: Missing player score at line 2, column 1",
+        outcome.str());
+  }
+  static void commandParserTest() {
+    std::cout << "#commandParserTest" << std::endl;
+    // given lines that are valid, malformed (one with a column past any
+    // board), or valid only when enhanced
+    const char* lines[] = {"place R1 at C12", "  place B6   at A0 ", "hint 250",
+                           "replace G2", "pass", "place R1 at 3", "replace",
+                           "hint 0", "place R1 at C1 now",
+                           "place R1 at A65536", ""};
+
+    // when each line is parsed in the base game
+    std::ostringstream outcome;
+    for (const char* line : lines) {
+      Command command;
+      if (CommandParser::parse(line, false, command)) {
+        outcome << static_cast<int>(command.verb)
+                << (command.colour ? command.colour : '-') << command.shape;
+        for (int i = 0; i < command.placementCount; ++i) {
+          outcome << "@" << command.placements[i].row << ","
+                  << command.placements[i].col;
+        }
+        outcome << "/" << command.hintMs << " ";
+      } else {
+        outcome << std::string(command.error).substr(8, 4) << " ";
+      }
+    }
+    Command enhancedPass;
+    outcome << CommandParser::parse("pass", true, enhancedPass)
+            << static_cast<int>(enhancedPass.verb);
+
+    // then arguments are typed, and each error is the usage it belongs to
+    assert_equality(
+        "6R1@2,12/0 6B6@0,0/0 3-0/250 5G2/0 move move tile hint "
+        "move move move 14",
+        outcome.str());
+  }
+  static void placeAllTest() {
+    std::cout << "#placeAllTest" << std::endl;
+    // given an enhanced game with R1, R2 and R3 in hand and R1 on the board
+    GameEngine engine(true);
+    engine.newGame("ALICE", "BOB", 1);
+    LinkedList* hand = engine.currentPlayer()->getHand();
+    hand->clear();
+    for (int shape = 1; shape <= 3; ++shape) {
+      hand->addBack(new Tile(RED, shape));
+    }
+    engine.board()->placeTile(5, 4, new Tile(RED, CLOVER));
+    uint64_t before = engine.digest();
+
+    // when a move leaves a gap, then one names a tile held once twice,
+    // then a legal move extends the line
+    Command gap;
+    Command twice;
+    Command line;
+    CommandParser::parse("place R1 at F3, R2 at F1", true, gap);
+    CommandParser::parse("place R1 at F3,R1 at F2", true, twice);
+    CommandParser::parse("place R3 at F3, R2 at F2, R1 at F1", true, line);
+    CommandResult gapResult = engine.placeAll(gap.placements,
+                                              gap.placementCount);
+    CommandResult twiceResult = engine.placeAll(twice.placements,
+                                                twice.placementCount);
+    bool unchanged = engine.digest() == before;
+    CommandResult lineResult = engine.placeAll(line.placements,
+                                               line.placementCount);
+
+    // and, on an empty board, four tiles in a line and then a six-tile
+    // line with one tile already down
+    GameEngine fresh(true);
+    fresh.newGame("ALICE", "BOB", 1);
+    LinkedList* freshHand = fresh.currentPlayer()->getHand();
+    freshHand->clear();
+    for (int shape = 1; shape <= 6; ++shape) {
+      freshHand->addBack(new Tile(BLUE, shape));
+    }
+    Command four;
+    Command qwirkle;
+    CommandParser::parse("place B1 at A0, B2 at A1, B3 at A2, B4 at A3", true,
+                         four);
+    CommandParser::parse("place B5 at A4, B6 at A5", true, qwirkle);
+    CommandResult fourResult = fresh.placeAll(four.placements,
+                                              four.placementCount);
+    CommandResult qwirkleResult = fresh.placeAll(qwirkle.placements,
+                                                 qwirkle.placementCount);
+
+    // then the failures left the game alone, and each move scored its
+    // shared line once: 4 along F, 4 along A, then 6 and a QWIRKLE bonus
+    std::ostringstream outcome;
+    outcome << static_cast<int>(gapResult.status) << " "
+            << static_cast<int>(twiceResult.status) << " " << unchanged
+            << " " << static_cast<int>(lineResult.status) << " "
+            << lineResult.score << " " << lineResult.turnEnded << " "
+            << hand->getLength() << " " << fourResult.score << " "
+            << fourResult.qwirkles << " " << qwirkleResult.score << " "
+            << qwirkleResult.qwirkles;
+    assert_equality("2 1 1 0 4 0 0 4 0 12 1", outcome.str());
+  }
+  static void boardViewTest() {
+    std::cout << "#boardViewTest" << std::endl;
+    // given a board of more than 26 rows with one tile near the bottom
+    GameBoard board(30, 12);
+    board.placeTile(27, 10, new Tile(RED, CIRCLE));
+
+    // when the played area is shown with a margin of one
+    BoardView view = board.occupiedView(BOARD_VIEW_MARGIN);
+    std::string cropped = board.displayBoard(false, view);
+
+    // then only three rows and columns are drawn, with two-letter labels
+    std::ostringstream outcome;
+    outcome << view.top << "," << view.left << " " << view.rows << "x"
+            << view.cols << " " << GameBoard::rowLabel(701) << "\n"
+            << cropped;
+    assert_equality(
+        "26,9 3x3 ZZ\n"
+        "    9 10 11 \n"
+        " -----------\n"
+        "AA|  |  |  |\n"
+        "AB|  |R1|  |\n"
+        "AC|  |  |  |\n",
+        outcome.str());
+  }
+
+
+
+
+
+  // Points still to come for the player to move, searched without pruning
+  static int minimaxEndgame(const GameState& state, int bonus) {
+    if ((state.hands[0].empty() && state.hands[1].empty()) ||
+        state.idleTurns >= 2) {
+      return 0;
+    }
+    std::vector<Move> moves;
+    state.generateMoves(moves);
+    int best = -1000000;
+    for (const Move& move : moves) {
+      GameState child = state;
+      child.applyMove(move);
+      int points = child.scores[state.toMove] - state.scores[state.toMove];
+      if (move.type == MOVE_PLACE && child.hands[state.toMove].empty() &&
+          !state.hands[1 - state.toMove].empty()) {
+        points += bonus;
+      }
+      best = std::max(best, points - minimaxEndgame(child, bonus));
+    }
+    return best;
+  }
+
   static void assert_equality(std::string expected, std::string actual) {
     if (expected != actual) {
       std::cout << "\033[91m" << "Failed \n" << "\033[0m" << std::endl;
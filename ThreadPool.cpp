@@ -0,0 +1,238 @@
+#include "ThreadPool.h"
+
+#include <chrono>
+
+namespace {
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentIndex = -1;
+
+// Small arithmetic kernel used as the benchmark task body
+unsigned int spinWork(unsigned int seed, int amount) {
+  for (int i = 0; i < amount; ++i) {
+    seed = seed * 1664525u + 1013904223u;
+  }
+  return seed;
+}
+}  // namespace
+
+TaskGroup::TaskGroup() : pending(0) {}
+
+bool TaskGroup::isDone() const { return pending.load() == 0; }
+
+double PoolBenchmark::overheadNsPerTask() const {
+  if (tasks <= 0) {
+    return 0.0;
+  }
+  return (parallelMs - serialMs) * 1e6 / tasks;
+}
+
+ThreadPool::WorkerQueue::WorkerQueue() : pinnedCount(0) {}
+
+ThreadPool::ThreadPool(int workers)
+    : nextQueue(0), queuedTasks(0), sleepers(0), stopping(false) {
+  if (workers <= 0) {
+    workers = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  if (workers <= 0) {
+    workers = 1;
+  }
+  for (int i = 0; i < workers; ++i) {
+    queues.emplace_back(new WorkerQueue());
+  }
+  for (int i = 0; i < workers; ++i) {
+    threads.emplace_back([this, i]() { workerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  stopping.store(true);
+  {
+    std::lock_guard<std::mutex> guard(sleepLock);
+  }
+  wake.notify_all();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+ThreadPool& ThreadPool::shared() {
+  static ThreadPool pool;
+  return pool;
+}
+
+int ThreadPool::size() const { return static_cast<int>(queues.size()); }
+
+int ThreadPool::currentWorker() const {
+  return currentPool == this ? currentIndex : -1;
+}
+
+void ThreadPool::submit(TaskGroup& group, std::function<void()> task,
+                        int affinity) {
+  group.pending.fetch_add(1);
+
+  int self = currentWorker();
+  if (affinity >= size()) {
+    affinity = affinity % size();
+  }
+  if (affinity >= 0) {
+    WorkerQueue& queue = *queues[affinity];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    queue.pinned.push_back({std::move(task), &group});
+    queue.pinnedCount.fetch_add(1);
+  } else {
+    // Work spawned on a worker stays local; outside work is spread out
+    int target = self >= 0 ? self : static_cast<int>(nextQueue.fetch_add(1) %
+                                                     queues.size());
+    WorkerQueue& queue = *queues[target];
+    std::lock_guard<std::mutex> guard(queue.lock);
+    queue.tasks.push_back({std::move(task), &group});
+    queuedTasks.fetch_add(1);
+  }
+
+  if (sleepers.load() > 0) {
+    {
+      std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    if (affinity >= 0) {
+      // The pinned worker may not be the sleeper notify_one would pick;
+      // the rest find nothing for them and go straight back to sleep
+      wake.notify_all();
+    } else {
+      wake.notify_one();
+    }
+  }
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+  int index = currentWorker();
+  int spins = 0;
+  while (group.pending.load(std::memory_order_acquire) > 0) {
+    Task task;
+    if (findTask(index, task)) {
+      runTask(task);
+      spins = 0;
+    } else if (++spins < THREAD_POOL_SPIN_LIMIT) {
+      std::this_thread::yield();
+    } else {
+      spins = 0;
+      sleep(index, &group);
+    }
+  }
+}
+
+void ThreadPool::runTask(Task& task) {
+  task.function();
+  if (task.group->pending.fetch_sub(1) == 1 &&
+      sleepers.load() > 0) {
+    // Last task of the group: a waiter may be asleep on it
+    {
+      std::lock_guard<std::mutex> guard(sleepLock);
+    }
+    wake.notify_all();
+  }
+}
+
+bool ThreadPool::hasWork(int index) const {
+  return queuedTasks.load() > 0 ||
+         (index >= 0 && queues[index]->pinnedCount.load() > 0);
+}
+
+void ThreadPool::sleep(int index, const TaskGroup* group) {
+  std::unique_lock<std::mutex> guard(sleepLock);
+  sleepers.fetch_add(1);
+  wake.wait(guard, [this, index, group]() {
+    return stopping.load() || (group != nullptr && group->isDone()) ||
+           hasWork(index);
+  });
+  sleepers.fetch_sub(1);
+}
+
+bool ThreadPool::findTask(int index, Task& task) {
+  if (index >= 0) {
+    WorkerQueue& own = *queues[index];
+    std::lock_guard<std::mutex> guard(own.lock);
+    if (!own.pinned.empty()) {
+      task = std::move(own.pinned.front());
+      own.pinned.pop_front();
+      own.pinnedCount.fetch_sub(1);
+      return true;
+    }
+    if (!own.tasks.empty()) {
+      // Newest first keeps the owner's working set warm
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queuedTasks.fetch_sub(1);
+      return true;
+    }
+  }
+  return steal(index, task);
+}
+
+bool ThreadPool::steal(int thief, Task& task) {
+  int count = size();
+  int start = thief >= 0 ? thief + 1 : static_cast<int>(nextQueue.load());
+  for (int offset = 0; offset < count; ++offset) {
+    int victim = (start + offset) % count;
+    if (victim == thief) {
+      continue;
+    }
+    WorkerQueue& queue = *queues[victim];
+    std::unique_lock<std::mutex> guard(queue.lock, std::try_to_lock);
+    if (!guard.owns_lock() || queue.tasks.empty()) {
+      continue;
+    }
+    // Oldest first: thieves take the biggest remaining pieces of work
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queuedTasks.fetch_sub(1);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+  currentPool = this;
+  currentIndex = index;
+  int spins = 0;
+  while (!stopping.load()) {
+    Task task;
+    if (findTask(index, task)) {
+      runTask(task);
+      spins = 0;
+      continue;
+    }
+    if (++spins < THREAD_POOL_SPIN_LIMIT) {
+      std::this_thread::yield();
+      continue;
+    }
+    spins = 0;
+    sleep(index, nullptr);
+  }
+}
+
+PoolBenchmark ThreadPool::measureOverhead(int tasks, int workPerTask) {
+  PoolBenchmark result;
+  result.tasks = tasks;
+  std::vector<unsigned int> sink(tasks);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < tasks; ++i) {
+    sink[i] = spinWork(i, workPerTask);
+  }
+  result.serialMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  start = std::chrono::steady_clock::now();
+  TaskGroup group;
+  for (int i = 0; i < tasks; ++i) {
+    submit(group, [&sink, i, workPerTask]() {
+      sink[i] = spinWork(i, workPerTask);
+    });
+  }
+  wait(group);
+  result.parallelMs = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  return result;
+}
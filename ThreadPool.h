@@ -0,0 +1,107 @@
+#ifndef ASSIGN2_THREADPOOL_H
+#define ASSIGN2_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Spins a worker or waiter makes looking for work before it goes to sleep
+#define THREAD_POOL_SPIN_LIMIT 256
+
+// Tracks a set of tasks so callers can wait for all of them
+class TaskGroup {
+ public:
+  TaskGroup();
+  bool isDone() const;
+
+ private:
+  friend class ThreadPool;
+  std::atomic<int> pending;
+};
+
+struct PoolBenchmark {
+  int tasks;
+  double serialMs;    // running the task bodies in a plain loop
+  double parallelMs;  // submitting and waiting through the pool
+  double overheadNsPerTask() const;
+};
+
+/*
+ * Work-stealing thread pool shared by the engine. Every worker owns a
+ * deque: it pushes and pops its own work at the back and idle workers
+ * steal from the front of the others. Tasks submitted with an affinity
+ * go to that worker's pinned queue and are never stolen, and are counted
+ * apart from the stealable work so they only wake their own worker.
+ * Threads that wait on a TaskGroup run queued tasks while there are any,
+ * so nested submissions cannot deadlock, and otherwise sleep until the
+ * group finishes or more work arrives.
+ */
+class ThreadPool {
+ public:
+  // 0 workers means one per hardware thread
+  explicit ThreadPool(int workers = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  // Engine-wide pool, created on first use
+  static ThreadPool& shared();
+
+  // Queue a task; affinity >= 0 pins it to that worker
+  void submit(TaskGroup& group, std::function<void()> task,
+              int affinity = -1);
+
+  // Run queued tasks until every task in the group has finished
+  void wait(TaskGroup& group);
+
+  int size() const;
+
+  // Index of the calling worker thread, or -1 outside the pool
+  int currentWorker() const;
+
+  // Time many tiny tasks through the pool against a plain loop
+  PoolBenchmark measureOverhead(int tasks, int workPerTask);
+
+ private:
+  struct Task {
+    std::function<void()> function;
+    TaskGroup* group;
+  };
+
+  struct WorkerQueue {
+    std::mutex lock;
+    std::deque<Task> tasks;
+    std::deque<Task> pinned;
+    // Size of 'pinned', readable without the lock
+    std::atomic<int> pinnedCount;
+
+    WorkerQueue();
+  };
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<unsigned int> nextQueue;
+  // Stealable tasks only; pinned ones are counted per worker
+  std::atomic<int> queuedTasks;
+  std::atomic<int> sleepers;
+  std::atomic<bool> stopping;
+  std::mutex sleepLock;
+  std::condition_variable wake;
+
+  void workerLoop(int index);
+  bool findTask(int index, Task& task);
+  bool steal(int thief, Task& task);
+  // Work the thread at 'index' could pick up; call with sleepLock held
+  bool hasWork(int index) const;
+  // Block until there is work, the pool stops or 'group' (if any) is done
+  void sleep(int index, const TaskGroup* group);
+  void runTask(Task& task);
+};
+
+#endif  // ASSIGN2_THREADPOOL_H
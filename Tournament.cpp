@@ -0,0 +1,264 @@
+#include "Tournament.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#include "Bot.h"
+#include "ThreadPool.h"
+
+// Iterations of the Bradley-Terry MM fit
+#define RATING_ITERATIONS 2000
+
+namespace {
+// Derive a distinct, well mixed seed from a base seed and an index
+uint64_t mixSeed(uint64_t base, uint64_t index) {
+  uint64_t z = base + 0x9E3779B97F4A7C15ULL * (index + 1);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+}  // namespace
+
+TournamentConfig::TournamentConfig()
+    : pairing(PAIRING_ROUND_ROBIN), rounds(10), seed(1) {}
+
+Tournament::Tournament(const TournamentConfig& config)
+    : config(config), elapsedMs(0.0) {}
+
+const std::vector<GameResult>& Tournament::getResults() const {
+  return results;
+}
+
+double Tournament::getElapsedMs() const { return elapsedMs; }
+
+GameResult Tournament::playGame(const std::string& firstSpec,
+                                const std::string& secondSpec,
+                                uint64_t seed) {
+  GameResult result = {0, 1, seed, 0, 0};
+  std::unique_ptr<Bot> bots[2] = {
+      std::unique_ptr<Bot>(createBot(firstSpec, mixSeed(seed, 1))),
+      std::unique_ptr<Bot>(createBot(secondSpec, mixSeed(seed, 2)))};
+  if (!bots[0] || !bots[1]) {
+    return result;
+  }
+
+  GameState state = GameState::newGame(seed);
+  for (int turn = 0; turn < TOURNAMENT_MAX_TURNS && !state.isTerminal();
+       ++turn) {
+    state.applyMove(bots[state.toMove]->chooseMove(state));
+  }
+  result.firstScore = state.scores[0];
+  result.secondScore = state.scores[1];
+  return result;
+}
+
+bool Tournament::run() {
+  for (const std::string& spec : config.bots) {
+    std::unique_ptr<Bot> probe(createBot(spec, 1));
+    if (!probe) {
+      return false;
+    }
+  }
+
+  results.clear();
+  auto start = std::chrono::steady_clock::now();
+  if (config.pairing == PAIRING_ROUND_ROBIN) {
+    playPairs(roundRobinPairs());
+  } else {
+    // Swiss pairings depend on the standings, so rounds run in order
+    for (int round = 0; round < config.rounds; ++round) {
+      playPairs(swissPairs(round));
+    }
+  }
+  elapsedMs = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  return true;
+}
+
+void Tournament::playPairs(const std::vector<GameResult>& pairs) {
+  std::vector<GameResult> played(pairs.size() * 2);
+  ThreadPool& pool = ThreadPool::shared();
+  TaskGroup group;
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    for (int swap = 0; swap < 2; ++swap) {
+      GameResult* slot = &played[i * 2 + swap];
+      int first = swap == 0 ? pairs[i].first : pairs[i].second;
+      int second = swap == 0 ? pairs[i].second : pairs[i].first;
+      uint64_t seed = pairs[i].seed;
+      const std::vector<std::string>& bots = config.bots;
+      pool.submit(group, [slot, first, second, seed, &bots]() {
+        *slot = playGame(bots[first], bots[second], seed);
+        slot->first = first;
+        slot->second = second;
+      });
+    }
+  }
+  pool.wait(group);
+  results.insert(results.end(), played.begin(), played.end());
+}
+
+std::vector<GameResult> Tournament::roundRobinPairs() const {
+  std::vector<GameResult> pairs;
+  int count = static_cast<int>(config.bots.size());
+  for (int round = 0; round < config.rounds; ++round) {
+    // Every pairing reuses the same seeds, so all bots face the same deals
+    uint64_t seed = mixSeed(config.seed, round);
+    for (int a = 0; a < count; ++a) {
+      for (int b = a + 1; b < count; ++b) {
+        pairs.push_back({a, b, seed, 0, 0});
+      }
+    }
+  }
+  return pairs;
+}
+
+std::vector<GameResult> Tournament::swissPairs(int round) const {
+  int count = static_cast<int>(config.bots.size());
+  std::vector<double> points(count, 0.0);
+  std::vector<std::vector<bool>> met(count, std::vector<bool>(count, false));
+  for (const GameResult& game : results) {
+    met[game.first][game.second] = true;
+    met[game.second][game.first] = true;
+    if (game.firstScore > game.secondScore) {
+      points[game.first] += 1.0;
+    } else if (game.firstScore < game.secondScore) {
+      points[game.second] += 1.0;
+    } else {
+      points[game.first] += 0.5;
+      points[game.second] += 0.5;
+    }
+  }
+
+  std::vector<int> order(count);
+  for (int i = 0; i < count; ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&points](int a, int b) { return points[a] > points[b]; });
+
+  // Pair each bot with the closest-ranked bot it has not met yet; the
+  // lowest ranked bot sits out when the count is odd
+  std::vector<bool> paired(count, false);
+  std::vector<GameResult> pairs;
+  uint64_t seed = mixSeed(config.seed, round);
+  for (int i = 0; i < count; ++i) {
+    int a = order[i];
+    if (paired[a]) {
+      continue;
+    }
+    int opponent = -1;
+    for (int j = i + 1; j < count; ++j) {
+      int b = order[j];
+      if (paired[b]) {
+        continue;
+      }
+      if (!met[a][b]) {
+        opponent = b;
+        break;
+      }
+      if (opponent == -1) {
+        opponent = b;
+      }
+    }
+    if (opponent != -1) {
+      paired[a] = true;
+      paired[opponent] = true;
+      pairs.push_back({a, opponent, seed, 0, 0});
+    }
+  }
+  return pairs;
+}
+
+std::vector<RatingRow> Tournament::ratings() const {
+  int count = static_cast<int>(config.bots.size());
+  std::vector<RatingRow> rows(count);
+  // wins[i][j] counts draws as half a win; games[i][j] is symmetric
+  std::vector<std::vector<double>> wins(count, std::vector<double>(count, 0));
+  std::vector<std::vector<double>> games(count, std::vector<double>(count, 0));
+  for (int i = 0; i < count; ++i) {
+    rows[i] = {i, 0, 0, 0, 0, 0.0, 0.0};
+  }
+
+  for (const GameResult& game : results) {
+    int a = game.first;
+    int b = game.second;
+    rows[a].games++;
+    rows[b].games++;
+    games[a][b] += 1.0;
+    games[b][a] += 1.0;
+    if (game.firstScore > game.secondScore) {
+      rows[a].wins++;
+      rows[b].losses++;
+      wins[a][b] += 1.0;
+    } else if (game.firstScore < game.secondScore) {
+      rows[b].wins++;
+      rows[a].losses++;
+      wins[b][a] += 1.0;
+    } else {
+      rows[a].draws++;
+      rows[b].draws++;
+      wins[a][b] += 0.5;
+      wins[b][a] += 0.5;
+    }
+  }
+
+  // One virtual draw per pairing keeps unbeaten or winless bots finite
+  for (int i = 0; i < count; ++i) {
+    for (int j = 0; j < count; ++j) {
+      if (i != j && games[i][j] > 0) {
+        wins[i][j] += 0.5;
+        games[i][j] += 1.0;
+      }
+    }
+  }
+
+  // Hunter's MM iteration for the Bradley-Terry strengths
+  std::vector<double> gamma(count, 1.0);
+  for (int iteration = 0; iteration < RATING_ITERATIONS; ++iteration) {
+    std::vector<double> next(count, 1.0);
+    for (int i = 0; i < count; ++i) {
+      double totalWins = 0.0;
+      double denominator = 0.0;
+      for (int j = 0; j < count; ++j) {
+        if (i != j && games[i][j] > 0) {
+          totalWins += wins[i][j];
+          denominator += games[i][j] / (gamma[i] + gamma[j]);
+        }
+      }
+      next[i] = denominator > 0 ? totalWins / denominator : 1.0;
+    }
+    // Anchor the geometric mean at 1 (average Elo of 0)
+    double logMean = 0.0;
+    for (double value : next) {
+      logMean += std::log(value);
+    }
+    logMean /= count;
+    for (int i = 0; i < count; ++i) {
+      gamma[i] = next[i] / std::exp(logMean);
+    }
+  }
+
+  const double eloPerNat = 400.0 / std::log(10.0);
+  for (int i = 0; i < count; ++i) {
+    rows[i].elo = eloPerNat * std::log(gamma[i]);
+    // Diagonal of the Fisher information for log-strength
+    double information = 0.0;
+    for (int j = 0; j < count; ++j) {
+      if (i != j && games[i][j] > 0) {
+        double p = gamma[i] / (gamma[i] + gamma[j]);
+        information += games[i][j] * p * (1.0 - p);
+      }
+    }
+    rows[i].eloError =
+        information > 0 ? 1.96 * eloPerNat / std::sqrt(information) : 0.0;
+  }
+
+  std::sort(rows.begin(), rows.end(), [](const RatingRow& a,
+                                         const RatingRow& b) {
+    return a.elo > b.elo;
+  });
+  return rows;
+}
@@ -0,0 +1,79 @@
+#ifndef ASSIGN2_TOURNAMENT_H
+#define ASSIGN2_TOURNAMENT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "GameState.h"
+
+// Safety cap on turns in one tournament game
+#define TOURNAMENT_MAX_TURNS 1000
+
+enum PairingMode { PAIRING_ROUND_ROBIN, PAIRING_SWISS };
+
+struct TournamentConfig {
+  std::vector<std::string> bots;
+  PairingMode pairing;
+  // Round robin: seeds per pairing. Swiss: number of rounds.
+  int rounds;
+  uint64_t seed;
+
+  TournamentConfig();
+};
+
+// One game; 'first' is the bot in seat one
+struct GameResult {
+  int first;
+  int second;
+  uint64_t seed;
+  int firstScore;
+  int secondScore;
+};
+
+struct RatingRow {
+  int bot;
+  int games;
+  int wins;
+  int draws;
+  int losses;
+  double elo;
+  // Half width of the 95% confidence interval, in Elo points
+  double eloError;
+};
+
+/*
+ * Plays bots against each other on the shared thread pool. Every pairing
+ * is played as a seat-swapped pair of games on the same seed, so both
+ * bots see the same bag order from both seats, which cancels most of the
+ * luck of the draw. Ratings are fitted with a Bradley-Terry model.
+ */
+class Tournament {
+ public:
+  explicit Tournament(const TournamentConfig& config);
+
+  // Returns false if a bot configuration cannot be built
+  bool run();
+
+  const std::vector<GameResult>& getResults() const;
+  double getElapsedMs() const;
+
+  // Bradley-Terry ratings on the Elo scale, best first
+  std::vector<RatingRow> ratings() const;
+
+  // Play a single game between two bot configurations
+  static GameResult playGame(const std::string& firstSpec,
+                             const std::string& secondSpec, uint64_t seed);
+
+ private:
+  TournamentConfig config;
+  std::vector<GameResult> results;
+  double elapsedMs;
+
+  // Play seat-swapped pairs for all (a, b, seed) triples in parallel
+  void playPairs(const std::vector<GameResult>& pairs);
+  std::vector<GameResult> roundRobinPairs() const;
+  std::vector<GameResult> swissPairs(int round) const;
+};
+
+#endif  // ASSIGN2_TOURNAMENT_H
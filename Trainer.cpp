@@ -0,0 +1,225 @@
+#include "Trainer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "Bot.h"
+#include "ThreadPool.h"
+
+namespace {
+// Sum of squared errors of 'weights', from the accumulated sums
+double squaredError(const double* weights,
+                    const double products[][EVAL_FEATURES],
+                    const double* targets, double targetSquares) {
+  double error = targetSquares;
+  for (int i = 0; i < EVAL_FEATURES; ++i) {
+    error -= 2.0 * weights[i] * targets[i];
+    for (int j = 0; j < EVAL_FEATURES; ++j) {
+      error += weights[i] * products[i][j] * weights[j];
+    }
+  }
+  return std::max(error, 0.0);
+}
+}  // namespace
+
+std::string Trainer::encodeMove(const Move& move) {
+  if (move.type == MOVE_PLACE) {
+    return "P" + std::to_string(move.tile) + "/" + std::to_string(move.row) +
+           "/" + std::to_string(move.col);
+  }
+  if (move.type == MOVE_REPLACE) {
+    return "R" + std::to_string(move.tile);
+  }
+  return "X";
+}
+
+bool Trainer::decodeMove(const std::string& token, Move& move) {
+  move = {MOVE_PASS, EMPTY_CELL, 0, 0};
+  if (token == "X") {
+    return true;
+  }
+  int tile = 0;
+  int row = 0;
+  int col = 0;
+  char slash1 = 0;
+  char slash2 = 0;
+  std::istringstream fields(token.substr(token.empty() ? 0 : 1));
+  if (!token.empty() && token[0] == 'R' && (fields >> tile) && fields.eof()) {
+    move.type = MOVE_REPLACE;
+  } else if (!token.empty() && token[0] == 'P' &&
+             (fields >> tile >> slash1 >> row >> slash2 >> col) &&
+             slash1 == '/' && slash2 == '/' && fields.eof()) {
+    move.type = MOVE_PLACE;
+  } else {
+    return false;
+  }
+  if (tile < 1 || tile > NUM_TILE_KINDS) {
+    return false;
+  }
+  move.tile = static_cast<TileCode>(tile);
+  move.row = static_cast<int16_t>(row);
+  move.col = static_cast<int16_t>(col);
+  return true;
+}
+
+bool Trainer::decodeGame(const std::string& line, uint64_t& seed,
+                         std::vector<Move>& moves) {
+  moves.clear();
+  if (line.empty() || line[0] == '#') {
+    return false;
+  }
+  std::istringstream tokens(line);
+  if (!(tokens >> seed)) {
+    return false;
+  }
+  std::string token;
+  while (tokens >> token) {
+    Move move;
+    if (!decodeMove(token, move)) {
+      return false;
+    }
+    moves.push_back(move);
+  }
+  return true;
+}
+
+bool Trainer::writeSelfPlay(const std::string& path, const std::string& spec,
+                            int games, uint64_t seed) {
+  std::unique_ptr<Bot> probe(createBot(spec, 1));
+  if (!probe) {
+    return false;
+  }
+
+  std::vector<std::string> lines(games);
+  ThreadPool& pool = ThreadPool::shared();
+  TaskGroup group;
+  for (int g = 0; g < games; ++g) {
+    pool.submit(group, [&lines, &spec, seed, g]() {
+      uint64_t deal = seed + g;
+      std::unique_ptr<Bot> bots[2] = {
+          std::unique_ptr<Bot>(createBot(spec, deal * 2 + 1)),
+          std::unique_ptr<Bot>(createBot(spec, deal * 2 + 2))};
+      GameState state = GameState::newGame(deal);
+      std::string line = std::to_string(deal);
+      for (int turn = 0; turn < SELFPLAY_MAX_TURNS && !state.isTerminal();
+           ++turn) {
+        Move move = bots[state.toMove]->chooseMove(state);
+        line += " " + encodeMove(move);
+        state.applyMove(move);
+      }
+      lines[g] = line;
+    });
+  }
+  pool.wait(group);
+
+  std::ofstream out(path, std::ios::app);
+  for (const std::string& line : lines) {
+    out << line << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+bool Trainer::train(const std::string& path, Evaluator& evaluator,
+                    TrainStats& stats) {
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  stats.games = 0;
+  stats.positions = 0;
+
+  // Normal equations: products = X'X, targets = X'y
+  double products[EVAL_FEATURES][EVAL_FEATURES] = {{0.0}};
+  double targets[EVAL_FEATURES] = {0.0};
+  double targetSquares = 0.0;
+
+  std::string line;
+  std::vector<std::pair<int, int>> movers;
+  std::vector<float> rows;
+  std::vector<Move> moves;
+  while (std::getline(in, line)) {
+    uint64_t seed = 0;
+    if (!decodeGame(line, seed, moves)) {
+      continue;
+    }
+    GameState state = GameState::newGame(seed);
+    movers.clear();
+    rows.clear();
+    for (const Move& move : moves) {
+      float features[EVAL_FEATURES];
+      Evaluator::extractFeatures(state, features);
+      rows.insert(rows.end(), features, features + EVAL_FEATURES);
+      movers.push_back({state.toMove, state.scoreMargin(state.toMove)});
+      state.applyMove(move);
+    }
+
+    for (size_t p = 0; p < movers.size(); ++p) {
+      const float* x = &rows[p * EVAL_FEATURES];
+      double y = state.scoreMargin(movers[p].first) - movers[p].second;
+      for (int i = 0; i < EVAL_FEATURES; ++i) {
+        targets[i] += x[i] * y;
+        for (int j = 0; j < EVAL_FEATURES; ++j) {
+          products[i][j] += static_cast<double>(x[i]) * x[j];
+        }
+      }
+      targetSquares += y * y;
+    }
+    stats.games++;
+    stats.positions += static_cast<long>(movers.size());
+  }
+  if (stats.positions == 0) {
+    return false;
+  }
+
+  double before[EVAL_FEATURES];
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    before[f] = evaluator.getWeights()[f];
+  }
+  stats.errorBefore = std::sqrt(
+      squaredError(before, products, targets, targetSquares) /
+      stats.positions);
+
+  // Solve (X'X + ridge) w = X'y by Gaussian elimination with pivoting
+  double system[EVAL_FEATURES][EVAL_FEATURES + 1];
+  for (int i = 0; i < EVAL_FEATURES; ++i) {
+    for (int j = 0; j < EVAL_FEATURES; ++j) {
+      system[i][j] = products[i][j];
+    }
+    system[i][i] += TRAIN_RIDGE * stats.positions;
+    system[i][EVAL_FEATURES] = targets[i];
+  }
+  for (int col = 0; col < EVAL_FEATURES; ++col) {
+    int pivot = col;
+    for (int row = col + 1; row < EVAL_FEATURES; ++row) {
+      if (std::fabs(system[row][col]) > std::fabs(system[pivot][col])) {
+        pivot = row;
+      }
+    }
+    std::swap(system[col], system[pivot]);
+    for (int row = 0; row < EVAL_FEATURES; ++row) {
+      if (row == col) {
+        continue;
+      }
+      double factor = system[row][col] / system[col][col];
+      for (int k = col; k <= EVAL_FEATURES; ++k) {
+        system[row][k] -= factor * system[col][k];
+      }
+    }
+  }
+  double fitted[EVAL_FEATURES];
+  float weights[EVAL_FEATURES];
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    fitted[f] = system[f][EVAL_FEATURES] / system[f][f];
+    weights[f] = static_cast<float>(fitted[f]);
+  }
+  stats.errorAfter = std::sqrt(
+      squaredError(fitted, products, targets, targetSquares) /
+      stats.positions);
+  evaluator.setWeights(weights);
+  return true;
+}
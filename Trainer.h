@@ -0,0 +1,60 @@
+#ifndef ASSIGN2_TRAINER_H
+#define ASSIGN2_TRAINER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Evaluator.h"
+#include "GameState.h"
+
+// Defaults for 'qwirkle selfplay'
+#define SELFPLAY_DEFAULT_GAMES 200
+#define SELFPLAY_DEFAULT_BOT "greedy"
+
+// Turns after which a self-play game is cut off
+#define SELFPLAY_MAX_TURNS 1000
+
+// Ridge penalty keeping the fit stable when features are collinear
+#define TRAIN_RIDGE 1e-3
+
+struct TrainStats {
+  long games;
+  long positions;
+  // Root mean square error of the predicted margin change, with the
+  // weights before and after training
+  double errorBefore;
+  double errorAfter;
+};
+
+/*
+ * Self-play logs and CPU-only training for the Evaluator.
+ *
+ * A log holds one game per line: the seed of the deal, then each move as
+ * "P<tile>/<row>/<col>", "R<tile>" or "X" (pass), separated by spaces.
+ * Replaying the moves from GameState::newGame(seed) rebuilds every
+ * position exactly, so logs stay small. Lines starting with '#' are
+ * comments.
+ *
+ * Training replays every position, pairs its features with how the
+ * margin of the player to move changed by the end of the game, and fits
+ * the weights by ridge-regularised least squares.
+ */
+class Trainer {
+ public:
+  // Play 'games' games between two copies of the bot 'spec' (as for
+  // createBot) on the shared thread pool and append them to 'path'
+  static bool writeSelfPlay(const std::string& path, const std::string& spec,
+                            int games, uint64_t seed);
+
+  static bool train(const std::string& path, Evaluator& evaluator,
+                    TrainStats& stats);
+
+  static std::string encodeMove(const Move& move);
+  static bool decodeMove(const std::string& token, Move& move);
+  // One log line; false for comments, blank lines and bad moves
+  static bool decodeGame(const std::string& line, uint64_t& seed,
+                         std::vector<Move>& moves);
+};
+
+#endif  // ASSIGN2_TRAINER_H
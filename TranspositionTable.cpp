@@ -0,0 +1,200 @@
+#include "TranspositionTable.h"
+
+#include <algorithm>
+#include <climits>
+#include <new>
+
+// Set when a slot holds an entry, so packed data is never 0
+#define TABLE_USED_BIT (1ULL << 63)
+
+// Ages wrap around in the 6 bits an entry has for them
+#define TABLE_AGE_MASK 0x3F
+
+namespace {
+size_t sharedMegabytes = TABLE_DEFAULT_MB;
+}  // namespace
+
+double TableStats::hitRate() const {
+  if (probes <= 0) {
+    return 0.0;
+  }
+  return static_cast<double>(hits) / probes;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) : age(0) {
+  size_t budget = megabytes * 1024 * 1024;
+  size_t count = 1;
+  while (count * 2 * sizeof(Bucket) <= budget) {
+    count *= 2;
+  }
+  bucketMask = count - 1;
+
+  storage.reset(new char[count * sizeof(Bucket) + TABLE_CACHE_LINE]);
+  uintptr_t address = reinterpret_cast<uintptr_t>(storage.get());
+  address = (address + TABLE_CACHE_LINE - 1) &
+            ~static_cast<uintptr_t>(TABLE_CACHE_LINE - 1);
+  buckets = reinterpret_cast<Bucket*>(address);
+  for (size_t i = 0; i < count; ++i) {
+    new (&buckets[i]) Bucket();
+  }
+  clear();
+  resetStats();
+}
+
+void TranspositionTable::configureShared(size_t megabytes) {
+  sharedMegabytes = megabytes > 0 ? megabytes : 1;
+}
+
+TranspositionTable& TranspositionTable::shared() {
+  static TranspositionTable table(sharedMegabytes);
+  return table;
+}
+
+size_t TranspositionTable::capacity() const {
+  return (bucketMask + 1) * TABLE_BUCKET_SLOTS;
+}
+
+size_t TranspositionTable::memoryBytes() const {
+  return (bucketMask + 1) * sizeof(Bucket);
+}
+
+void TranspositionTable::clear() {
+  for (size_t i = 0; i <= bucketMask; ++i) {
+    for (int slot = 0; slot < TABLE_BUCKET_SLOTS; ++slot) {
+      buckets[i].checks[slot].store(0, std::memory_order_relaxed);
+      buckets[i].data[slot].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void TranspositionTable::newSearch() {
+  age.store((age.load() + 1) & TABLE_AGE_MASK);
+}
+
+TableStats TranspositionTable::getStats() const {
+  TableStats stats = {0, 0, 0, 0};
+  for (const CounterShard& shard : counters) {
+    stats.probes += shard.probes.load(std::memory_order_relaxed);
+    stats.hits += shard.hits.load(std::memory_order_relaxed);
+    stats.stores += shard.stores.load(std::memory_order_relaxed);
+    stats.collisions += shard.collisions.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void TranspositionTable::resetStats() {
+  for (CounterShard& shard : counters) {
+    shard.probes.store(0);
+    shard.hits.store(0);
+    shard.stores.store(0);
+    shard.collisions.store(0);
+  }
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucketFor(uint64_t key) {
+  return buckets[key & bucketMask];
+}
+
+TranspositionTable::CounterShard& TranspositionTable::countersFor(
+    uint64_t key) {
+  // High bits, which the bucket index does not use
+  return counters[(key >> 60) % TABLE_COUNTER_SHARDS];
+}
+
+uint64_t TranspositionTable::pack(const TableEntry& entry, uint8_t age) {
+  int value = std::min(std::max(entry.value, INT16_MIN), INT16_MAX);
+  int depth = std::min(std::max(entry.depth, 0), TABLE_MAX_DEPTH);
+  uint64_t data = static_cast<uint16_t>(static_cast<int16_t>(value));
+  data |= static_cast<uint64_t>(depth) << 16;
+  data |= static_cast<uint64_t>(entry.bound & 0x3) << 24;
+  data |= static_cast<uint64_t>(age & TABLE_AGE_MASK) << 26;
+  data |= static_cast<uint64_t>(entry.best.type & 0x3) << 32;
+  data |= static_cast<uint64_t>(entry.best.tile & 0x3F) << 34;
+  data |= static_cast<uint64_t>(entry.best.row & 0xFF) << 40;
+  data |= static_cast<uint64_t>(entry.best.col & 0xFF) << 48;
+  return data | TABLE_USED_BIT;
+}
+
+TableEntry TranspositionTable::unpack(uint64_t data) {
+  TableEntry entry;
+  entry.value = static_cast<int16_t>(data & 0xFFFF);
+  entry.depth = depthOf(data);
+  entry.bound = static_cast<TableBound>((data >> 24) & 0x3);
+  entry.best.type = static_cast<MoveType>((data >> 32) & 0x3);
+  entry.best.tile = static_cast<TileCode>((data >> 34) & 0x3F);
+  entry.best.row = static_cast<int16_t>((data >> 40) & 0xFF);
+  entry.best.col = static_cast<int16_t>((data >> 48) & 0xFF);
+  return entry;
+}
+
+int TranspositionTable::ageOf(uint64_t data) {
+  return static_cast<int>((data >> 26) & TABLE_AGE_MASK);
+}
+
+int TranspositionTable::depthOf(uint64_t data) {
+  return static_cast<int>((data >> 16) & 0xFF);
+}
+
+bool TranspositionTable::probe(uint64_t key, TableEntry& entry) {
+  Bucket& bucket = bucketFor(key);
+  CounterShard& shard = countersFor(key);
+  shard.probes.fetch_add(1, std::memory_order_relaxed);
+  for (int slot = 0; slot < TABLE_BUCKET_SLOTS; ++slot) {
+    uint64_t data = bucket.data[slot].load(std::memory_order_relaxed);
+    uint64_t check = bucket.checks[slot].load(std::memory_order_relaxed);
+    if (data != 0 && (check ^ data) == key) {
+      entry = unpack(data);
+      shard.hits.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void TranspositionTable::store(uint64_t key, const TableEntry& entry) {
+  Bucket& bucket = bucketFor(key);
+  CounterShard& shard = countersFor(key);
+  int current = age.load(std::memory_order_relaxed);
+
+  int victim = 0;
+  int victimScore = INT_MAX;
+  bool samePosition = false;
+  for (int slot = 0; slot < TABLE_BUCKET_SLOTS; ++slot) {
+    uint64_t data = bucket.data[slot].load(std::memory_order_relaxed);
+    uint64_t check = bucket.checks[slot].load(std::memory_order_relaxed);
+    if (data == 0) {
+      if (victimScore > -1) {
+        victim = slot;
+        victimScore = -1;
+      }
+      continue;
+    }
+    if ((check ^ data) == key) {
+      // Keep a deeper result for the same position from this search
+      if (ageOf(data) == current && depthOf(data) > entry.depth) {
+        return;
+      }
+      victim = slot;
+      samePosition = true;
+      break;
+    }
+    // Entries from older searches go first, then the shallowest
+    int score = depthOf(data);
+    if (ageOf(data) == current) {
+      score += TABLE_MAX_DEPTH + 1;
+    }
+    if (score < victimScore) {
+      victim = slot;
+      victimScore = score;
+    }
+  }
+
+  if (!samePosition &&
+      bucket.data[victim].load(std::memory_order_relaxed) != 0) {
+    shard.collisions.fetch_add(1, std::memory_order_relaxed);
+  }
+  uint64_t data = pack(entry, static_cast<uint8_t>(current));
+  bucket.data[victim].store(data, std::memory_order_relaxed);
+  bucket.checks[victim].store(key ^ data, std::memory_order_relaxed);
+  shard.stores.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,111 @@
+#ifndef ASSIGN2_TRANSPOSITIONTABLE_H
+#define ASSIGN2_TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "GameState.h"
+
+// Size of the shared table unless set at startup with --hash
+#define TABLE_DEFAULT_MB 64
+
+// Entries per bucket; one bucket fills one 64-byte cache line
+#define TABLE_BUCKET_SLOTS 4
+#define TABLE_CACHE_LINE 64
+
+// Deepest depth an entry can record
+#define TABLE_MAX_DEPTH 255
+
+// Counters are spread over this many cache lines so threads rarely
+// share one
+#define TABLE_COUNTER_SHARDS 16
+
+enum TableBound : uint8_t { BOUND_EXACT, BOUND_LOWER, BOUND_UPPER };
+
+struct TableEntry {
+  // Stored in 16 bits
+  int value;
+  // 0 to TABLE_MAX_DEPTH
+  int depth;
+  TableBound bound;
+  Move best;
+};
+
+struct TableStats {
+  long probes;
+  long hits;
+  long stores;
+  // Stores that evicted an entry for a different position
+  long collisions;
+
+  double hitRate() const;
+};
+
+/*
+ * Fixed-size transposition table shared by search threads without locks.
+ * Each entry is a 64-bit key check and a 64-bit packed entry, written
+ * with relaxed atomics; the check holds key ^ data, so an entry torn by
+ * two racing writers fails the check and reads as a miss. Four entries
+ * make a cache-line-aligned bucket. On a store, the same position is
+ * overwritten if the new entry is at least as deep, and otherwise the
+ * victim is an empty slot, then an entry from an older search, then the
+ * shallowest entry.
+ */
+class TranspositionTable {
+ public:
+  explicit TranspositionTable(size_t megabytes);
+
+  TranspositionTable(const TranspositionTable& other) = delete;
+  TranspositionTable& operator=(const TranspositionTable& other) = delete;
+
+  // Size of the shared table; only takes effect before its first use
+  static void configureShared(size_t megabytes);
+
+  // Engine-wide table, created on first use
+  static TranspositionTable& shared();
+
+  bool probe(uint64_t key, TableEntry& entry);
+  void store(uint64_t key, const TableEntry& entry);
+
+  // Start a new search: older entries become the first to be replaced
+  void newSearch();
+  void clear();
+
+  size_t capacity() const;
+  size_t memoryBytes() const;
+
+  TableStats getStats() const;
+  void resetStats();
+
+ private:
+  struct alignas(TABLE_CACHE_LINE) Bucket {
+    std::atomic<uint64_t> checks[TABLE_BUCKET_SLOTS];
+    std::atomic<uint64_t> data[TABLE_BUCKET_SLOTS];
+  };
+
+  struct alignas(TABLE_CACHE_LINE) CounterShard {
+    std::atomic<long> probes;
+    std::atomic<long> hits;
+    std::atomic<long> stores;
+    std::atomic<long> collisions;
+  };
+
+  // Raw allocation, since plain new does not honour cache-line alignment
+  // before C++17
+  std::unique_ptr<char[]> storage;
+  Bucket* buckets;
+  size_t bucketMask;
+  std::atomic<uint8_t> age;
+  CounterShard counters[TABLE_COUNTER_SHARDS];
+
+  Bucket& bucketFor(uint64_t key);
+  CounterShard& countersFor(uint64_t key);
+  static uint64_t pack(const TableEntry& entry, uint8_t age);
+  static TableEntry unpack(uint64_t data);
+  static int ageOf(uint64_t data);
+  static int depthOf(uint64_t data);
+};
+
+#endif  // ASSIGN2_TRANSPOSITIONTABLE_H
@@ -1,27 +1,72 @@
+#include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
+#include "EndgameSolver.h"
+#include "Evaluator.h"
+#include "BackgroundSaver.h"
+#include "BulkLoader.h"
+#include "CommandParser.h"
 #include "FileHandler.h"
+#include "GameArchive.h"
+#include "GameLog.h"
 #include "GameBoard.h"
+#include "GameEngine.h"
+#include "GameState.h"
+#include "HandTable.h"
+#include "HintSearch.h"
 #include "InputValidator.h"
 #include "LinkedList.h"
+#include "LockstepSimulator.h"
+#include "MctsBot.h"
+#include "OpeningBook.h"
+#include "ParallelMcts.h"
+#include "PositionBatch.h"
 #include "Player.h"
 #include "Rules.h"
 #include "Student.h"
 #include "StudentInfo.h"
 #include "Tests.cpp"
+#include "ThreadPool.h"
+#include "Tournament.h"
+#include "Trainer.h"
+#include "TranspositionTable.h"
 #include "Tile.h"
 #include "TileBag.h"
 
 #define EXIT_SUCCESS 0
-#define NUM_BOARD_ROWS 26
-#define NUM_BOARD_COLS 26
-#define STARTING_HAND_SIZE 6
+
+// Set by --analysis: show the solved outcome once the bag is empty
+bool showEndgameAnalysis = false;
+
+// Set by --script: commands come from this file instead of the terminal
+std::istream *commandInput = &std::cin;
+// Set by --quiet and --digest: std::cout is silenced and boards are not
+// rendered
+bool quietOutput = false;
+// Set by --digest: print a digest of the final state of every game
+bool printDigest = false;
+// The real standard output, still reachable while std::cout is silenced
+std::streambuf *terminalOutput = nullptr;
+
+// Set by --binary: every save uses the binary format, not only .qwb files
+bool binarySaves = false;
+
+// Set by --crop: boards show only the played area and a margin around it
+bool croppedBoards = false;
+
+// Set by --log: every game played is recorded to this file
+std::string logPath;
+// Set by 'resume': the game continues the log instead of starting it
+bool resumingLog = false;
 
 // Function prototypes
 void displayWelcomeMessage();
@@ -31,28 +76,173 @@ void loadGame(bool &quit, bool enhanced);
 void showCredits();
 void handleMenuChoice(int choice, bool &quit, unsigned int randSeed,
                       bool enhanced);
-void playTurn(Player *player, Player *opponent, TileBag *tileBag,
-              GameBoard *board, bool &quit, bool enhanced);
-void gameLoop(Player *player1, Player *player2, TileBag *tileBag,
-              GameBoard *board, bool enhanced);
-void printScores(Player *player1, Player *player2, TileBag *tileBag,
-                 GameBoard *GameBoard, bool &quit, bool enhanced);
+void playTurn(GameEngine &engine, bool &quit);
+void gameLoop(GameEngine &engine);
+void printScores(GameEngine &engine, bool &quit);
 std::string handleInput(bool &quit);
 bool chooseVersion();
-void handleEnhancedPlayerTurn(Player *currentPlayer, Player *otherPlayer,
-                              TileBag *tileBag, GameBoard *gameBoard,
-                              bool &quit, bool enhanced);
+void showHint(GameEngine &engine, int deadlineMs);
+std::string renderBoard(GameEngine &engine);
+void printEndgameAnalysis(GameEngine &engine);
+void reportFinishedSaves();
+int runMctsAnalysis(int argc, char **argv);
+int runParallelMctsAnalysis(int argc, char **argv);
+int runPoolBenchmark(int argc, char **argv);
+int runBatchBenchmark(int argc, char **argv);
+int runLockstepSimulation(int argc, char **argv);
+int runResume(int argc, char **argv);
+int runTournament(int argc, char **argv);
+int runEndgameSolver(int argc, char **argv);
+int runBookBuilder(int argc, char **argv);
+int runHandTableBuilder(int argc, char **argv);
+int runSelfPlay(int argc, char **argv);
+int runTraining(int argc, char **argv);
+int runArchiveBuilder(int argc, char **argv);
+int runLogArchiver(int argc, char **argv);
+int runArchiveScan(int argc, char **argv);
+int runBulkLoad(int argc, char **argv, bool convert);
 
 int main(int argc, char **argv) {
   bool quit = false;
   int randSeed = (unsigned int)time(NULL);
 
+  // Global options may come anywhere; strip them before the commands
+  std::vector<char *> args;
+  std::ifstream script;
+  for (int i = 0; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--analysis") {
+      showEndgameAnalysis = true;
+    } else if (arg == "--log" && i + 1 < argc) {
+      logPath = argv[++i];
+    } else if (arg == "--binary") {
+      binarySaves = true;
+    } else if (arg == "--crop") {
+      croppedBoards = true;
+    } else if (arg == "--quiet") {
+      quietOutput = true;
+    } else if (arg == "--digest") {
+      quietOutput = true;
+      printDigest = true;
+    } else if (arg == "--script" && i + 1 < argc) {
+      std::string path = argv[++i];
+      script.open(path);
+      if (!script) {
+        std::cerr << "Error: Unable to open script " << path << std::endl;
+        return 1;
+      }
+      commandInput = &script;
+    } else if (arg == "--hash" && i + 1 < argc) {
+      size_t megabytes = std::strtoul(argv[++i], nullptr, 10);
+      TranspositionTable::configureShared(megabytes);
+    } else if (arg == "--hands" && i + 1 < argc) {
+      std::string path = argv[++i];
+      if (!HandTable::shared().open(path)) {
+        std::cerr << "Error: Unable to open hand table " << path << std::endl;
+        return 1;
+      }
+    } else if (arg == "--eval" && i + 1 < argc) {
+      std::string path = argv[++i];
+      if (!Evaluator::shared().load(path)) {
+        std::cerr << "Error: Unable to load evaluation weights " << path
+                  << std::endl;
+        return 1;
+      }
+    } else if (arg == "--book" && i + 1 < argc) {
+      std::string path = argv[++i];
+      if (!OpeningBook::shared().open(path)) {
+        std::cerr << "Error: Unable to open opening book " << path
+                  << std::endl;
+        return 1;
+      }
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  argc = static_cast<int>(args.size());
+  argv = args.data();
+
+  // A stream without a buffer fails every write at once, so nothing is
+  // formatted or flushed
+  terminalOutput = std::cout.rdbuf();
+  if (quietOutput) {
+    std::cout.rdbuf(nullptr);
+  }
+
   if (argc > 1) {
     if (std::string(argv[1]) == "test") {
       // run unit tetsts
       Tests::run();
       return EXIT_SUCCESS;
     }
+    if (std::string(argv[1]) == "mcts") {
+      // qwirkle mcts <savefile> [iterations] [timeMs]
+      return runMctsAnalysis(argc, argv);
+    }
+    if (std::string(argv[1]) == "pmcts") {
+      // qwirkle pmcts <savefile> [threads] [timeMs]
+      return runParallelMctsAnalysis(argc, argv);
+    }
+    if (std::string(argv[1]) == "bench-pool") {
+      // qwirkle bench-pool [tasks] [workPerTask]
+      return runPoolBenchmark(argc, argv);
+    }
+    if (std::string(argv[1]) == "bench-batch") {
+      // qwirkle bench-batch [positions] [rounds]
+      return runBatchBenchmark(argc, argv);
+    }
+    if (std::string(argv[1]) == "simulate") {
+      // qwirkle simulate [games] [seed]
+      return runLockstepSimulation(argc, argv);
+    }
+    if (std::string(argv[1]) == "resume") {
+      // qwirkle resume <logfile>
+      return runResume(argc, argv);
+    }
+    if (std::string(argv[1]) == "tournament") {
+      // qwirkle tournament [--swiss] [--rounds N] [--seed S] <bot> <bot>...
+      return runTournament(argc, argv);
+    }
+    if (std::string(argv[1]) == "solve") {
+      // qwirkle solve <savefile> [bonus] [timeMs]
+      return runEndgameSolver(argc, argv);
+    }
+    if (std::string(argv[1]) == "selfplay") {
+      // qwirkle selfplay <logfile> [games] [bot] [seed]
+      return runSelfPlay(argc, argv);
+    }
+    if (std::string(argv[1]) == "train") {
+      // qwirkle train <logfile> <weightsfile>
+      return runTraining(argc, argv);
+    }
+    if (std::string(argv[1]) == "archive") {
+      // qwirkle archive <archivefile> <logfile> [name1] [name2]
+      return runArchiveBuilder(argc, argv);
+    }
+    if (std::string(argv[1]) == "archive-logs") {
+      // qwirkle archive-logs <archivefile> <gamelog>...
+      return runLogArchiver(argc, argv);
+    }
+    if (std::string(argv[1]) == "archive-scan") {
+      // qwirkle archive-scan <archivefile> [gameid]
+      return runArchiveScan(argc, argv);
+    }
+    if (std::string(argv[1]) == "validate") {
+      // qwirkle validate <path>...
+      return runBulkLoad(argc, argv, false);
+    }
+    if (std::string(argv[1]) == "convert") {
+      // qwirkle convert <text|binary> <path>...
+      return runBulkLoad(argc, argv, true);
+    }
+    if (std::string(argv[1]) == "hands") {
+      // qwirkle hands <outfile>
+      return runHandTableBuilder(argc, argv);
+    }
+    if (std::string(argv[1]) == "book") {
+      // qwirkle book <outfile> [games] [plies] [iterations]
+      return runBookBuilder(argc, argv);
+    }
     if (std::string(argv[1]) == "e2etest") {
       randSeed = 0;
     }
@@ -118,7 +308,7 @@ bool chooseVersion() {
     std::cout << "2. Enhanced Qwirkle" << std::endl;
     std::cout << "> ";
 
-    std::getline(std::cin, versionChoice);
+    std::getline(*commandInput, versionChoice);
 
     if (versionChoice == "1") {
       isEnhanced = false;  // Base Qwirkle
@@ -161,23 +351,13 @@ void startNewGame(bool &quit, unsigned int randSeed, bool enhanced) {
     player2Name = handleInput(quit);
   }
 
-  Player player1(player1Name);
-  Player player2(player2Name);
-
-  GameBoard gameBoard(NUM_BOARD_ROWS, NUM_BOARD_COLS);
-
-  TileBag tileBag;
-  // Shuffle the tile bag
-  tileBag.shuffle(randSeed);
+  GameEngine engine(enhanced);
+  engine.newGame(player1Name, player2Name, randSeed);
 
   std::cout << "Let's Play!" << std::endl;
 
-  // Draws 6 tiles for each player to start the game
-  player1.drawQuantityTiles(&tileBag, STARTING_HAND_SIZE);
-  player2.drawQuantityTiles(&tileBag, STARTING_HAND_SIZE);
-
   // Primary functions used to run recursive gameplay operations
-  gameLoop(&player1, &player2, &tileBag, &gameBoard, enhanced);
+  gameLoop(engine);
 }
 
 void loadGame(bool &quit, bool enhanced) {
@@ -190,290 +370,196 @@ void loadGame(bool &quit, bool enhanced) {
     return;
   }
 
-  FileHandler fileHandler;
-
-  if (!fileHandler.fileExists(filename)) {
+  if (!FileHandler::fileExists(filename)) {
     std::cerr << "Error: File does not exist." << std::endl;
     return;
   }
 
-  // Load the game state
-  Player *loadedPlayer1 = new Player("Temp1");
-  Player *loadedPlayer2 = new Player("Temp2");
-  TileBag *loadedTileBag = new TileBag();
-  GameBoard *loadedBoard = new GameBoard();
-  Player *currentPlayer = new Player("Current");
-
-  bool gameLoaded =
-      fileHandler.loadGame(filename, loadedPlayer1, loadedPlayer2,
-                           loadedTileBag, loadedBoard, currentPlayer);
-
-  if (!gameLoaded) {
+  GameEngine engine(enhanced);
+  if (!engine.load(filename)) {
+    if (!engine.lastError().empty()) {
+      std::cerr << engine.lastError() << std::endl;
+    }
     std::cerr << "Error: Invalid file format." << std::endl;
   } else {
     std::cout << "Qwirkle game successfully loaded" << std::endl;
-
-    if (currentPlayer->getName() == loadedPlayer1->getName()) {
-      gameLoop(loadedPlayer1, loadedPlayer2, loadedTileBag, loadedBoard,
-               enhanced);
-    } else {
-      gameLoop(loadedPlayer2, loadedPlayer1, loadedTileBag, loadedBoard,
-               enhanced);
-    }
+    gameLoop(engine);
   }
-
-  delete loadedPlayer1;
-  delete loadedPlayer2;
-  delete loadedTileBag;
-  delete loadedBoard;
-  delete currentPlayer;
 }
 
-void playTurn(Player *player, Player *opponent, TileBag *tileBag,
-              GameBoard *gameBoard, bool &quit, bool enhanced) {
+// Read and run commands until the current player's turn ends or they quit
+void playTurn(GameEngine &engine, bool &quit) {
+  bool enhanced = engine.isEnhanced();
   bool validInput = false;
   while (!validInput && !quit) {
-    std::cout << gameBoard->displayBoard(enhanced) << std::endl;
-    std::cout << "Tiles in hand: " << player->getHand()->toString(enhanced)
-              << std::endl;
-    std::cout << "Your move " << player->getName() << ": ";
+    Player *player = engine.currentPlayer();
+    if (!quietOutput) {
+      std::cout << renderBoard(engine) << std::endl;
+      std::cout << "Tiles in hand: " << player->getHand()->toString(enhanced)
+                << std::endl;
+      std::cout << "Your move " << player->getName() << ": ";
+    }
     std::string playerMove = handleInput(quit);
+    Command command;
+    if (!quit && !CommandParser::parse(playerMove, enhanced, command)) {
+      std::cout << command.error << std::endl;
+      continue;
+    }
 
-    if (playerMove == "quit" || quit) {
+    if (quit || command.verb == VERB_QUIT) {
       quit = true;
-    } else if (playerMove == "save") {
-      // Implement save game logic
+    } else if (command.verb == VERB_SAVE) {
       std::cout << "Enter filename to save: ";
       std::string filename = handleInput(quit);
-
-      FileHandler fileHandler;
-      fileHandler.saveGame(filename, player, opponent, tileBag, gameBoard,
-                           player);
-      std::cout << "Game saved to " << filename << std::endl;
-    } else if (playerMove.substr(0, 7) == "replace") {
-      std::string tileToReplace = playerMove.substr(8);
-      // Ensure input is valid
-      if (tileToReplace.size() == 2) {
-        char colour = tileToReplace[0];
-        int shape = tileToReplace[1] - '0';
-        Tile *tile = new Tile(colour, shape);
-        Tile *removedTile = player->removeTileFromHand(tile);
-        if (removedTile != nullptr) {
-          std::cout << removedTile->print()
-                    << " tile removed from hand and added to the bag."
-                    << std::endl;
-          delete removedTile;
-          tileBag->addTile(tile);
-          Tile *newTile = tileBag->drawTile();
-          if (newTile != nullptr) {
-            player->addTileToHand(newTile);
-            std::cout << newTile->print()
-                      << " tile drawn and added to your hand." << std::endl;
-          } else {
-            std::cout << "No tiles left to draw from the tile bag."
-                      << std::endl;
-          }
-          validInput = true;
+      SaveFormat format =
+          binarySaves ? SAVE_BINARY : FileHandler::formatFor(filename);
+      // The write happens on the saver thread; reportFinishedSaves says
+      // how it went
+      if (engine.saveInBackground(filename, format).status == COMMAND_OK) {
+        std::cout << "Game save queued to " << filename << std::endl;
+      } else {
+        std::cerr << engine.lastError() << std::endl;
+      }
+    } else if (command.verb == VERB_HINT) {
+      showHint(engine, command.hintMs > 0 ? command.hintMs : HINT_DEFAULT_MS);
+    } else if (command.verb == VERB_PASS) {
+      // Draw tiles for all placed tiles, if any, after passing the turn
+      CommandResult passed = engine.pass();
+      for (int i = 0; i < passed.undrawn; ++i) {
+        std::cout << "No tiles left to draw from the tile bag." << std::endl;
+      }
+      validInput = true;
+    } else if (command.verb == VERB_REPLACE) {
+      CommandResult replaced = engine.replace(command.colour, command.shape);
+      if (replaced.status == COMMAND_OK) {
+        std::cout << Tile(command.colour, command.shape).print()
+                  << " tile removed from hand and added to the bag."
+                  << std::endl;
+        if (replaced.drawn != EMPTY_CELL) {
+          std::cout << GameState::tileToString(replaced.drawn)
+                    << " tile drawn and added to your hand." << std::endl;
         } else {
-          std::cout << "You don't have that tile in your hand." << std::endl;
+          std::cout << "No tiles left to draw from the tile bag."
+                    << std::endl;
         }
+        validInput = replaced.turnEnded;
       } else {
-        std::cout << "Invalid tile format. Use <colour><shape>." << std::endl;
+        std::cout << "Error: Failed to remove tile from hand." << std::endl;
+        std::cout << "You don't have that tile in your hand." << std::endl;
       }
     } else {
-      std::stringstream stringstream(playerMove);
-      std::string extractedWord;
-      std::vector<std::string> moveBreakdown;
-
-      while (stringstream >> extractedWord) {
-        moveBreakdown.push_back(extractedWord);
-      }
-
-      if (moveBreakdown.size() == 4 && moveBreakdown[0] == "place" &&
-          moveBreakdown[2] == "at") {
-        char tileColour = moveBreakdown[1][0];
-        int tileShape = moveBreakdown[1][1] - '0';
-        char rowChar = moveBreakdown[3][0];
-        int col = std::stoi(moveBreakdown[3].substr(1));
-
-        int row = rowChar - 'A';
-
-        Tile *tile = new Tile(tileColour, tileShape);
-
-        // Checks if the tile exists in the player's hand
-        if (player->containsTile(tile)) {
-          if (Rules::validateMove(gameBoard, tile, row, col)) {
-            gameBoard->placeTile(row, col, tile);
-            Tile *removedTile = player->removeTileFromHand(tile);
-            if (removedTile != nullptr) {
-              delete removedTile;
-              Tile *newTile = tileBag->drawTile();
-              if (newTile != nullptr) {
-                player->addTileToHand(newTile);
-              }
-              int score = Rules::calculateScore(gameBoard, row, col);
-              player->setScore(player->getScore() + score);
-              if (score > 6) {
-                std::cout << "QWIRKLE!!!" << std::endl;
-              }
-              validInput = true;
-            } else {
-              std::cout << "Error: Failed to remove tile from hand."
-                        << std::endl;
-            }
-          } else {
-            std::cout << "Invalid move. Try again." << std::endl;
-            delete tile;
-          }
-        } else {
-          std::cout << "You don't have that tile in your hand." << std::endl;
-          delete tile;
+      CommandResult placed =
+          engine.placeAll(command.placements, command.placementCount);
+      if (placed.status == COMMAND_OK) {
+        for (int i = 0; i < placed.qwirkles; ++i) {
+          std::cout << "QWIRKLE!!!" << std::endl;
         }
+        validInput = placed.turnEnded;
+      } else if (placed.status == COMMAND_ILLEGAL) {
+        std::cout << "Invalid move. Try again." << std::endl;
       } else {
-        std::cout << "Invalid move format. Use 'place <tile> at <position>'."
-                  << std::endl;
+        std::cout << "You don't have that tile in your hand." << std::endl;
       }
     }
   }
 }
 
-void handleEnhancedPlayerTurn(Player *player, Player *opponent,
-                              TileBag *tileBag, GameBoard *gameBoard,
-                              bool &quit, bool enhanced) {
-  bool validInput = false;
-  bool tilesLeft = true;  // Flag to track if there are tiles left in the bag
-  std::vector<Tile *> placedTiles;  // Track tiles placed during the turn
+// The whole board, or with --crop only the played area
+std::string renderBoard(GameEngine &engine) {
+  GameBoard *board = engine.board();
+  if (croppedBoards) {
+    return board->displayBoard(engine.isEnhanced(),
+                               board->occupiedView(BOARD_VIEW_MARGIN));
+  }
+  return board->displayBoard(engine.isEnhanced());
+}
 
-  while (!validInput && !quit && tilesLeft) {
-    std::cout << gameBoard->displayBoard(enhanced) << std::endl;
-    std::cout << "Tiles in hand: " << player->getHand()->toString(enhanced)
+// Suggest a move for the current player: "hint" or "hint <milliseconds>"
+void showHint(GameEngine &engine, int deadlineMs) {
+  GameState state = engine.snapshot();
+  HintSearch search(deadlineMs, static_cast<uint64_t>(time(NULL)));
+  HintResult hint = search.search(state);
+  if (hint.fromBook) {
+    std::cout << "Hint: " << hint.move.toCommand() << " (opening book)"
               << std::endl;
-    std::cout << "Your move " << player->getName() << ": ";
-    std::string playerMove = handleInput(quit);
-
-    if (playerMove == "quit" || quit) {
-      quit = true;
-    } else if (playerMove == "save") {
-      std::cout << "Enter filename to save: ";
-      std::string filename = handleInput(quit);
-      FileHandler fileHandler;
-      fileHandler.saveGame(filename, player, opponent, tileBag, gameBoard,
-                           player);
-      std::cout << "Game saved to " << filename << std::endl;
-    } else if (playerMove == "pass") {
-      // Draw tiles for all placed tiles, if any, after passing the turn
-      for (size_t i = 0; i < placedTiles.size(); ++i) {
-        Tile *newTile = tileBag->drawTile();
-        if (newTile != nullptr) {
-          player->addTileToHand(newTile);
-        } else {
-          std::cout << "No tiles left to draw from the tile bag." << std::endl;
-          tilesLeft = false;  // Set flag to false to stop drawing tiles
-        }
-      }
-      placedTiles.clear();  // Clear placed tiles after processing
-      validInput = true;    // End the loop and the turn
-    } else if (playerMove.substr(0, 7) == "replace") {
-      std::string tileToReplace = playerMove.substr(8);
-      if (tileToReplace.size() == 2) {
-        char colour = tileToReplace[0];
-        int shape = tileToReplace[1] - '0';
-        Tile *tile = new Tile(colour, shape);
-        Tile *removedTile = player->removeTileFromHand(tile);
-        if (removedTile != nullptr) {
-          std::cout << removedTile->print()
-                    << " tile removed from hand and added to the bag."
-                    << std::endl;
-          delete removedTile;
-          tileBag->addTile(tile);
-          Tile *newTile = tileBag->drawTile();
-          if (newTile != nullptr) {
-            player->addTileToHand(newTile);
-            std::cout << newTile->print()
-                      << " tile drawn and added to your hand." << std::endl;
-          } else {
-            std::cout << "No tiles left to draw from the tile bag."
-                      << std::endl;
-            tilesLeft = false;  // Set flag to false to stop drawing tiles
-          }
-        } else {
-          std::cout << "You don't have that tile in your hand." << std::endl;
-        }
-      } else {
-        std::cout << "Invalid tile format. Use <colour><shape>." << std::endl;
-      }
-    } else {
-      std::stringstream stringstream(playerMove);
-      std::string extractedWord;
-      std::vector<std::string> moveBreakdown;
+    return;
+  }
+  std::cout << "Hint: " << hint.move.toCommand() << " (depth " << hint.depth
+            << ", " << hint.nodes << " positions, " << hint.elapsedMs
+            << " ms)" << std::endl;
+}
 
-      while (stringstream >> extractedWord) {
-        moveBreakdown.push_back(extractedWord);
-      }
+// Exact result of the rest of the game, once the bag is empty. Scored
+// like the game loop, so without a finishing bonus.
+void printEndgameAnalysis(GameEngine &engine) {
+  GameState state = engine.snapshot();
+  if (!EndgameSolver::applies(state)) {
+    return;
+  }
+  EndgameConfig config;
+  config.finishingBonus = 0;
+  EndgameSolver solver(config);
+  EndgameResult result = solver.solve(state);
+  if (!result.solved) {
+    std::cout << "Endgame: not solved within " << config.timeLimitMs << " ms"
+              << std::endl;
+    return;
+  }
+  if (!result.lineComplete) {
+    std::cout << "Endgame with best play: " << engine.currentPlayer()->getName()
+              << " margin " << result.margin
+              << " (best move: " << result.move.toCommand() << ")" << std::endl;
+    return;
+  }
+  std::cout << "Endgame with best play: " << engine.currentPlayer()->getName()
+            << " " << result.finalScores[0] << ", "
+            << engine.opponent()->getName() << " " << result.finalScores[1]
+            << " (best move: " << result.move.toCommand() << ")" << std::endl;
+}
 
-      if (moveBreakdown.size() == 4 && moveBreakdown[0] == "place" &&
-          moveBreakdown[2] == "at") {
-        char tileColour = moveBreakdown[1][0];
-        int tileShape = moveBreakdown[1][1] - '0';
-        char rowChar = moveBreakdown[3][0];
-        int col = std::stoi(moveBreakdown[3].substr(1));
-        int row = rowChar - 'A';
-
-        Tile *tile = new Tile(tileColour, tileShape);
-
-        // Check if the tile exists in the player's hand
-        if (player->containsTile(tile)) {
-          if (Rules::validateMove(gameBoard, tile, row, col)) {
-            gameBoard->placeTile(row, col, tile);
-            Tile *removedTile = player->removeTileFromHand(tile);
-            if (removedTile != nullptr) {
-              placedTiles.push_back(removedTile);  // Track placed tile
-              int score = Rules::calculateScore(gameBoard, row, col);
-              player->setScore(player->getScore() + score);
-              if (score > 6) {
-                std::cout << "QWIRKLE!!!" << std::endl;
-              }
-            } else {
-              std::cout << "Error: Failed to remove tile from hand."
-                        << std::endl;
-            }
-          } else {
-            std::cout << "Invalid move. Try again." << std::endl;
-          }
-        } else {
-          std::cout << "You don't have that tile in your hand." << std::endl;
-        }
-      } else {
-        std::cout << "Invalid move format. Use 'place <tile> at <position>', 'replace <tile>', or 'pass'."
-                  << std::endl;
-      }
+void gameLoop(GameEngine &engine) {
+  // A resumed game keeps appending to the log it was rebuilt from
+  GameLog log;
+  if (!logPath.empty()) {
+    bool opened =
+        resumingLog ? log.resume(logPath) : log.start(logPath, engine);
+    if (opened) {
+      engine.setLog(&log);
+    } else {
+      std::cerr << log.lastError() << std::endl;
     }
   }
-}
 
-void gameLoop(Player *player1, Player *player2, TileBag *tileBag,
-              GameBoard *gameBoard, bool enhanced) {
   bool quit = false;
   while (!quit) {
-    printScores(player1, player2, tileBag, gameBoard, quit, enhanced);
-
-    // Check the enhanced mode and call the appropriate turn handler
-    if (enhanced) {
-      handleEnhancedPlayerTurn(player1, player2, tileBag, gameBoard, quit,
-                               enhanced);
-    } else {
-      playTurn(player1, player2, tileBag, gameBoard, quit, enhanced);
+    reportFinishedSaves();
+    printScores(engine, quit);
+    if (!quit && showEndgameAnalysis) {
+      printEndgameAnalysis(engine);
     }
-
     if (!quit) {
-      printScores(player1, player2, tileBag, gameBoard, quit, enhanced);
+      playTurn(engine, quit);
+    }
+  }
+  BackgroundSaver::shared().flush();
+  reportFinishedSaves();
+  if (printDigest) {
+    std::ostream out(terminalOutput);
+    out << "Digest: " << std::hex << std::setw(16) << std::setfill('0')
+        << engine.digest() << std::endl;
+  }
+  engine.setLog(nullptr);
+}
 
-      if (enhanced) {
-        handleEnhancedPlayerTurn(player2, player1, tileBag, gameBoard, quit,
-                                 enhanced);
-      } else {
-        playTurn(player2, player1, tileBag, gameBoard, quit, enhanced);
-      }
+// Saves are written in the background, so each is reported once its write
+// has finished: at the start of a later turn, or when the game ends
+void reportFinishedSaves() {
+  for (const SaveCompletion &save : BackgroundSaver::shared().takeFinished()) {
+    if (save.ok) {
+      std::cout << "Game saved to " << save.path << std::endl;
+    } else {
+      std::cerr << "Error: Game not saved to " << save.path << std::endl;
+      std::cerr << save.error << std::endl;
     }
   }
 }
@@ -501,12 +587,14 @@ void handleMenuChoice(int choice, bool &quit, unsigned int randSeed,
   }
 }
 
-void printScores(Player *player1, Player *player2, TileBag *tileBag,
-                 GameBoard *gameBoard, bool &quit, bool enhanced) {
-  if (Rules::isGameOver(player1, player2, tileBag)) {
-    std::cout << gameBoard->displayBoard(enhanced) << std::endl;
-    Player *winner =
-        player1->getScore() > player2->getScore() ? player1 : player2;
+void printScores(GameEngine &engine, bool &quit) {
+  Player *player1 = engine.player(0);
+  Player *player2 = engine.player(1);
+  if (engine.isGameOver()) {
+    if (!quietOutput) {
+      std::cout << renderBoard(engine) << std::endl;
+    }
+    Player *winner = engine.winner();
     std::cout << "\nGame over!" << std::endl;
     std::cout << "The winner is " << winner->getName() << " with a score of "
               << winner->getScore() << "!\n"
@@ -524,12 +612,693 @@ void printScores(Player *player1, Player *player2, TileBag *tileBag,
 
 std::string handleInput(bool &quit) {
   std::string input;
-  std::getline(std::cin, input);
+  std::getline(*commandInput, input);
   std::cout << std::endl;
 
   // Check for EOF
-  if (std::cin.eof()) {
+  if (commandInput->eof()) {
     quit = true;
   }
   return input;
 }
+
+// Load a saved game into a compact GameState for the analysis commands
+bool loadAnalysisState(const std::string &filename, GameState &state,
+                       std::string &moverName) {
+  GameEngine engine(false);
+  if (!FileHandler::fileExists(filename) || !engine.load(filename)) {
+    std::cerr << "Error: Unable to load " << filename << std::endl;
+    if (!engine.lastError().empty()) {
+      std::cerr << engine.lastError() << std::endl;
+    }
+    return false;
+  }
+  state = engine.snapshot();
+  moverName = engine.currentPlayer()->getName();
+  return true;
+}
+
+void printSearchStats(const SearchStats &stats) {
+  std::cout << "Iterations: " << stats.iterations
+            << ", tree nodes: " << stats.treeNodes
+            << ", time: " << stats.elapsedMs << " ms"
+            << ", nodes/s: " << static_cast<long>(stats.nodesPerSecond())
+            << std::endl;
+}
+
+// Load a saved game and print the move the MCTS bot would play
+int runMctsAnalysis(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle mcts <savefile> [iterations] [timeMs]"
+              << std::endl;
+    return 1;
+  }
+
+  MctsConfig config;
+  if (argc > 3) {
+    config.iterations = std::atoi(argv[3]);
+  }
+  if (argc > 4) {
+    config.timeBudgetMs = std::atoi(argv[4]);
+  }
+
+  GameState state;
+  std::string moverName;
+  if (!loadAnalysisState(argv[2], state, moverName)) {
+    return 1;
+  }
+
+  MctsBot bot(config);
+  Move move = bot.chooseMove(state);
+  std::cout << "Best move for " << moverName << ": " << move.toCommand()
+            << std::endl;
+  printSearchStats(bot.getStats());
+  return EXIT_SUCCESS;
+}
+
+// Multi-threaded search on a saved game, with a scaling report
+int runParallelMctsAnalysis(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle pmcts <savefile> [threads] [timeMs]"
+              << std::endl;
+    return 1;
+  }
+
+  int threads = static_cast<int>(std::thread::hardware_concurrency());
+  MctsConfig config;
+  config.iterations = 0;
+  if (argc > 3) {
+    threads = std::atoi(argv[3]);
+  }
+  if (argc > 4) {
+    config.timeBudgetMs = std::atoi(argv[4]);
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  GameState state;
+  std::string moverName;
+  if (!loadAnalysisState(argv[2], state, moverName)) {
+    return 1;
+  }
+
+  ParallelMcts search(config, threads);
+  Move move = search.chooseMove(state);
+  std::cout << "Best move for " << moverName << ": " << move.toCommand()
+            << std::endl;
+  printSearchStats(search.getStats());
+
+  ScalingReport report = ParallelMcts::measureScaling(state, config, threads);
+  std::cout << "Scaling with " << report.threads << " threads: "
+            << static_cast<long>(report.singleThreadRate) << " -> "
+            << static_cast<long>(report.multiThreadRate)
+            << " iterations/s, speedup " << report.speedup()
+            << ", efficiency " << report.efficiency() * 100 << "%"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Measure the scheduling cost of the shared pool on very small tasks
+int runPoolBenchmark(int argc, char **argv) {
+  int tasks = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  int work = argc > 3 ? std::atoi(argv[3]) : 100;
+  if (tasks < 1 || work < 0) {
+    std::cerr << "Usage: qwirkle bench-pool [tasks] [workPerTask]"
+              << std::endl;
+    return 1;
+  }
+
+  ThreadPool &pool = ThreadPool::shared();
+  PoolBenchmark result = pool.measureOverhead(tasks, work);
+  std::cout << "Workers: " << pool.size() << ", tasks: " << result.tasks
+            << std::endl;
+  std::cout << "Serial loop: " << result.serialMs << " ms ("
+            << result.serialMs * 1e6 / result.tasks << " ns/task)"
+            << std::endl;
+  std::cout << "Thread pool: " << result.parallelMs << " ms ("
+            << result.parallelMs * 1e6 / result.tasks << " ns/task)"
+            << std::endl;
+  std::cout << "Overhead: " << result.overheadNsPerTask() << " ns/task"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Play bot configurations against each other and print a rating table
+int runTournament(int argc, char **argv) {
+  TournamentConfig config;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--swiss") {
+      config.pairing = PAIRING_SWISS;
+    } else if (arg == "--rounds" && i + 1 < argc) {
+      config.rounds = std::atoi(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      config.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      config.bots.push_back(arg);
+    }
+  }
+  if (config.bots.size() < 2 || config.rounds < 1) {
+    std::cerr << "Usage: qwirkle tournament [--swiss] [--rounds N] "
+                 "[--seed S] <bot> <bot>..."
+              << std::endl;
+    std::cerr << "Bots: random, greedy, mcts[:iterations=N][,time=MS][,c=X]"
+              << std::endl;
+    return 1;
+  }
+
+  Tournament tournament(config);
+  if (!tournament.run()) {
+    std::cerr << "Error: Unknown bot configuration." << std::endl;
+    return 1;
+  }
+
+  size_t games = tournament.getResults().size();
+  std::cout << "Played " << games << " games in "
+            << tournament.getElapsedMs() << " ms ("
+            << games * 1000.0 / std::max(tournament.getElapsedMs(), 1e-3)
+            << " games/s)" << std::endl;
+  std::cout << std::left << std::setw(4) << "#" << std::setw(32) << "Bot"
+            << std::right << std::setw(7) << "Games" << std::setw(7) << "W"
+            << std::setw(7) << "D" << std::setw(7) << "L" << std::setw(9)
+            << "Elo" << std::setw(9) << "+/-" << std::endl;
+  int rank = 1;
+  for (const RatingRow &row : tournament.ratings()) {
+    std::cout << std::left << std::setw(4) << rank++ << std::setw(32)
+              << config.bots[row.bot] << std::right << std::setw(7)
+              << row.games << std::setw(7) << row.wins << std::setw(7)
+              << row.draws << std::setw(7) << row.losses << std::fixed
+              << std::setprecision(1) << std::setw(9) << row.elo
+              << std::setw(9) << row.eloError << std::defaultfloat
+              << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Solve the rest of a saved game exactly; needs an empty tile bag
+int runEndgameSolver(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle solve <savefile> [bonus] [timeMs]"
+              << std::endl;
+    return 1;
+  }
+
+  EndgameConfig config;
+  if (argc > 3) {
+    config.finishingBonus = std::atoi(argv[3]);
+  }
+  if (argc > 4) {
+    config.timeLimitMs = std::atoi(argv[4]);
+  }
+
+  GameState state;
+  std::string moverName;
+  if (!loadAnalysisState(argv[2], state, moverName)) {
+    return 1;
+  }
+  if (!EndgameSolver::applies(state)) {
+    std::cerr << "Error: The tile bag is not empty yet" << std::endl;
+    return 1;
+  }
+
+  EndgameSolver solver(config);
+  EndgameResult result = solver.solve(state);
+  if (!result.solved) {
+    std::cout << "Not solved within " << config.timeLimitMs
+              << " ms; best guess for " << moverName << ": "
+              << result.move.toCommand() << std::endl;
+    return 1;
+  }
+
+  std::cout << "Best move for " << moverName << ": "
+            << result.move.toCommand() << std::endl;
+  if (result.lineComplete) {
+    std::cout << "Final scores: " << moverName << " " << result.finalScores[0]
+              << ", opponent " << result.finalScores[1] << " (margin "
+              << result.margin << ")" << std::endl;
+  } else {
+    std::cout << "Margin: " << result.margin << " (line cut short)"
+              << std::endl;
+  }
+  std::cout << "Line:";
+  for (const Move &move : result.line) {
+    std::cout << " " << move.toCommand() << ";";
+  }
+  std::cout << std::endl;
+  TranspositionTable &table = TranspositionTable::shared();
+  TableStats stats = table.getStats();
+  std::cout << "Positions: " << result.nodes
+            << ", time: " << result.elapsedMs << " ms" << std::endl;
+  std::cout << "Table: " << table.memoryBytes() / (1024 * 1024) << " MB, "
+            << table.capacity() << " entries, hit rate "
+            << stats.hitRate() * 100 << "%, " << stats.collisions
+            << " collisions" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Generate an opening book offline for use with --book
+int runBookBuilder(int argc, char **argv) {
+  BookConfig config;
+  if (argc > 3) {
+    config.games = std::atoi(argv[3]);
+  }
+  if (argc > 4) {
+    config.plies = std::atoi(argv[4]);
+  }
+  if (argc > 5) {
+    config.iterations = std::atoi(argv[5]);
+  }
+  if (argc < 3 || config.games < 1 || config.plies < 1 ||
+      config.iterations < 1) {
+    std::cerr << "Usage: qwirkle book <outfile> [games] [plies] [iterations]"
+              << std::endl;
+    return 1;
+  }
+
+  BookBuildStats stats;
+  if (!OpeningBook::build(config, argv[2], stats)) {
+    std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << stats.positions << " positions to " << argv[2]
+            << " (" << stats.repeats << " reached by several games) in "
+            << stats.elapsedMs << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Generate the keep/replace table for use with --hands
+int runHandTableBuilder(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle hands <outfile>" << std::endl;
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  int hands = 0;
+  if (!HandTable::build(argv[2], hands)) {
+    std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << "Wrote " << hands << " hands to " << argv[2] << " in "
+            << std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count()
+            << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Append self-play games to a log for 'train'
+int runSelfPlay(int argc, char **argv) {
+  int games = argc > 3 ? std::atoi(argv[3]) : SELFPLAY_DEFAULT_GAMES;
+  std::string bot = argc > 4 ? argv[4] : SELFPLAY_DEFAULT_BOT;
+  uint64_t seed = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : 1;
+  if (argc < 3 || games < 1) {
+    std::cerr << "Usage: qwirkle selfplay <logfile> [games] [bot] [seed]"
+              << std::endl;
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  if (!Trainer::writeSelfPlay(argv[2], bot, games, seed)) {
+    std::cerr << "Error: Unknown bot configuration or unable to write "
+              << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << "Logged " << games << " games of " << bot << " to " << argv[2]
+            << " in "
+            << std::chrono::duration<double, std::milli>(
+                   std::chrono::steady_clock::now() - start)
+                   .count()
+            << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Fit the evaluation weights to a self-play log
+int runTraining(int argc, char **argv) {
+  if (argc < 4) {
+    std::cerr << "Usage: qwirkle train <logfile> <weightsfile>" << std::endl;
+    return 1;
+  }
+
+  Evaluator &evaluator = Evaluator::shared();
+  TrainStats stats;
+  if (!Trainer::train(argv[2], evaluator, stats)) {
+    std::cerr << "Error: No games could be read from " << argv[2]
+              << std::endl;
+    return 1;
+  }
+  if (!evaluator.save(argv[3])) {
+    std::cerr << "Error: Unable to write " << argv[3] << std::endl;
+    return 1;
+  }
+  std::cout << "Trained on " << stats.positions << " positions from "
+            << stats.games << " games; RMS error " << stats.errorBefore
+            << " -> " << stats.errorAfter << std::endl;
+  for (int f = 0; f < EVAL_FEATURES; ++f) {
+    std::cout << "  " << std::left << std::setw(24)
+              << Evaluator::featureName(f) << std::right
+              << evaluator.getWeights()[f] << std::endl;
+  }
+  return EXIT_SUCCESS;
+}
+
+// Time one placement query per position, one position at a time through
+// GameState and all at once through PositionBatch
+int runBatchBenchmark(int argc, char **argv) {
+  int count = argc > 2 ? std::atoi(argv[2]) : 4096;
+  int rounds = argc > 3 ? std::atoi(argv[3]) : 100;
+  if (count < 1 || rounds < 1) {
+    std::cerr << "Usage: qwirkle bench-batch [positions] [rounds]"
+              << std::endl;
+    return 1;
+  }
+
+  // Positions from greedy games, each with a random tile from the hand at
+  // a random cell around the placed tiles
+  PositionBatch batch(DEFAULT_BOARD_SIZE, DEFAULT_BOARD_SIZE, count);
+  std::vector<GameState> positions;
+  std::vector<float> features(static_cast<size_t>(count) * EVAL_FEATURES);
+  std::vector<TileCode> tiles;
+  std::vector<int16_t> rows;
+  std::vector<int16_t> cols;
+  FastRandom random(1);
+  std::vector<Move> scratch;
+  for (uint64_t seed = 1; static_cast<int>(positions.size()) < count;
+       ++seed) {
+    GameState state = GameState::newGame(seed);
+    while (!state.isTerminal() &&
+           static_cast<int>(positions.size()) < count) {
+      const std::vector<TileCode> &hand = state.hands[state.toMove];
+      int top = state.getRows() / 2;
+      int bottom = top;
+      int left = state.getCols() / 2;
+      int right = left;
+      if (!state.isBoardEmpty()) {
+        state.boundingBox(top, bottom, left, right);
+      }
+      tiles.push_back(hand.empty() ? 1 : hand[random.below(hand.size())]);
+      rows.push_back(
+          static_cast<int16_t>(top - 1 + random.below(bottom - top + 3)));
+      cols.push_back(
+          static_cast<int16_t>(left - 1 + random.below(right - left + 3)));
+      Evaluator::extractFeatures(
+          state, &features[positions.size() * EVAL_FEATURES]);
+      positions.push_back(state);
+      batch.add(state);
+      state.applyMove(MctsBot::greedyMove(state, scratch, random));
+    }
+  }
+
+  const Evaluator &evaluator = Evaluator::shared();
+  long checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) {
+    for (int i = 0; i < count; ++i) {
+      const GameState &state = positions[i];
+      const std::vector<TileCode> &hand = state.hands[state.toMove];
+      bool legal =
+          std::find(hand.begin(), hand.end(), tiles[i]) != hand.end() &&
+          state.isValidPlacement(tiles[i], rows[i], cols[i]);
+      int score = legal ? state.scorePlacement(rows[i], cols[i]) : 0;
+      float value = state.scoreMargin(state.toMove) +
+                    evaluator.predict(&features[i * EVAL_FEATURES]);
+      checksum += score + (value > 0.0f ? 1 : 0);
+    }
+  }
+  double serialMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  BatchResults results;
+  start = std::chrono::steady_clock::now();
+  for (int round = 0; round < rounds; ++round) {
+    batch.evaluate(tiles.data(), rows.data(), cols.data(), results);
+    checksum -= results.scores[round % count];
+  }
+  double batchMs = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  double queries = static_cast<double>(count) * rounds;
+  std::cout << "Positions: " << count << ", rounds: " << rounds
+            << " (checksum " << checksum << ")" << std::endl;
+  std::cout << "One at a time: " << serialMs * 1e6 / queries
+            << " ns/position" << std::endl;
+  std::cout << "Batched: " << batchMs * 1e6 / queries << " ns/position"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Play many games in lockstep on one thread and compare the rate with the
+// same games played one at a time on the game objects
+int runLockstepSimulation(int argc, char **argv) {
+  int games = argc > 2 ? std::atoi(argv[2]) : LOCKSTEP_DEFAULT_GAMES;
+  uint64_t seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1;
+  if (games < 1) {
+    std::cerr << "Usage: qwirkle simulate [games] [seed]" << std::endl;
+    return 1;
+  }
+
+  LockstepSimulator simulator(games);
+  auto start = std::chrono::steady_clock::now();
+  simulator.run(seed);
+  double lockstepMs = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+
+  int differences = 0;
+  start = std::chrono::steady_clock::now();
+  for (int game = 0; game < games; ++game) {
+    int scores[2];
+    LockstepSimulator::playObjects(seed + game, scores);
+    if (scores[0] != simulator.score(game, 0) ||
+        scores[1] != simulator.score(game, 1)) {
+      differences++;
+    }
+  }
+  double objectMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  std::cout << "Games: " << games << ", plies: " << simulator.pliesPlayed()
+            << ", differing results: " << differences << std::endl;
+  std::cout << "Lockstep: " << lockstepMs << " ms ("
+            << games * 1000.0 / lockstepMs << " games/s per core)"
+            << std::endl;
+  std::cout << "Game objects: " << objectMs << " ms ("
+            << games * 1000.0 / objectMs << " games/s per core)" << std::endl;
+  return differences == 0 ? EXIT_SUCCESS : 1;
+}
+
+// Rebuild a game from its log and keep playing it, still logged
+int runResume(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle resume <logfile>" << std::endl;
+    return 1;
+  }
+  std::string error;
+  std::unique_ptr<GameEngine> engine(GameLog::replay(argv[2], error));
+  if (!engine) {
+    std::cerr << error << std::endl;
+    return 1;
+  }
+  logPath = argv[2];
+  resumingLog = true;
+  std::cout << "Qwirkle game successfully resumed" << std::endl;
+  gameLoop(*engine);
+  return EXIT_SUCCESS;
+}
+
+// Pack the games of a self-play log into an archive, ids counting from 1
+int runArchiveBuilder(int argc, char **argv) {
+  if (argc < 4) {
+    std::cerr << "Usage: qwirkle archive <archivefile> <logfile> [name1] "
+                 "[name2]"
+              << std::endl;
+    return 1;
+  }
+  std::ifstream in(argv[3]);
+  ArchiveWriter writer;
+  if (!in || !writer.open(argv[2])) {
+    std::cerr << "Error: Unable to read " << argv[3] << " or write "
+              << argv[2] << std::endl;
+    return 1;
+  }
+  ArchivedGame game;
+  game.date = static_cast<int64_t>(time(NULL));
+  game.names[0] = argc > 4 ? argv[4] : "PLAYERONE";
+  game.names[1] = argc > 5 ? argv[5] : "PLAYERTWO";
+  game.id = 0;
+  long logBytes = 0;
+  std::string line;
+  while (std::getline(in, line)) {
+    logBytes += static_cast<long>(line.size()) + 1;
+    if (Trainer::decodeGame(line, game.seed, game.moves)) {
+      game.id++;
+      writer.add(game);
+    }
+  }
+  if (!writer.close()) {
+    std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+    return 1;
+  }
+  ArchiveReader reader;
+  reader.open(argv[2]);
+  std::cout << "Archived " << game.id << " games: " << logBytes
+            << " bytes of log, " << reader.bytes() << " bytes of archive"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Print one archived game, or decode every block and report the rate
+int runLogArchiver(int argc, char **argv) {
+  if (argc < 4) {
+    std::cerr << "Usage: qwirkle archive-logs <archivefile> <gamelog>..."
+              << std::endl;
+    return 1;
+  }
+  ArchiveWriter writer;
+  if (!writer.open(argv[2])) {
+    std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+    return 1;
+  }
+  ArchivedGame game;
+  game.date = static_cast<int64_t>(time(NULL));
+  int failed = 0;
+  for (int i = 3; i < argc; ++i) {
+    std::string error;
+    if (GameLog::toArchive(argv[i], game, error)) {
+      game.id++;
+      writer.add(game);
+    } else {
+      std::cerr << argv[i] << ": " << error << std::endl;
+      failed++;
+    }
+  }
+  if (!writer.close()) {
+    std::cerr << "Error: Unable to write " << argv[2] << std::endl;
+    return 1;
+  }
+  std::cout << "Archived " << game.id << " games, " << failed << " failed"
+            << std::endl;
+  return failed == 0 ? EXIT_SUCCESS : 1;
+}
+
+int runArchiveScan(int argc, char **argv) {
+  if (argc < 3) {
+    std::cerr << "Usage: qwirkle archive-scan <archivefile> [gameid]"
+              << std::endl;
+    return 1;
+  }
+  ArchiveReader reader;
+  if (!reader.open(argv[2])) {
+    std::cerr << "Error: Unable to open archive " << argv[2] << std::endl;
+    return 1;
+  }
+
+  if (argc > 3) {
+    size_t index = 0;
+    ArchivedGame game;
+    if (!reader.find(std::strtoull(argv[3], nullptr, 10), index) ||
+        !reader.readGame(index, game)) {
+      std::cerr << "Error: No game " << argv[3] << " in " << argv[2]
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Game " << game.id << ": " << game.names[0] << " v "
+              << game.names[1];
+    if (game.start.empty()) {
+      std::cout << ", seed " << game.seed << std::endl;
+    } else {
+      std::cout << ", " << (game.enhanced ? "enhanced" : "base")
+                << " rules" << std::endl;
+    }
+    for (const Move &move : game.moves) {
+      std::cout << Trainer::encodeMove(move) << " ";
+    }
+    std::cout << std::endl;
+
+    int scores[2] = {0, 0};
+    if (game.start.empty()) {
+      GameState state = GameState::newGame(game.seed);
+      for (const Move &move : game.moves) {
+        state.applyMove(move);
+      }
+      scores[0] = state.scores[0];
+      scores[1] = state.scores[1];
+    } else {
+      // Engine games replay through the engine, from their own start
+      std::string error;
+      std::unique_ptr<GameEngine> engine(GameLog::replay(game, error));
+      if (!engine) {
+        std::cerr << error << std::endl;
+        return 1;
+      }
+      scores[0] = engine->player(0)->getScore();
+      scores[1] = engine->player(1)->getScore();
+    }
+    std::cout << "Final score " << scores[0] << "-" << scores[1]
+              << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<ArchivedGame> games;
+  long moves = 0;
+  for (size_t block = 0; block < reader.blocks(); ++block) {
+    if (!reader.readBlock(block, games)) {
+      std::cerr << "Error: Block " << block << " is damaged" << std::endl;
+      return 1;
+    }
+    for (const ArchivedGame &game : games) {
+      moves += static_cast<long>(game.moves.size());
+    }
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  std::cout << "Games: " << reader.size() << ", moves: " << moves
+            << ", bytes: " << reader.bytes() << std::endl;
+  std::cout << "Scanned in " << ms << " ms ("
+            << reader.bytes() / 1000.0 / std::max(ms, 1e-3) << " MB/s, "
+            << reader.size() * 1000.0 / std::max(ms, 1e-3) << " games/s)"
+            << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Load every save under the given paths on the thread pool, checking each
+// and, when converting, rewriting it in the other format
+int runBulkLoad(int argc, char **argv, bool convert) {
+  int first = convert ? 3 : 2;
+  std::string format = convert && argc > 2 ? argv[2] : "";
+  if (argc <= first ||
+      (convert && format != "text" && format != "binary")) {
+    std::cerr << (convert ? "Usage: qwirkle convert <text|binary> <path>..."
+                          : "Usage: qwirkle validate <path>...")
+              << std::endl;
+    return 1;
+  }
+  std::vector<std::string> files = BulkLoader::collect(
+      std::vector<std::string>(argv + first, argv + argc));
+  BulkStats stats;
+  std::vector<BulkResult> results = BulkLoader::run(
+      files, convert, format == "binary" ? SAVE_BINARY : SAVE_TEXT, stats);
+  for (const BulkResult &result : results) {
+    if (!result.ok) {
+      std::cerr << result.path << ": " << result.error << std::endl;
+    } else if (!result.warning.empty()) {
+      std::cerr << result.path << ": Warning: " << result.warning
+                << std::endl;
+    }
+  }
+  double seconds = std::max(stats.elapsedMs, 1e-3) / 1000.0;
+  std::cout << (convert ? "Converted " : "Validated ")
+            << stats.files - stats.failed << " of " << stats.files
+            << " saves (" << stats.failed << " failed, " << stats.warned
+            << " with warnings), " << stats.bytes << " bytes in "
+            << stats.elapsedMs << " ms (" << stats.files / seconds
+            << " files/s, " << stats.bytes / 1e6 / seconds << " MB/s)"
+            << std::endl;
+  return stats.failed > 0 ? 1 : EXIT_SUCCESS;
+}